@@ -62,6 +62,8 @@ static struct option long_options[] = { { "help", 0, 0, 'h' },
                                         { "errfile", 1, 0, 'e' },
                                         { "quiet", 0, 0, 'q' },
                                         { "with_checks", 1, 0, 'w' },
+                                        { "threads", 1, 0, 't' },
+                                        { "batch_diffusion", 0, 0, 'b' },
                                         { NULL, 0, 0, 0 } };
 
 /* print_usage: Write the usage message for mcell to a file handle.
@@ -92,6 +94,16 @@ void print_usage(FILE *f, char const *argv0) {
       "for errors\n"
       "     [-with_checks ('yes'/'no', default 'yes')]   performs check of the "
       "geometry for coincident walls\n"
+      "     [-threads n]             run memory partitions on n threads; "
+      "a seeded run\n"
+      "                              gives the same results for any n, "
+      "which match a\n"
+      "                              serial run statistically (default: "
+      "run serially)\n"
+      "     [-batch_diffusion]       step diffusing molecules in batches by "
+      "species;\n"
+      "                              uses random numbers in a different "
+      "order\n"
       "\n");
 }
 
@@ -187,6 +199,22 @@ int argparse_init(int argc, char *const argv[], struct volume *vol) {
       }
       break;
 
+    case 't': /* -threads */
+      vol->num_threads = (int)strtol(optarg, &endptr, 0);
+      if (endptr == optarg || *endptr != '\0') {
+        argerror("Thread count must be an integer: %s", optarg);
+        return 1;
+      }
+      if (vol->num_threads < 1) {
+        argerror("Thread count must be at least 1: %s", optarg);
+        return 1;
+      }
+      break;
+
+    case 'b': /* -batch_diffusion */
+      vol->batch_diffusion = 1;
+      break;
+
     case 'i': /* -iterations */
       vol->iterations = strtoll(optarg, &endptr, 0);
       if (endptr == optarg || *endptr != '\0') {
@@ -44,12 +44,13 @@
 #include "chkpt.h"
 #include "grid_util.h"
 #include "count_util.h"
+#include "init.h"
 #include "react.h"
 #include "macromolecule.h"
 #include "strfunc.h"
 
 /* MCell checkpoint API version */
-#define CHECKPOINT_API 1
+#define CHECKPOINT_API 2
 
 /* Endian-ness markers */
 #define MCELL_BIG_ENDIAN 16
@@ -212,7 +213,8 @@ static int read_current_iteration(struct volume *world, FILE *fs,
 static int read_chkpt_seq_num(struct volume *world, FILE *fs,
                               struct chkpt_read_state *state);
 static int read_rng_state(struct volume *world, FILE *fs,
-                          struct chkpt_read_state *state);
+                          struct chkpt_read_state *state,
+                          uint32_t api_version);
 static int read_byte_order(FILE *fs, struct chkpt_read_state *state);
 static int read_mcell_version(FILE *fs, struct chkpt_read_state *state);
 static int read_api_version(FILE *fs, struct chkpt_read_state *state,
@@ -226,7 +228,8 @@ static int write_current_time_seconds(FILE *fs, double current_time_seconds);
 static int write_current_iteration(FILE *fs, long long current_iterations,
                                    double current_time_seconds);
 static int write_chkpt_seq_num(FILE *fs, u_int chkpt_seq_num);
-static int write_rng_state(FILE *fs, u_int seed_seq, struct rng_state *rng);
+static int write_rng_state(FILE *fs, u_int seed_seq, struct rng_state *rng,
+                           struct storage_list *storage_head);
 static int write_species_table(FILE *fs, int n_species,
                                struct species **species_list);
 static int write_mol_scheduler_state(
@@ -494,7 +497,8 @@ int write_chkpt(struct volume *world, FILE *fs) {
           write_current_iteration(fs, world->current_iterations,
                                   world->current_time_seconds) ||
           write_chkpt_seq_num(fs, world->chkpt_seq_num) ||
-          write_rng_state(fs, world->seed_seq, world->rng) ||
+          write_rng_state(fs, world->seed_seq, world->rng,
+                          world->storage_head) ||
           write_species_table(fs, world->n_species, world->species_list) ||
           write_mol_scheduler_state(fs, world->storage_head,
               world->simulation_start_seconds, world->start_iterations,
@@ -597,7 +601,7 @@ int read_chkpt(struct volume *world, FILE *fs) {
       break;
 
     case RNG_STATE_CMD:
-      if (read_rng_state(world, fs, &state))
+      if (read_rng_state(world, fs, &state, api_version))
         return 1;
       break;
 
@@ -899,10 +903,15 @@ static int write_an_rng_state(FILE *fs, struct rng_state *rng) {
 /***************************************************************************
  write_rng_state:
  In:  fs - checkpoint file to write to.
+      seed_seq - random sequence number
+      rng - main random number generator
+      storage_head - storages, whose random number streams are written
+                     after the main one (if they have them)
  Out: Writes random number generator state to the checkpoint file.
       Returns 1 on error, and 0 - on success.
 ***************************************************************************/
-static int write_rng_state(FILE *fs, u_int seed_seq, struct rng_state *rng) {
+static int write_rng_state(FILE *fs, u_int seed_seq, struct rng_state *rng,
+                           struct storage_list *storage_head) {
   static const char SECTNAME[] = "RNG state";
   static const byte cmd = RNG_STATE_CMD;
 
@@ -910,6 +919,17 @@ static int write_rng_state(FILE *fs, u_int seed_seq, struct rng_state *rng) {
   WRITEUINT(seed_seq);
   if (write_an_rng_state(fs, rng))
     return 1;
+
+  unsigned int n_streams = 0;
+  for (struct storage_list *sl = storage_head; sl != NULL; sl = sl->next) {
+    if (sl->store->rng != NULL)
+      ++n_streams;
+  }
+  WRITEUINT(n_streams);
+  for (struct storage_list *sl = storage_head; sl != NULL; sl = sl->next) {
+    if (sl->store->rng != NULL && write_an_rng_state(fs, sl->store->rng))
+      return 1;
+  }
   return 0;
 }
 
@@ -960,11 +980,13 @@ static int read_an_rng_state(FILE *fs, struct chkpt_read_state *state,
 /***************************************************************************
  read_rng_state:
  In:  fs - checkpoint file to read from.
+      api_version - checkpoint API version of the file
  Out: Reads random number generator state from the checkpoint file.
       Returns 1 on error, and 0 - on success.
 ***************************************************************************/
 static int read_rng_state(struct volume *world, FILE *fs,
-                          struct chkpt_read_state *state) {
+                          struct chkpt_read_state *state,
+                          uint32_t api_version) {
   static const char SECTNAME[] = "RNG state";
 
   /* Load seed_seq from chkpt file to compare with seed_seq from command line.
@@ -980,9 +1002,41 @@ static int read_rng_state(struct volume *world, FILE *fs,
   if (read_an_rng_state(fs, state, world->rng))
     return 1;
 
+  /* Storage streams were added in API version 2.  They are only restored if
+   * this run has the same storages; otherwise they keep their fresh seeds. */
+  unsigned int n_streams = 0;
+  if (api_version >= 2)
+    READUINT(n_streams);
+  unsigned int n_storages = 0;
+  for (struct storage_list *sl = world->storage_head; sl != NULL;
+       sl = sl->next) {
+    if (sl->store->rng != NULL)
+      ++n_storages;
+  }
+  if (n_streams > 0 && n_streams == n_storages) {
+    for (struct storage_list *sl = world->storage_head; sl != NULL;
+         sl = sl->next) {
+      if (sl->store->rng != NULL &&
+          read_an_rng_state(fs, state, sl->store->rng))
+        return 1;
+    }
+  } else if (n_streams > 0) {
+    struct rng_state *skipped = CHECKED_MALLOC_STRUCT(
+        struct rng_state, "checkpointed random number stream");
+    for (unsigned int i = 0; i < n_streams; ++i) {
+      if (read_an_rng_state(fs, state, skipped)) {
+        free(skipped);
+        return 1;
+      }
+    }
+    free(skipped);
+  }
+
   /* Reinitialize rngs to beginning of new seed sequence, if necessary. */
-  if (world->seed_seq != old_seed)
+  if (world->seed_seq != old_seed) {
     rng_init(world->rng, world->seed_seq);
+    seed_storage_rngs(world);
+  }
 
   return 0;
 }
@@ -1108,10 +1162,10 @@ count_items_in_scheduler(struct storage_list *storage_head) {
     for (struct schedule_helper *shp = slp->store->timer; shp != NULL;
          shp = shp->next_scale) {
       for (int i = -1; i < shp->buf_len; i++) {
-        for (struct abstract_element *aep = (i < 0) ? shp->current
-                                                    : shp->circ_buf_head[i];
-             aep != NULL; aep = aep->next) {
-          struct abstract_molecule *amp = (struct abstract_molecule *)aep;
+        struct sched_bucket *slot = schedule_slot(shp, i);
+        for (int k = 0; k < slot->count; k++) {
+          struct abstract_molecule *amp =
+              (struct abstract_molecule *)sched_bucket_item(slot, k);
           if (amp->properties == NULL)
             continue;
 
@@ -1153,10 +1207,10 @@ static int write_mol_scheduler_state_real(FILE *fs,
     for (struct schedule_helper *shp = slp->store->timer; shp != NULL;
          shp = shp->next_scale) {
       for (int i = -1; i < shp->buf_len; i++) {
-        for (struct abstract_element *aep = (i < 0) ? shp->current
-                                                    : shp->circ_buf_head[i];
-             aep != NULL; aep = aep->next) {
-          struct abstract_molecule *amp = (struct abstract_molecule *)aep;
+        struct sched_bucket *slot = schedule_slot(shp, i);
+        for (int k = 0; k < slot->count; k++) {
+          struct abstract_molecule *amp =
+              (struct abstract_molecule *)sched_bucket_item(slot, k);
           if (amp->properties == NULL)
             continue;
 
@@ -1530,6 +1584,7 @@ static int read_mol_scheduler_state_real(struct volume *world, FILE *fs,
             /* Remove the molecule from the grid */
             if (smpPrev->grid->mol[smpPrev->grid_index] == smpPrev) {
               smpPrev->grid->mol[smpPrev->grid_index] = NULL;
+              mark_free_tile(smpPrev->grid, smpPrev->grid_index);
               --smpPrev->grid->n_occupied;
             }
             smpPrev->grid = NULL;
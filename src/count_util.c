@@ -182,6 +182,7 @@ void count_region_update(struct volume *world, struct species *sp,
                    world->length_unit);
   }
 
+  double t_event = (double)world->current_iterations + t;
   struct counter *hit_count = NULL;
   for (; rl != NULL; rl = rl->next) {
     if (rl->reg->flags & COUNT_SOME_MASK) {
@@ -195,51 +196,48 @@ void count_region_update(struct volume *world, struct species *sp,
             if (crossed) {
               if (direction == 1) {
                 if (hit_count->counter_type & TRIG_COUNTER) {
-                  hit_count->data.trig.t_event = (double)world->current_iterations + t;
-                  hit_count->data.trig.orient = 0;
                   if (rl->reg->flags & sp->flags & COUNT_HITS) {
-                    fire_count_event(world, hit_count, 1, loc,
-                                     REPORT_FRONT_HITS | REPORT_TRIGGER);
+                    fire_count_trigger(world, hit_count, t_event, 0, 1, loc,
+                                       REPORT_FRONT_HITS | REPORT_TRIGGER);
 
-                    fire_count_event(world, hit_count, 1, loc,
-                                     REPORT_FRONT_CROSSINGS | REPORT_TRIGGER);
+                    fire_count_trigger(world, hit_count, t_event, 0, 1, loc,
+                                       REPORT_FRONT_CROSSINGS |
+                                           REPORT_TRIGGER);
                   }
                   if (rl->reg->flags & sp->flags & COUNT_CONTENTS) {
-                    fire_count_event(world, hit_count, 1, loc,
-                                     REPORT_ENCLOSED | REPORT_CONTENTS |
-                                         REPORT_TRIGGER);
+                    fire_count_trigger(world, hit_count, t_event, 0, 1, loc,
+                                       REPORT_ENCLOSED | REPORT_CONTENTS |
+                                           REPORT_TRIGGER);
                   }
                 } else {
                   if (rl->reg->flags & sp->flags & COUNT_HITS) {
-                    hit_count->data.move.front_hits++;
-                    hit_count->data.move.front_to_back++;
+                    count_add(world, &hit_count->data.move.front_hits, 1);
+                    count_add(world, &hit_count->data.move.front_to_back, 1);
                   }
                   if (rl->reg->flags & sp->flags & COUNT_CONTENTS) {
-                    hit_count->data.move.n_enclosed++;
+                    count_add_int(world, &hit_count->data.move.n_enclosed, 1);
                   }
                 }
               } else {
                 if (hit_count->counter_type & TRIG_COUNTER) {
-                  hit_count->data.trig.t_event = (double)world->current_iterations + t;
-                  hit_count->data.trig.orient = 0;
                   if (rl->reg->flags & sp->flags & COUNT_HITS) {
-                    fire_count_event(world, hit_count, 1, loc,
-                                     REPORT_BACK_HITS | REPORT_TRIGGER);
-                    fire_count_event(world, hit_count, 1, loc,
-                                     REPORT_BACK_CROSSINGS | REPORT_TRIGGER);
+                    fire_count_trigger(world, hit_count, t_event, 0, 1, loc,
+                                       REPORT_BACK_HITS | REPORT_TRIGGER);
+                    fire_count_trigger(world, hit_count, t_event, 0, 1, loc,
+                                       REPORT_BACK_CROSSINGS | REPORT_TRIGGER);
                   }
                   if (rl->reg->flags & sp->flags & COUNT_CONTENTS) {
-                    fire_count_event(world, hit_count, -1, loc,
-                                     REPORT_ENCLOSED | REPORT_CONTENTS |
-                                         REPORT_TRIGGER);
+                    fire_count_trigger(world, hit_count, t_event, 0, -1, loc,
+                                       REPORT_ENCLOSED | REPORT_CONTENTS |
+                                           REPORT_TRIGGER);
                   }
                 } else {
                   if (rl->reg->flags & sp->flags & COUNT_HITS) {
-                    hit_count->data.move.back_hits++;
-                    hit_count->data.move.back_to_front++;
+                    count_add(world, &hit_count->data.move.back_hits, 1);
+                    count_add(world, &hit_count->data.move.back_to_front, 1);
                   }
                   if (rl->reg->flags & sp->flags & COUNT_CONTENTS) {
-                    hit_count->data.move.n_enclosed--;
+                    count_add_int(world, &hit_count->data.move.n_enclosed, -1);
                   }
                 }
               }
@@ -248,27 +246,24 @@ void count_region_update(struct volume *world, struct species *sp,
             {
               if (direction == 1) {
                 if (hit_count->counter_type & TRIG_COUNTER) {
-                  hit_count->data.trig.t_event = (double)world->current_iterations + t;
-                  hit_count->data.trig.orient = 0;
-                  fire_count_event(world, hit_count, 1, loc,
-                                   REPORT_FRONT_HITS | REPORT_TRIGGER);
+                  fire_count_trigger(world, hit_count, t_event, 0, 1, loc,
+                                     REPORT_FRONT_HITS | REPORT_TRIGGER);
                 } else {
-                  hit_count->data.move.front_hits++;
+                  count_add(world, &hit_count->data.move.front_hits, 1);
                 }
               } else {
                 if (hit_count->counter_type & TRIG_COUNTER) {
-                  hit_count->data.trig.t_event = (double)world->current_iterations + t;
-                  hit_count->data.trig.orient = 0;
-                  fire_count_event(world, hit_count, 1, loc,
-                                   REPORT_BACK_HITS | REPORT_TRIGGER);
+                  fire_count_trigger(world, hit_count, t_event, 0, 1, loc,
+                                     REPORT_BACK_HITS | REPORT_TRIGGER);
                 } else
-                  hit_count->data.move.back_hits++;
+                  count_add(world, &hit_count->data.move.back_hits, 1);
               }
             }
             if ((count_hits && rl->reg->area != 0.0) &&
                 ((sp->flags & NOT_FREE) == 0)) {
               if ((hit_count->counter_type & TRIG_COUNTER) == 0) {
-                hit_count->data.move.scaled_hits += hits_to_ccn / rl->reg->area;
+                count_add(world, &hit_count->data.move.scaled_hits,
+                          hits_to_ccn / rl->reg->area);
               }
             }
           }
@@ -321,53 +316,53 @@ void count_region_border_update(struct volume *world, struct species *sp,
               if (hd->crossed) {
                 if (hd->direction == 1) {
                   if (hit_count->counter_type & TRIG_COUNTER) {
-                    hit_count->data.trig.t_event = hd->t;
-                    hit_count->data.trig.orient = 0;
                     if (rl->reg->flags & sp->flags & COUNT_HITS) {
-                      fire_count_event(world, hit_count, 1, &(hd->loc),
-                                       REPORT_FRONT_HITS | REPORT_TRIGGER);
-                      fire_count_event(world, hit_count, 1, &(hd->loc),
-                                       REPORT_FRONT_CROSSINGS | REPORT_TRIGGER);
+                      fire_count_trigger(world, hit_count, hd->t, 0, 1,
+                                         &(hd->loc),
+                                         REPORT_FRONT_HITS | REPORT_TRIGGER);
+                      fire_count_trigger(world, hit_count, hd->t, 0, 1,
+                                         &(hd->loc),
+                                         REPORT_FRONT_CROSSINGS |
+                                             REPORT_TRIGGER);
                     }
                   } else {
-                    hit_count->data.move.front_hits++;
-                    hit_count->data.move.front_to_back++;
+                    count_add(world, &hit_count->data.move.front_hits, 1);
+                    count_add(world, &hit_count->data.move.front_to_back, 1);
                   }
                 } else {
                   if (hit_count->counter_type & TRIG_COUNTER) {
-                    hit_count->data.trig.t_event = hd->t;
-                    hit_count->data.trig.orient = 0;
                     if (rl->reg->flags & sp->flags & COUNT_HITS) {
-                      fire_count_event(world, hit_count, 1, &(hd->loc),
-                                       REPORT_BACK_HITS | REPORT_TRIGGER);
-                      fire_count_event(world, hit_count, 1, &(hd->loc),
-                                       REPORT_BACK_CROSSINGS | REPORT_TRIGGER);
+                      fire_count_trigger(world, hit_count, hd->t, 0, 1,
+                                         &(hd->loc),
+                                         REPORT_BACK_HITS | REPORT_TRIGGER);
+                      fire_count_trigger(world, hit_count, hd->t, 0, 1,
+                                         &(hd->loc),
+                                         REPORT_BACK_CROSSINGS |
+                                             REPORT_TRIGGER);
                     }
                   } else {
-                    hit_count->data.move.back_hits++;
-                    hit_count->data.move.back_to_front++;
+                    count_add(world, &hit_count->data.move.back_hits, 1);
+                    count_add(world, &hit_count->data.move.back_to_front, 1);
                   }
                 }
               } else /* Didn't cross, only hits might update */
               {
                 if (hd->direction == 1) {
                   if (hit_count->counter_type & TRIG_COUNTER) {
-                    hit_count->data.trig.t_event = hd->t;
-                    hit_count->data.trig.orient = 0;
-                    fire_count_event(world, hit_count, 1, &(hd->loc),
-                                     REPORT_FRONT_HITS | REPORT_TRIGGER);
+                    fire_count_trigger(world, hit_count, hd->t, 0, 1,
+                                       &(hd->loc),
+                                       REPORT_FRONT_HITS | REPORT_TRIGGER);
                   } else {
-                    hit_count->data.move.front_hits++;
+                    count_add(world, &hit_count->data.move.front_hits, 1);
                   }
 
                 } else {
                   if (hit_count->counter_type & TRIG_COUNTER) {
-                    hit_count->data.trig.t_event = hd->t;
-                    hit_count->data.trig.orient = 0;
-                    fire_count_event(world, hit_count, 1, &(hd->loc),
-                                     REPORT_BACK_HITS | REPORT_TRIGGER);
+                    fire_count_trigger(world, hit_count, hd->t, 0, 1,
+                                       &(hd->loc),
+                                       REPORT_BACK_HITS | REPORT_TRIGGER);
                   } else
-                    hit_count->data.move.back_hits++;
+                    count_add(world, &hit_count->data.move.back_hits, 1);
                 }
               }
             }
@@ -453,20 +448,19 @@ void count_region_from_scratch(struct volume *world,
         if (c->target == target && c->reg_type == rl->reg &&
             (c->counter_type & ENCLOSING_COUNTER) == 0) {
           if (c->counter_type & TRIG_COUNTER) {
-            c->data.trig.t_event = t;
-            c->data.trig.orient = orient;
-            fire_count_event(world, c, n, loc, count_flags | REPORT_TRIGGER);
+            fire_count_trigger(world, c, t, orient, n, loc,
+                               count_flags | REPORT_TRIGGER);
           } else if (rxpn == NULL) {
             if (am->properties->flags & ON_GRID) {
               if ((c->orientation == ORIENT_NOT_SET) ||
                   (c->orientation == orient) || (c->orientation == 0)) {
-                c->data.move.n_at += n;
+                count_add_int(world, &c->data.move.n_at, n);
               }
             } else {
-              c->data.move.n_at += n;
+              count_add_int(world, &c->data.move.n_at, n);
             }
           } else
-            c->data.rx.n_rxn_at += n;
+            count_add(world, &c->data.rx.n_rxn_at, n);
         }
       }
     }
@@ -607,21 +601,20 @@ void count_region_from_scratch(struct volume *world,
                (am != NULL && (am->properties->flags & NOT_FREE) == 0) ||
                !region_listed(my_wall->counting_regions, rl->reg))) {
             if (c->counter_type & TRIG_COUNTER) {
-              c->data.trig.t_event = t;
-              c->data.trig.orient = orient;
-              fire_count_event(world, c, n * pos_or_neg, loc,
-                               count_flags | REPORT_TRIGGER);
+              fire_count_trigger(world, c, t, orient, n * pos_or_neg, loc,
+                                 count_flags | REPORT_TRIGGER);
             } else if (rxpn == NULL) {
               if (am->properties->flags & ON_GRID) {
                 if ((c->orientation == ORIENT_NOT_SET) ||
                     (c->orientation == orient) || (c->orientation == 0)) {
-                  c->data.move.n_enclosed += n * pos_or_neg;
+                  count_add_int(world, &c->data.move.n_enclosed,
+                                n * pos_or_neg);
                 }
               } else {
-                c->data.move.n_enclosed += n * pos_or_neg;
+                count_add_int(world, &c->data.move.n_enclosed, n * pos_or_neg);
               }
             } else
-              c->data.rx.n_rxn_enclosed += n * pos_or_neg;
+              count_add(world, &c->data.rx.n_rxn_enclosed, n * pos_or_neg);
           }
         }
       }
@@ -750,13 +743,11 @@ void count_moved_surface_mol(struct volume *world, struct surface_molecule *sm,
         if (c->target == sm->properties && c->reg_type == rl->reg &&
             (c->counter_type & ENCLOSING_COUNTER) == 0) {
           if (c->counter_type & TRIG_COUNTER) {
-            c->data.trig.t_event = sm->t;
-            c->data.trig.orient = sm->orient;
-            fire_count_event(world, c, n, where,
-                             REPORT_CONTENTS | REPORT_TRIGGER);
+            fire_count_trigger(world, c, sm->t, sm->orient, n, where,
+                               REPORT_CONTENTS | REPORT_TRIGGER);
           } else if ((c->orientation == ORIENT_NOT_SET) ||
                      (c->orientation == sm->orient) || (c->orientation == 0)) {
-            c->data.move.n_at += n;
+            count_add_int(world, &c->data.move.n_at, n);
           }
         }
       }
@@ -886,15 +877,13 @@ void count_moved_surface_mol(struct volume *world, struct surface_molecule *sm,
               !region_listed(sm->grid->surface->counting_regions, rl->reg) &&
               !region_listed(sg->surface->counting_regions, rl->reg)) {
             if (c->counter_type & TRIG_COUNTER) {
-              c->data.trig.t_event = sm->t;
-              c->data.trig.orient = sm->orient;
-              fire_count_event(world, c, n, where, REPORT_CONTENTS |
-                                                       REPORT_ENCLOSED |
-                                                       REPORT_TRIGGER);
+              fire_count_trigger(world, c, sm->t, sm->orient, n, where,
+                                 REPORT_CONTENTS | REPORT_ENCLOSED |
+                                     REPORT_TRIGGER);
             } else if ((c->orientation == ORIENT_NOT_SET) ||
                        (c->orientation == sm->orient) ||
                        (c->orientation == 0)) {
-              c->data.move.n_enclosed += n;
+              count_add_int(world, &c->data.move.n_enclosed, n);
             }
           }
         }
@@ -963,6 +952,157 @@ void fire_count_event(struct volume *world, struct counter *event, int n,
   }
 }
 
+/*************************************************************************
+next_count_update:
+  In: world: simulation state, or a worker's copy of it
+  Out: A new entry at the end of the running storage's count updates, or
+       NULL if no storage is running on a worker thread, in which case the
+       caller updates the count directly.
+*************************************************************************/
+static struct count_update *next_count_update(struct volume *world) {
+  struct storage *local = world->active_storage;
+  if (local == NULL)
+    return NULL;
+
+  if (local->n_counts == local->max_counts) {
+    int max_counts = (local->max_counts == 0) ? 64 : 2 * local->max_counts;
+    struct count_update *counts = (struct count_update *)realloc(
+        local->counts, max_counts * sizeof(struct count_update));
+    if (counts == NULL)
+      mcell_allocfailed("Failed to grow the count updates of a memory "
+                        "partition.");
+    local->counts = counts;
+    local->max_counts = max_counts;
+  }
+  return &local->counts[local->n_counts++];
+}
+
+/*************************************************************************
+queue_count_update:
+  In: world: simulation state, or a worker's copy of it
+      kind: what sort of field target is (enum count_update_kind)
+      target: the field to add to
+      n: the amount to add
+  Out: 1 if the update was queued for apply_count_updates, 0 if the caller
+       must make it directly.
+*************************************************************************/
+static int queue_count_update(struct volume *world, byte kind, void *target,
+                              double n) {
+  struct count_update *cu = next_count_update(world);
+  if (cu == NULL)
+    return 0;
+  cu->kind = kind;
+  cu->target = target;
+  cu->value = n;
+  return 1;
+}
+
+/*************************************************************************
+count_add, count_add_int, count_add_uint, count_add_llong:
+  In: world: simulation state, or a worker's copy of it
+      field: a count shared between storages (a counter, reaction or
+             species statistic)
+      n: the amount to add
+  Out: No return value.  The count is updated, or on a worker thread the
+       update is held back until the end of the iteration.
+*************************************************************************/
+void count_add(struct volume *world, double *field, double n) {
+  if (!queue_count_update(world, COUNT_UPDATE_DOUBLE, field, n))
+    *field += n;
+}
+
+void count_add_int(struct volume *world, int *field, int n) {
+  if (!queue_count_update(world, COUNT_UPDATE_INT, field, n))
+    *field += n;
+}
+
+void count_add_uint(struct volume *world, u_int *field, int n) {
+  if (!queue_count_update(world, COUNT_UPDATE_UINT, field, n))
+    *field += n;
+}
+
+void count_add_llong(struct volume *world, long long *field, long long n) {
+  if (!queue_count_update(world, COUNT_UPDATE_LLONG, field, (double)n))
+    *field += n;
+}
+
+/*************************************************************************
+fire_count_trigger:
+  In: world: simulation state, or a worker's copy of it
+      event: trigger counter of the thing that just happened
+      t_event: when it happened
+      orient: orientation of the molecule involved
+      n: number of times it happened (or hit direction)
+      where: location where it happened
+      what: what happened (Report Type Flags)
+  Out: No return value.  The trigger is fired through fire_count_event, or
+       on a worker thread held back until the end of the iteration.
+*************************************************************************/
+void fire_count_trigger(struct volume *world, struct counter *event,
+                        double t_event, short orient, int n,
+                        struct vector3 *where, byte what) {
+  struct count_update *cu = next_count_update(world);
+  if (cu == NULL) {
+    event->data.trig.t_event = t_event;
+    event->data.trig.orient = orient;
+    fire_count_event(world, event, n, where, what);
+    return;
+  }
+
+  cu->kind = COUNT_UPDATE_TRIGGER;
+  cu->target = event;
+  cu->value = t_event;
+  cu->orient = orient;
+  cu->n = n;
+  cu->what = what;
+  if (where != NULL)
+    cu->loc = *where;
+  else
+    cu->loc.x = cu->loc.y = cu->loc.z = 0.0;
+}
+
+/*************************************************************************
+apply_count_updates:
+  In: world: simulation state
+      local: a storage
+  Out: No return value.  The count updates held back while the storage ran
+       on a worker thread are made, in the order the storage made them, and
+       the storage's list of updates is emptied.
+*************************************************************************/
+void apply_count_updates(struct volume *world, struct storage *local) {
+  for (int i = 0; i < local->n_counts; i++) {
+    struct count_update *cu = &local->counts[i];
+    switch (cu->kind) {
+    case COUNT_UPDATE_DOUBLE:
+      *(double *)cu->target += cu->value;
+      break;
+
+    case COUNT_UPDATE_INT:
+      *(int *)cu->target += (int)cu->value;
+      break;
+
+    case COUNT_UPDATE_UINT:
+      *(u_int *)cu->target += (int)cu->value;
+      break;
+
+    case COUNT_UPDATE_LLONG:
+      *(long long *)cu->target += (long long)cu->value;
+      break;
+
+    case COUNT_UPDATE_TRIGGER: {
+      struct counter *event = (struct counter *)cu->target;
+      event->data.trig.t_event = cu->value;
+      event->data.trig.orient = cu->orient;
+      fire_count_event(world, event, cu->n, &cu->loc, cu->what);
+    } break;
+
+    default:
+      UNHANDLED_CASE(cu->kind);
+    }
+  }
+  local->n_counts = 0;
+}
+
 /*************************************************************************
 find_enclosing_regions:
    In: location we want to end up
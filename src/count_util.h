@@ -49,6 +49,17 @@ void count_moved_surface_mol(struct volume *world, struct surface_molecule *sm,
 void fire_count_event(struct volume *world, struct counter *event, int n,
                       struct vector3 *where, byte what);
 
+void count_add(struct volume *world, double *field, double n);
+void count_add_int(struct volume *world, int *field, int n);
+void count_add_uint(struct volume *world, u_int *field, int n);
+void count_add_llong(struct volume *world, long long *field, long long n);
+
+void fire_count_trigger(struct volume *world, struct counter *event,
+                        double t_event, short orient, int n,
+                        struct vector3 *where, byte what);
+
+void apply_count_updates(struct volume *world, struct storage *local);
+
 int place_waypoints(struct volume *world);
 
 int prepare_counters(struct volume *world);
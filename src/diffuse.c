@@ -37,6 +37,7 @@
 #include "wall_util.h"
 #include "react.h"
 #include "macromolecule.h"
+#include "thread_util.h"
 
 /*************************************************************************
 pick_2d_displacement:
@@ -213,6 +214,21 @@ void pick_release_displacement(struct vector3 *in_disk, struct vector3 *away,
   away->z *= r;
 }
 
+/*************************************************************************
+displacement_from_gauss:
+  In: v: vector3 to store the new displacement
+      scale: scale factor to apply to the displacement
+      g: three Gaussian variates (mean 0, variance 1)
+  Out: No return value.  v holds the displacement pick_displacement makes
+       from the same variates.
+*************************************************************************/
+static void displacement_from_gauss(struct vector3 *v, double scale,
+                                    double const *g) {
+  v->x = scale * g[0] * .70710678118654752440;
+  v->y = scale * g[1] * .70710678118654752440;
+  v->z = scale * g[2] * .70710678118654752440;
+}
+
 /*************************************************************************
 pick_displacement:
   In: vector3 to store the new displacement
@@ -222,9 +238,9 @@ pick_displacement:
          3D molecule, scaled by the scaling factor.
 *************************************************************************/
 void pick_displacement(struct vector3 *v, double scale, struct rng_state *rng) {
-  v->x = scale * rng_gauss(rng) * .70710678118654752440;
-  v->y = scale * rng_gauss(rng) * .70710678118654752440;
-  v->z = scale * rng_gauss(rng) * .70710678118654752440;
+  double g[3];
+  rng_gauss_batch(rng, g, 3);
+  displacement_from_gauss(v, scale, g);
 }
 
 /*************************************************************************
@@ -332,9 +348,8 @@ struct wall *ray_trace_2d(struct volume *world, struct surface_molecule *sm,
                                                 sm)) {
 
         num_matching_rxns = trigger_intersect(
-            world->reaction_hash, world->rx_hashsize, world->all_mols,
-            world->all_volume_mols, world->all_surface_mols,
-            sm->properties->hashval, (struct abstract_molecule *)sm, sm->orient,
+            &world->rxn_pairs, world->all_mols, world->all_volume_mols,
+            world->all_surface_mols, (struct abstract_molecule *)sm, sm->orient,
             this_wall, matching_rxns, 1, 1, 1);
 
         /* check if this wall has any reflective or absorptive region
@@ -406,9 +421,8 @@ struct wall *ray_trace_2d(struct volume *world, struct surface_molecule *sm,
           reflect_now = 0;
           absorb_now = 0;
           num_matching_rxns = trigger_intersect(
-              world->reaction_hash, world->rx_hashsize, world->all_mols,
-              world->all_volume_mols, world->all_surface_mols,
-              sm->properties->hashval, (struct abstract_molecule *)sm,
+              &world->rxn_pairs, world->all_mols, world->all_volume_mols,
+              world->all_surface_mols, (struct abstract_molecule *)sm,
               sm->orient, target_wall, matching_rxns, 1, 1, 1);
 
           for (int i = 0; i < num_matching_rxns; i++) {
@@ -535,6 +549,151 @@ struct wall *ray_trace_2d(struct volume *world, struct surface_molecule *sm,
   return NULL;
 }
 
+/*************************************************************************
+move_stays_in_subvolume:
+  In: world: simulation state
+      sv: subvolume that we start in
+      pos: position of molecule that is moving
+      v: displacement vector from current to new location
+  Out: 1 if the move certainly ends inside the subvolume, so that ray_trace
+       would find no subvolume wall within the move, 0 otherwise.
+  Note: Each nonzero coordinate of the move is compared with the distance
+        to the face it heads for, the same distances ray_trace divides by.
+        A move that just reaches a face gives 0 even where ray_trace's
+        rounded quotient would not count it as a crossing.
+*************************************************************************/
+static int move_stays_in_subvolume(struct volume *world, struct subvolume *sv,
+                                   struct vector3 const *pos,
+                                   struct vector3 const *v) {
+  if (v->x < 0.0) {
+    if (world->x_fineparts[sv->llf.x] - pos->x > v->x)
+      return 0;
+  } else if (v->x > 0.0) {
+    if (world->x_fineparts[sv->urb.x] - pos->x < v->x)
+      return 0;
+  }
+
+  if (v->y < 0.0) {
+    if (world->y_fineparts[sv->llf.y] - pos->y > v->y)
+      return 0;
+  } else if (v->y > 0.0) {
+    if (world->y_fineparts[sv->urb.y] - pos->y < v->y)
+      return 0;
+  }
+
+  if (v->z < 0.0) {
+    if (world->z_fineparts[sv->llf.z] - pos->z > v->z)
+      return 0;
+  } else if (v->z > 0.0) {
+    if (world->z_fineparts[sv->urb.z] - pos->z < v->z)
+      return 0;
+  }
+
+  return 1;
+}
+
+/*************************************************************************
+make_free_move:
+  In: world: simulation state
+      vm: molecule that is moving
+      v: displacement vector from current to new location
+      t_steps: time the move takes
+  Out: No return value.  The molecule is moved and its time advanced just
+       as diffuse_3D would after a ray_trace that hits nothing.
+  Note: Only for a move that move_stays_in_subvolume accepts and that
+        walls_along_ray finds no walls for.
+*************************************************************************/
+static void make_free_move(struct volume *world, struct volume_molecule *vm,
+                           struct vector3 const *v, double t_steps) {
+  world->ray_voxel_tests++;
+  vm->pos.x += v->x;
+  vm->pos.y += v->y;
+  vm->pos.z += v->z;
+  update_packed_position(vm);
+  vm->t += t_steps;
+  vm->index = -1;
+  vm->previous_wall = NULL;
+}
+
+/*************************************************************************
+collision_vector_init:
+  In: cv: collision vector
+  Out: No return value.  The vector is empty and uses its inline storage.
+*************************************************************************/
+void collision_vector_init(struct collision_vector *cv) {
+  cv->n_items = 0;
+  cv->max_items = COLLISION_VECTOR_INLINE;
+  cv->items = cv->inline_items;
+}
+
+/*************************************************************************
+collision_vector_free:
+  In: cv: collision vector
+  Out: No return value.  Any heap memory the vector grew into is freed,
+       and the vector is empty again.
+*************************************************************************/
+void collision_vector_free(struct collision_vector *cv) {
+  if (cv->items != cv->inline_items)
+    free(cv->items);
+  collision_vector_init(cv);
+}
+
+/*************************************************************************
+next_collision:
+  In: cv: collision vector
+  Out: Pointer to a new collision at the end of the vector.
+  Note: Growing the vector moves its collisions, so pointers to them and
+        their next fields are only good once the vector is complete.
+*************************************************************************/
+static struct collision *next_collision(struct collision_vector *cv) {
+  if (cv->n_items == cv->max_items) {
+    int max_items = 2 * cv->max_items;
+    struct collision *items;
+    if (cv->items == cv->inline_items) {
+      items = malloc(max_items * sizeof(struct collision));
+      if (items != NULL)
+        memcpy(items, cv->items, cv->n_items * sizeof(struct collision));
+    } else
+      items = realloc(cv->items, max_items * sizeof(struct collision));
+    if (items == NULL)
+      mcell_allocfailed("Failed to grow collision vector.");
+    cv->items = items;
+    cv->max_items = max_items;
+  }
+  return &cv->items[cv->n_items++];
+}
+
+/*************************************************************************
+sort_collisions:
+  In: cv: collision vector
+  Out: The collisions, sorted by time and linked through their next
+       fields, or NULL if there are none.
+  Note: Collisions at the same time come out latest-added first.  This is
+        the order ae_list_sort used to give the list ray_trace built by
+        adding each collision at its head, so collisions are handled in
+        the same order as before.
+*************************************************************************/
+static struct collision *sort_collisions(struct collision_vector *cv) {
+  struct collision *items = cv->items;
+  int n = cv->n_items;
+  if (n == 0)
+    return NULL;
+
+  /* Insertion sort on t, taking items from the last added to the first */
+  for (int i = n - 2; i >= 0; i--) {
+    struct collision c = items[i];
+    int j = i + 1;
+    for (; j < n && items[j].t <= c.t; j++)
+      items[j - 1] = items[j];
+    items[j - 1] = c;
+  }
+
+  for (int i = 0; i < n - 1; i++)
+    items[i].next = &items[i + 1];
+  items[n - 1].next = NULL;
+  return items;
+}
+
 /*************************************************************************
 ray_trace:
   In: world: simulation state
@@ -543,38 +702,42 @@ ray_trace:
       sv: subvolume that we start in
       v: displacement vector from current to new location
       reflectee: wall we have reflected off of and should not hit again
+      hits: vector to store the collisions in (its old contents are
+            dropped)
   Out: collision list of walls and molecules we intersected along our ray
-       (current subvolume only), plus the subvolume wall.  Will always
-       return at least the subvolume wall--NULL indicates an out of
-       memory error.
+       (current subvolume only), plus the subvolume wall, sorted by time.
+       Will always return at least the subvolume wall.  The list lives in
+       hits, so it is good until hits is next used or freed.
 *************************************************************************/
 struct collision *ray_trace(struct volume *world, struct vector3 *init_pos,
                             struct collision *c, struct subvolume *sv,
-                            struct vector3 *v, struct wall *reflectee) {
+                            struct vector3 *v, struct wall *reflectee,
+                            struct collision_vector *hits) {
   /* time, in units of of the molecule's time step, at which molecule
      will cross the x,y,z partitions, respectively. */
   double tx, ty, tz;
 
   world->ray_voxel_tests++;
 
-  struct collision *shead = NULL;
-  struct collision *smash = (struct collision *)CHECKED_MEM_GET(
-      sv->local_storage->coll, "collision structure");
+  hits->n_items = 0;
+  struct collision *smash = next_collision(hits);
 
   struct wall_list fake_wlp;
-  fake_wlp.next = sv->wall_head;
 
   // Check wall collisions
-  for (struct wall_list *wlp = sv->wall_head; wlp != NULL; wlp = wlp->next) {
+  for (struct wall_list *wlp =
+           walls_along_ray(world, sv, init_pos, v, reflectee);
+       wlp != NULL; wlp = wlp->next) {
     if (wlp->this_wall == reflectee)
       continue;
 
     int i = collide_wall(init_pos, v, wlp->this_wall, &(smash->t), &(smash->loc),
                      1, world->rng, world->notify, &(world->ray_polygon_tests));
     if (i == COLLIDE_REDO) {
-      if (shead != NULL)
-        mem_put_list(sv->local_storage->coll, shead);
-      shead = NULL;
+      hits->n_items = 0;
+      smash = next_collision(hits);
+      /* The move has changed, so start over with its walls */
+      fake_wlp.next = walls_along_ray(world, sv, init_pos, v, reflectee);
       wlp = &fake_wlp;
       continue;
     } else if (i != COLLIDE_MISS) {
@@ -582,10 +745,7 @@ struct collision *ray_trace(struct volume *world, struct vector3 *init_pos,
 
       smash->what = COLLIDE_WALL + i;
       smash->target = (void *)wlp->this_wall;
-      smash->next = shead;
-      shead = smash;
-      smash = (struct collision *)CHECKED_MEM_GET(sv->local_storage->coll,
-                                                  "collision structure");
+      smash = next_collision(hits);
     }
   }
 
@@ -704,8 +864,6 @@ struct collision *ray_trace(struct volume *world, struct vector3 *init_pos,
   smash->loc.z = init_pos->z + smash->t * v->z;
 
   smash->target = sv;
-  smash->next = shead;
-  shead = smash;
 
   // Check molecule collisions
   for (; c != NULL; c = c->next) {
@@ -715,18 +873,14 @@ struct collision *ray_trace(struct volume *world, struct vector3 *init_pos,
 
     i = collide_mol(init_pos, v, a, &(c->t), &(c->loc), world->rx_radius_3d);
     if (i != COLLIDE_MISS) {
-      smash = (struct collision *)CHECKED_MEM_GET(sv->local_storage->coll,
-                                                  "collision structure");
+      smash = next_collision(hits);
       memcpy(smash, c, sizeof(struct collision));
 
       smash->what = COLLIDE_VOL + i;
-
-      smash->next = shead;
-      shead = smash;
     }
   }
 
-  return shead;
+  return sort_collisions(hits);
 }
 
 /******************************/
@@ -1050,9 +1204,8 @@ double exact_disk(struct volume *world, struct vector3 *loc, struct vector3 *mv,
     /* Reject those that the moving particle can travel through */
     if ((moving->properties->flags & CAN_VOLWALL) != 0) {
       num_matching_rxns = trigger_intersect(
-          world->reaction_hash, world->rx_hashsize, world->all_mols,
-          world->all_volume_mols, world->all_surface_mols,
-          moving->properties->hashval, (struct abstract_molecule *)moving, 0, w,
+          &world->rxn_pairs, world->all_mols, world->all_volume_mols,
+          world->all_surface_mols, (struct abstract_molecule *)moving, 0, w,
           matching_rxns, 1, 1, 0);
       if (num_matching_rxns == 0)
         continue;
@@ -1822,7 +1975,9 @@ safe_diffusion_step:
         reacting, although those 1% will probably not go in the right
         direction).  This doesn't take into account the diffusion of other
         target molecules, so it may introduce errors for clouds of molecules
-        diffusing into each other from a distance.
+        diffusing into each other from a distance.  The distance to the
+        walls comes from the subvolume's wall_field, a lower bound that
+        depends only on which cell of the field the molecule is in.
         *FIXME*: Add a flag to make this be very conservative or to turn
         this off entirely, aside from the TIME_STEP_MAX= directive.
 ****************************************************************************/
@@ -1834,8 +1989,6 @@ double safe_diffusion_step(struct volume_molecule *vm, struct collision *shead,
   double d2_nearmax;
   double d2min = GIGANTIC;
   struct subvolume *sv = vm->subvol;
-  struct wall *w;
-  struct wall_list *wl;
   struct collision *smash;
   double steps;
   struct volume_molecule *mp;
@@ -1854,12 +2007,8 @@ double safe_diffusion_step(struct volume_molecule *vm, struct collision *shead,
         d2min = d2;
     }
   }
-  for (wl = sv->wall_head; wl != NULL; wl = wl->next) {
-    w = wl->this_wall;
-    d2 = (w->normal.x * vm->pos.x + w->normal.y * vm->pos.y +
-          w->normal.z * vm->pos.z) -
-         w->d;
-    d2 *= d2;
+  if (sv->wall_field != NULL) {
+    d2 = wall_field_distance2(sv->wall_field, &vm->pos);
     if (d2 < d2min)
       d2min = d2;
   }
@@ -1932,8 +2081,7 @@ expand_collision_list_for_neighbor:
       x_fineparts:
       y_fineparts:
       z_fineparts:
-      rx_hashsize:
-      reaction_hash:
+      rxn_pairs: table of reactions by pair of species
   Out: Returns linked list of molecules from neighbor subvolumes
        that are located within "interaction_radius" from the the subvolume
        border.
@@ -1945,7 +2093,7 @@ static struct collision *expand_collision_list_for_neighbor(
     struct vector3 *path_llf, struct vector3 *path_urb,
     struct collision *shead1, double trim_x, double trim_y, double trim_z,
     double *x_fineparts, double *y_fineparts, double *z_fineparts,
-    int rx_hashsize, struct rxn **reaction_hash) {
+    struct rxn_pair_table const *rxn_pairs) {
   int num_matching_rxns = 0;
   struct rxn *matching_rxns[MAX_MATCHING_RXNS];
 
@@ -1997,6 +2145,9 @@ static struct collision *expand_collision_list_for_neighbor(
     z_max = new_sv_urb.z + EPS_C;
   }
 
+  struct vector3 box_llf = { x_min, y_min, z_min };
+  struct vector3 box_urb = { x_max, y_max, z_max };
+
   /* scan molecules from this SV */
   struct per_species_list *psl_next, *psl, **psl_head = &new_sv->species_head;
   for (psl = new_sv->species_head; psl != NULL; psl = psl_next) {
@@ -2010,48 +2161,46 @@ static struct collision *expand_collision_list_for_neighbor(
     if (psl->head == NULL) {
       *psl_head = psl->next;
       ht_remove(&new_sv->mol_by_species, psl);
-      mem_put(new_sv->local_storage->pslv, psl);
+      collect_species_list(new_sv->local_storage, psl);
       continue;
     } else
       psl_head = &psl->next;
 
     /* no possible reactions. skip it. */
-    if (!trigger_bimolecular_preliminary(
-             reaction_hash, rx_hashsize, vm->properties->hashval,
-             psl->properties->hashval, vm->properties, psl->properties))
+    if (!trigger_bimolecular_preliminary(rxn_pairs, vm->properties,
+                                         psl->properties))
       continue;
 
-    for (struct volume_molecule *mp = psl->head; mp != NULL; mp = mp->next_v) {
-      /* Skip defunct molecules */
-      if (mp->properties == NULL)
-        continue;
+    /* skip molecules outside the region of interest, looking only at the
+       packed coordinates */
+    for (int first = 0; first < psl->n_mols; first += MOLECULE_SCAN_CHUNK) {
+      int hits[MOLECULE_SCAN_CHUNK];
+      int n_hits = molecules_in_box(psl, first, &box_llf, &box_urb, hits);
+      for (int h = 0; h < n_hits; h++) {
+        struct volume_molecule *mp = psl->mols[hits[h]];
 
-      /* skip molecules outside the region of interest */
-      if (mp->pos.x < x_min || mp->pos.x > x_max)
-        continue;
-      if (mp->pos.y < y_min || mp->pos.y > y_max)
-        continue;
-      if (mp->pos.z < z_min || mp->pos.z > z_max)
-        continue;
+        /* Skip defunct molecules */
+        if (mp->properties == NULL)
+          continue;
 
-      /* check for possible reactions */
-      num_matching_rxns = trigger_bimolecular(
-          reaction_hash, rx_hashsize, vm->properties->hashval,
-          mp->properties->hashval, (struct abstract_molecule *)vm,
-          (struct abstract_molecule *)mp, 0, 0, matching_rxns);
-      if (num_matching_rxns <= 0)
-        continue;
+        /* check for possible reactions */
+        num_matching_rxns = trigger_bimolecular(
+            rxn_pairs, (struct abstract_molecule *)vm,
+            (struct abstract_molecule *)mp, 0, 0, matching_rxns);
+        if (num_matching_rxns <= 0)
+          continue;
 
-      /* Add a collision for each matching reaction */
-      for (int i = 0; i < num_matching_rxns; i++) {
-        struct collision *smash = (struct collision *)CHECKED_MEM_GET(
-            sv->local_storage->coll, "collision data");
-        smash->target = (void *)mp;
-        smash->intermediate = matching_rxns[i];
-        smash->next = shead1;
-        smash->what = 0;
-        smash->what |= COLLIDE_VOL;
-        shead1 = smash;
+        /* Add a collision for each matching reaction */
+        for (int i = 0; i < num_matching_rxns; i++) {
+          struct collision *smash = (struct collision *)CHECKED_MEM_GET(
+              sv->local_storage->coll, "collision data");
+          smash->target = (void *)mp;
+          smash->intermediate = matching_rxns[i];
+          smash->next = shead1;
+          smash->what = 0;
+          smash->what |= COLLIDE_VOL;
+          shead1 = smash;
+        }
       }
     }
   }
@@ -2079,8 +2228,8 @@ static struct collision *
 expand_collision_list(struct volume_molecule *vm, struct vector3 *mv,
                       struct subvolume *sv, double rx_radius_3d,
                       int ny_parts, int nz_parts, double *x_fineparts,
-                      double *y_fineparts, double *z_fineparts, int rx_hashsize,
-                      struct rxn **reaction_hash) {
+                      double *y_fineparts, double *z_fineparts,
+                      struct rxn_pair_table const *rxn_pairs) {
   struct collision *shead1 = NULL;
   /* neighbors of the current subvolume */
   struct vector3 path_llf, path_urb;
@@ -2109,26 +2258,26 @@ expand_collision_list(struct volume_molecule *vm, struct vector3 *mv,
     struct subvolume *new_sv = sv + (nz_parts - 1) * (ny_parts - 1);
     shead1 = expand_collision_list_for_neighbor(
         sv, vm, new_sv, &path_llf, &path_urb, shead1, R, 0.0, 0.0, x_fineparts,
-        y_fineparts, z_fineparts, rx_hashsize, reaction_hash);
+        y_fineparts, z_fineparts, rxn_pairs);
 
     /* go +X, +Y) */
     if (y_pos) {
       struct subvolume *new_sv_y = new_sv + (nz_parts - 1);
       shead1 = expand_collision_list_for_neighbor(
           sv, vm, new_sv_y, &path_llf, &path_urb, shead1, R, R, 0.0, x_fineparts,
-          y_fineparts, z_fineparts, rx_hashsize, reaction_hash);
+          y_fineparts, z_fineparts, rxn_pairs);
 
       /* go +X, +Y, +Z) */
       if (z_pos)
         shead1 = expand_collision_list_for_neighbor(
             sv, vm, new_sv_y + 1, &path_llf, &path_urb, shead1, R, R, R,
-            x_fineparts, y_fineparts, z_fineparts, rx_hashsize, reaction_hash);
+            x_fineparts, y_fineparts, z_fineparts, rxn_pairs);
 
       /* go +X, +Y, -Z */
       if (z_neg)
         shead1 = expand_collision_list_for_neighbor(
             sv, vm, new_sv_y - 1, &path_llf, &path_urb, shead1, R, R, -R,
-            x_fineparts, y_fineparts, z_fineparts, rx_hashsize, reaction_hash);
+            x_fineparts, y_fineparts, z_fineparts, rxn_pairs);
     }
 
     /* go +X, -Y) */
@@ -2136,32 +2285,32 @@ expand_collision_list(struct volume_molecule *vm, struct vector3 *mv,
       struct subvolume *new_sv_y = new_sv - (nz_parts - 1);
       shead1 = expand_collision_list_for_neighbor(
           sv, vm, new_sv_y, &path_llf, &path_urb, shead1, R, -R, 0.0,
-          x_fineparts, y_fineparts, z_fineparts, rx_hashsize, reaction_hash);
+          x_fineparts, y_fineparts, z_fineparts, rxn_pairs);
 
       /* go +X, -Y, +Z) */
       if (z_pos)
         shead1 = expand_collision_list_for_neighbor(
             sv, vm, new_sv_y + 1, &path_llf, &path_urb, shead1, R, -R, R,
-            x_fineparts, y_fineparts, z_fineparts, rx_hashsize, reaction_hash);
+            x_fineparts, y_fineparts, z_fineparts, rxn_pairs);
 
       /* go +X, -Y, -Z */
       if (z_neg)
         shead1 = expand_collision_list_for_neighbor(
             sv, vm, new_sv_y - 1, &path_llf, &path_urb, shead1, R, -R, -R,
-            x_fineparts, y_fineparts, z_fineparts, rx_hashsize, reaction_hash);
+            x_fineparts, y_fineparts, z_fineparts, rxn_pairs);
     }
 
     /* go +X, +Z) */
     if (z_pos)
       shead1 = expand_collision_list_for_neighbor(
           sv, vm, new_sv + 1, &path_llf, &path_urb, shead1, R, 0.0, R,
-          x_fineparts, y_fineparts, z_fineparts, rx_hashsize, reaction_hash);
+          x_fineparts, y_fineparts, z_fineparts, rxn_pairs);
 
     /* go +X, -Z */
     if (z_neg)
       shead1 = expand_collision_list_for_neighbor(
           sv, vm, new_sv - 1, &path_llf, &path_urb, shead1, R, 0.0, -R,
-          x_fineparts, y_fineparts, z_fineparts, rx_hashsize, reaction_hash);
+          x_fineparts, y_fineparts, z_fineparts, rxn_pairs);
   }
 
   /* go in the direction X_NEG */
@@ -2169,26 +2318,26 @@ expand_collision_list(struct volume_molecule *vm, struct vector3 *mv,
     struct subvolume *new_sv = sv - (nz_parts - 1) * (ny_parts - 1);
     shead1 = expand_collision_list_for_neighbor(
         sv, vm, new_sv, &path_llf, &path_urb, shead1, -R, 0.0, 0.0, x_fineparts,
-        y_fineparts, z_fineparts, rx_hashsize, reaction_hash);
+        y_fineparts, z_fineparts, rxn_pairs);
 
     /* go -X, +Y) */
     if (y_pos) {
       struct subvolume *new_sv_y = new_sv + (nz_parts - 1);
       shead1 = expand_collision_list_for_neighbor(
           sv, vm, new_sv_y, &path_llf, &path_urb, shead1, -R, R, 0.0,
-          x_fineparts, y_fineparts, z_fineparts, rx_hashsize, reaction_hash);
+          x_fineparts, y_fineparts, z_fineparts, rxn_pairs);
 
       /* go -X, +Y, +Z) */
       if (z_pos)
         shead1 = expand_collision_list_for_neighbor(
             sv, vm, new_sv_y + 1, &path_llf, &path_urb, shead1, -R, R, R,
-            x_fineparts, y_fineparts, z_fineparts, rx_hashsize, reaction_hash);
+            x_fineparts, y_fineparts, z_fineparts, rxn_pairs);
 
       /* go -X, +Y, -Z */
       if (z_neg)
         shead1 = expand_collision_list_for_neighbor(
             sv, vm, new_sv_y - 1, &path_llf, &path_urb, shead1, -R, R, -R,
-            x_fineparts, y_fineparts, z_fineparts, rx_hashsize, reaction_hash);
+            x_fineparts, y_fineparts, z_fineparts, rxn_pairs);
     }
 
     /* go -X, -Y) */
@@ -2196,32 +2345,32 @@ expand_collision_list(struct volume_molecule *vm, struct vector3 *mv,
       struct subvolume *new_sv_y = new_sv - (nz_parts - 1);
       shead1 = expand_collision_list_for_neighbor(
           sv, vm, new_sv_y, &path_llf, &path_urb, shead1, -R, -R, 0.0,
-          x_fineparts, y_fineparts, z_fineparts, rx_hashsize, reaction_hash);
+          x_fineparts, y_fineparts, z_fineparts, rxn_pairs);
 
       /* go -X, -Y, +Z) */
       if (z_pos)
         shead1 = expand_collision_list_for_neighbor(
             sv, vm, new_sv_y + 1, &path_llf, &path_urb, shead1, -R, -R, R,
-            x_fineparts, y_fineparts, z_fineparts, rx_hashsize, reaction_hash);
+            x_fineparts, y_fineparts, z_fineparts, rxn_pairs);
 
       /* go -X, -Y, -Z */
       if (z_neg)
         shead1 = expand_collision_list_for_neighbor(
             sv, vm, new_sv_y - 1, &path_llf, &path_urb, shead1, -R, -R, -R,
-            x_fineparts, y_fineparts, z_fineparts, rx_hashsize, reaction_hash);
+            x_fineparts, y_fineparts, z_fineparts, rxn_pairs);
     }
 
     /* go -X, +Z) */
     if (z_pos)
       shead1 = expand_collision_list_for_neighbor(
           sv, vm, new_sv + 1, &path_llf, &path_urb, shead1, -R, 0.0, R,
-          x_fineparts, y_fineparts, z_fineparts, rx_hashsize, reaction_hash);
+          x_fineparts, y_fineparts, z_fineparts, rxn_pairs);
 
     /* go -X, -Z */
     if (z_neg)
       shead1 = expand_collision_list_for_neighbor(
           sv, vm, new_sv - 1, &path_llf, &path_urb, shead1, -R, 0.0, -R,
-          x_fineparts, y_fineparts, z_fineparts, rx_hashsize, reaction_hash);
+          x_fineparts, y_fineparts, z_fineparts, rxn_pairs);
   }
 
   /* go in the direction Y_POS */
@@ -2229,19 +2378,19 @@ expand_collision_list(struct volume_molecule *vm, struct vector3 *mv,
     struct subvolume *new_sv = sv + (nz_parts - 1);
     shead1 = expand_collision_list_for_neighbor(
         sv, vm, new_sv, &path_llf, &path_urb, shead1, 0.0, R, 0.0, x_fineparts,
-        y_fineparts, z_fineparts, rx_hashsize, reaction_hash);
+        y_fineparts, z_fineparts, rxn_pairs);
 
     /* go +Y, +Z) */
     if (z_pos)
       shead1 = expand_collision_list_for_neighbor(
           sv, vm, new_sv + 1, &path_llf, &path_urb, shead1, 0.0, R, R,
-          x_fineparts, y_fineparts, z_fineparts, rx_hashsize, reaction_hash);
+          x_fineparts, y_fineparts, z_fineparts, rxn_pairs);
 
     /* go +Y, -Z */
     if (z_neg)
       shead1 = expand_collision_list_for_neighbor(
           sv, vm, new_sv - 1, &path_llf, &path_urb, shead1, 0.0, R, -R,
-          x_fineparts, y_fineparts, z_fineparts, rx_hashsize, reaction_hash);
+          x_fineparts, y_fineparts, z_fineparts, rxn_pairs);
   }
 
   /* go in the direction Y_NEG */
@@ -2249,32 +2398,32 @@ expand_collision_list(struct volume_molecule *vm, struct vector3 *mv,
     struct subvolume *new_sv = sv - (nz_parts - 1);
     shead1 = expand_collision_list_for_neighbor(
         sv, vm, new_sv, &path_llf, &path_urb, shead1, 0.0, -R, 0.0, x_fineparts,
-        y_fineparts, z_fineparts, rx_hashsize, reaction_hash);
+        y_fineparts, z_fineparts, rxn_pairs);
 
     /* go -Y, +Z) */
     if (z_pos)
       shead1 = expand_collision_list_for_neighbor(
           sv, vm, new_sv + 1, &path_llf, &path_urb, shead1, 0.0, -R, R,
-          x_fineparts, y_fineparts, z_fineparts, rx_hashsize, reaction_hash);
+          x_fineparts, y_fineparts, z_fineparts, rxn_pairs);
 
     /* go -Y, -Z */
     if (z_neg)
       shead1 = expand_collision_list_for_neighbor(
           sv, vm, new_sv - 1, &path_llf, &path_urb, shead1, 0.0, -R, -R,
-          x_fineparts, y_fineparts, z_fineparts, rx_hashsize, reaction_hash);
+          x_fineparts, y_fineparts, z_fineparts, rxn_pairs);
   }
 
   /* go in the direction Z_POS */
   if (z_pos)
     shead1 = expand_collision_list_for_neighbor(
         sv, vm, sv + 1, &path_llf, &path_urb, shead1, 0.0, 0.0, R, x_fineparts,
-        y_fineparts, z_fineparts, rx_hashsize, reaction_hash);
+        y_fineparts, z_fineparts, rxn_pairs);
 
   /* go in the direction Z_NEG */
   if (z_neg)
     shead1 = expand_collision_list_for_neighbor(
         sv, vm, sv - 1, &path_llf, &path_urb, shead1, 0.0, 0.0, -R, x_fineparts,
-        y_fineparts, z_fineparts, rx_hashsize, reaction_hash);
+        y_fineparts, z_fineparts, rxn_pairs);
 
   return shead1;
 }
@@ -2314,7 +2463,7 @@ struct sp_collision *expand_collision_partner_list_for_neighbor(
     struct subvolume *new_sv, struct vector3 *path_llf,
     struct vector3 *path_urb, struct sp_collision *shead1, double trim_x,
     double trim_y, double trim_z, double *x_fineparts, double *y_fineparts,
-    double *z_fineparts, int rx_hashsize, struct rxn **reaction_hash) {
+    double *z_fineparts, struct rxn_pair_table const *rxn_pairs) {
   struct species *spec = vm->properties;
   struct sp_collision *smash;
 
@@ -2379,6 +2528,9 @@ struct sp_collision *expand_collision_partner_list_for_neighbor(
     z_max = new_sv_urb.z + EPS_C;
   }
 
+  struct vector3 box_llf = { x_min, y_min, z_min };
+  struct vector3 box_urb = { x_max, y_max, z_max };
+
   /* scan molecules from this SV */
   struct per_species_list *psl_next, *psl, **psl_head = &new_sv->species_head;
   for (psl = new_sv->species_head; psl != NULL; psl = psl_next) {
@@ -2392,7 +2544,7 @@ struct sp_collision *expand_collision_partner_list_for_neighbor(
     if (psl->head == NULL) {
       *psl_head = psl->next;
       ht_remove(&new_sv->mol_by_species, psl);
-      mem_put(new_sv->local_storage->pslv, psl);
+      collect_species_list(new_sv->local_storage, psl);
       continue;
     } else
       psl_head = &psl->next;
@@ -2403,56 +2555,53 @@ struct sp_collision *expand_collision_partner_list_for_neighbor(
     col_bi_molecular_flag =
         moving_bi_molecular_flag &&
         ((psl->properties->flags & CAN_VOLVOL) == CAN_VOLVOL) &&
-        trigger_bimolecular_preliminary(reaction_hash, rx_hashsize,
-                                        spec->hashval, psl->properties->hashval,
-                                        spec, psl->properties);
+        trigger_bimolecular_preliminary(rxn_pairs, spec, psl->properties);
     col_mol_mol_grid_flag =
         moving_mol_mol_grid_flag &&
         ((psl->properties->flags & CAN_VOLVOLSURF) == CAN_VOLVOLSURF);
     if (col_bi_molecular_flag || col_tri_molecular_flag ||
         col_mol_mol_grid_flag) {
-      struct volume_molecule *mp;
-      for (mp = psl->head; mp != NULL; mp = mp->next_v) {
-        /* Skip defunct molecules */
-        if (mp->properties == NULL)
-          continue;
-
-        /* skip molecules outside the region of interest */
-        if (mp->pos.x < x_min || mp->pos.x > x_max)
-          continue;
-        if (mp->pos.y < y_min || mp->pos.y > y_max)
-          continue;
-        if (mp->pos.z < z_min || mp->pos.z > z_max)
-          continue;
+      /* skip molecules outside the region of interest, looking only at
+         the packed coordinates */
+      for (int first = 0; first < psl->n_mols; first += MOLECULE_SCAN_CHUNK) {
+        int hits[MOLECULE_SCAN_CHUNK];
+        int n_hits = molecules_in_box(psl, first, &box_llf, &box_urb, hits);
+        for (int h = 0; h < n_hits; h++) {
+          struct volume_molecule *mp = psl->mols[hits[h]];
+
+          /* Skip defunct molecules */
+          if (mp->properties == NULL)
+            continue;
 
-        smash = (struct sp_collision *)CHECKED_MEM_GET(
-            sv->local_storage->sp_coll, "collision data");
-        smash->t = 0.0;
-        smash->t_start = 0.0;
-        smash->pos_start.x = vm->pos.x;
-        smash->pos_start.y = vm->pos.y;
-        smash->pos_start.z = vm->pos.z;
-        smash->sv_start = sv;
-        smash->disp.x = mv->x;
-        smash->disp.y = mv->y;
-        smash->disp.z = mv->z;
-        smash->loc.x = 0.0;
-        smash->loc.y = 0.0;
-        smash->loc.z = 0.0;
-        smash->moving = spec;
-        smash->target = (void *)mp;
-        smash->what = 0;
-        if (col_bi_molecular_flag) {
-          smash->what |= COLLIDE_VOL;
-        }
-        if (col_tri_molecular_flag) {
-          smash->what |= COLLIDE_VOL_VOL;
-        }
-        if (col_mol_mol_grid_flag) {
-          smash->what |= COLLIDE_VOL_SURF;
+          smash = (struct sp_collision *)CHECKED_MEM_GET(
+              sv->local_storage->sp_coll, "collision data");
+          smash->t = 0.0;
+          smash->t_start = 0.0;
+          smash->pos_start.x = vm->pos.x;
+          smash->pos_start.y = vm->pos.y;
+          smash->pos_start.z = vm->pos.z;
+          smash->sv_start = sv;
+          smash->disp.x = mv->x;
+          smash->disp.y = mv->y;
+          smash->disp.z = mv->z;
+          smash->loc.x = 0.0;
+          smash->loc.y = 0.0;
+          smash->loc.z = 0.0;
+          smash->moving = spec;
+          smash->target = (void *)mp;
+          smash->what = 0;
+          if (col_bi_molecular_flag) {
+            smash->what |= COLLIDE_VOL;
+          }
+          if (col_tri_molecular_flag) {
+            smash->what |= COLLIDE_VOL_VOL;
+          }
+          if (col_mol_mol_grid_flag) {
+            smash->what |= COLLIDE_VOL_SURF;
+          }
+          smash->next = shead1;
+          shead1 = smash;
         }
-        smash->next = shead1;
-        shead1 = smash;
       }
     }
   }
@@ -2460,18 +2609,157 @@ struct sp_collision *expand_collision_partner_list_for_neighbor(
 }
 
 /*************************************************************************
-diffuse_3D:
+hand_off_step:
+  In: vm: molecule that just reached a storage run by another worker
+      new_sv: subvolume the molecule is moving into
+      displacement: remaining displacement
+      displacement2: displacement after unbinding
+      t_steps: time left in this step
+      r_rate_factor: rate scaling for this step
+      sched_time: scheduling time when the step began
+      inertness: unbinding state
+  Out: No return value.  The rest of the step is queued on the new
+       storage, which adopts the molecule and finishes it (see
+       finish_pending_steps).
+  Note: Only used while storages run in parallel.  The molecule stays in
+        its old subvolume until it is adopted, and stays marked as
+        scheduled so that it is not freed if it reacts in the meantime.
+        The record comes from the old storage, so nothing but the queue
+        of the new storage is touched here.
+*************************************************************************/
+static void hand_off_step(struct volume_molecule *vm, struct subvolume *new_sv,
+                          struct vector3 const *displacement,
+                          struct vector3 const *displacement2, double t_steps,
+                          double r_rate_factor, double sched_time,
+                          int inertness) {
+  struct storage *local = vm->subvol->local_storage;
+  struct pending_step *ps =
+      (struct pending_step *)CHECKED_MEM_GET(local->pend, "pending step");
+  ps->vm = vm;
+  ps->subvol = new_sv;
+  ps->birthplace = local->pend;
+  ps->displacement = *displacement;
+  ps->displacement2 = *displacement2;
+  ps->t_steps = t_steps;
+  ps->r_rate_factor = r_rate_factor;
+  ps->sched_time = sched_time;
+  ps->inertness = inertness;
+  vm->flags |= IN_SCHEDULE;
+  queue_pending_step(new_sv->local_storage, ps);
+}
+
+/*************************************************************************
+collision_candidates:
+  In: world: simulation state
+      sv: subvolume that the molecule is in
+      vm: molecule that is moving
+  Out: The molecules in the subvolume that molecules of vm's species may
+       react with, each paired with one of the reactions, in the order
+       diffuse_3D adds them to its collision list.  vm itself may be among
+       them.
+  Note: The list is kept with the subvolume and only made again once a
+        molecule has entered or left it, so molecules of one species
+        stepping in the same subvolume share it.  Positions are not
+        cached, so molecules moving within the subvolume do not spoil it.
+*************************************************************************/
+static struct candidate_cache *collision_candidates(struct volume *world,
+                                                    struct subvolume *sv,
+                                                    struct volume_molecule *vm) {
+  int complex_member = (vm->flags & COMPLEX_MEMBER) != 0;
+  struct candidate_cache *cc;
+  for (cc = sv->candidates; cc != NULL; cc = cc->next) {
+    if (cc->properties == vm->properties &&
+        cc->complex_member == complex_member)
+      break;
+  }
+
+  if (cc == NULL) {
+    cc = CHECKED_MALLOC_STRUCT(struct candidate_cache, "collision candidates");
+    cc->properties = vm->properties;
+    cc->complex_member = complex_member;
+    cc->epoch = sv->mol_epoch - 1;
+    cc->n_candidates = cc->max_candidates = 0;
+    cc->mols = NULL;
+    cc->rxns = NULL;
+    cc->next = sv->candidates;
+    sv->candidates = cc;
+  }
+
+  if (cc->epoch == sv->mol_epoch)
+    return cc;
+
+  cc->epoch = sv->mol_epoch;
+  cc->n_candidates = 0;
+
+  /* scan molecules from this SV */
+  struct per_species_list *psl_next, *psl, **psl_head = &sv->species_head;
+  for (psl = sv->species_head; psl != NULL; psl = psl_next) {
+    psl_next = psl->next;
+    if (psl->properties == NULL) {
+      psl_head = &psl->next;
+      continue;
+    }
+
+    /* Garbage collection of empty per-species lists */
+    if (psl->head == NULL) {
+      *psl_head = psl->next;
+      ht_remove(&sv->mol_by_species, psl);
+      collect_species_list(sv->local_storage, psl);
+      continue;
+    } else
+      psl_head = &psl->next;
+
+    /* no possible reactions. skip it. */
+    if (!trigger_bimolecular_preliminary(&world->rxn_pairs, vm->properties,
+                                         psl->properties))
+      continue;
+
+    for (struct volume_molecule *mp = psl->head; mp != NULL; mp = mp->next_v) {
+      struct rxn *matching_rxns[MAX_MATCHING_RXNS];
+      int num_matching_rxns = trigger_bimolecular(
+          &world->rxn_pairs, (struct abstract_molecule *)vm,
+          (struct abstract_molecule *)mp, 0, 0, matching_rxns);
+
+      for (int i = 0; i < num_matching_rxns; i++) {
+        if (cc->n_candidates == cc->max_candidates) {
+          int max_candidates =
+              (cc->max_candidates == 0) ? 16 : 2 * cc->max_candidates;
+          struct volume_molecule **mols =
+              realloc(cc->mols, max_candidates * sizeof(*mols));
+          struct rxn **rxns = realloc(cc->rxns, max_candidates * sizeof(*rxns));
+          if (mols == NULL || rxns == NULL)
+            mcell_allocfailed("Failed to grow collision candidate list.");
+          cc->mols = mols;
+          cc->rxns = rxns;
+          cc->max_candidates = max_candidates;
+        }
+        cc->mols[cc->n_candidates] = mp;
+        cc->rxns[cc->n_candidates] = matching_rxns[i];
+        cc->n_candidates++;
+      }
+    }
+  }
+
+  return cc;
+}
+
+/*************************************************************************
+diffuse_3D_step:
   In: world: simulation state
       vm: molecule that is moving
       max_time: maximum time we can spend diffusing
+      resume: step handed over by another storage, or NULL to start a new
+              step
   Out: Pointer to the molecule if it still exists (may have been
-       reallocated), NULL otherwise.
+       reallocated), NULL otherwise (including if the step was handed over
+       to another storage).
        Position and time are updated, but molecule is not rescheduled.
   Note: This version takes into account only 2-way reactions and 3-way
         reactions of type MOL_GRID_GRID
 *************************************************************************/
-struct volume_molecule *diffuse_3D(struct volume *world,
-                                   struct volume_molecule *vm, double max_time) {
+static struct volume_molecule *
+diffuse_3D_step(struct volume *world, struct volume_molecule *vm,
+                double max_time, struct pending_step const *resume) {
   struct vector3 displacement;  /* Molecule moves along this vector */
   struct vector3 displacement2; /* Used for 3D mol-mol unbinding */
   double disp_length;           /* length of the displacement */
@@ -2483,6 +2771,7 @@ struct volume_molecule *diffuse_3D(struct volume *world,
       NULL; /* Things we might hit (can interact with) from neighbor
                subvolumes */
   struct collision *shead2; /* Things that we will hit, given our motion */
+  struct collision_vector hits; /* Storage for shead2 */
   struct collision *
   tentative; /* Things we already hit but haven't yet counted */
   struct subvolume *sv;
@@ -2532,6 +2821,21 @@ struct volume_molecule *diffuse_3D(struct volume *world,
   mol_grid_flag = ((spec->flags & CAN_VOLSURF) == CAN_VOLSURF);
   mol_grid_grid_flag = ((spec->flags & CAN_VOLSURFSURF) == CAN_VOLSURFSURF);
 
+  collision_vector_init(&hits);
+
+  /* Pick up where the previous storage left off */
+  double step_sched_time = vm->t;
+  if (resume != NULL) {
+    displacement = resume->displacement;
+    displacement2 = resume->displacement2;
+    t_steps = resume->t_steps;
+    r_rate_factor = resume->r_rate_factor;
+    step_sched_time = resume->sched_time;
+    inertness = resume->inertness;
+    calculate_displacement = 0;
+    goto pretend_to_call_diffuse_3D;
+  }
+
   if (spec->space_step <= 0.0) {
     vm->t += max_time;
     return vm;
@@ -2589,56 +2893,25 @@ pretend_to_call_diffuse_3D: /* Label to allow fake recursion */
   stail = NULL;
   if ((spec->flags & (CAN_VOLVOL | CANT_INITIATE)) == CAN_VOLVOL &&
       inertness < inert_to_all) {
-    /* scan molecules from this SV */
-    struct per_species_list *psl_next, *psl, **psl_head = &sv->species_head;
-    for (psl = sv->species_head; psl != NULL; psl = psl_next) {
-      psl_next = psl->next;
-      if (psl->properties == NULL) {
-        psl_head = &psl->next;
-        continue;
-      }
-
-      /* Garbage collection of empty per-species lists */
-      if (psl->head == NULL) {
-        *psl_head = psl->next;
-        ht_remove(&sv->mol_by_species, psl);
-        mem_put(sv->local_storage->pslv, psl);
+    /* molecules from this SV */
+    struct candidate_cache *cc = collision_candidates(world, sv, vm);
+    for (i = 0; i < cc->n_candidates; i++) {
+      mp = cc->mols[i];
+      if (mp == vm)
         continue;
-      } else
-        psl_head = &psl->next;
 
-      /* no possible reactions. skip it. */
-      if (!trigger_bimolecular_preliminary(
-               world->reaction_hash, world->rx_hashsize, vm->properties->hashval,
-               psl->properties->hashval, vm->properties, psl->properties))
+      if (inertness == inert_to_mol && vm->index == mp->index)
         continue;
 
-      for (mp = psl->head; mp != NULL; mp = mp->next_v) {
-        if (mp == vm)
-          continue;
-
-        if (inertness == inert_to_mol && vm->index == mp->index)
-          continue;
-
-        num_matching_rxns = trigger_bimolecular(
-            world->reaction_hash, world->rx_hashsize, spec->hashval,
-            psl->properties->hashval, (struct abstract_molecule *)vm,
-            (struct abstract_molecule *)mp, 0, 0, matching_rxns);
-
-        if (num_matching_rxns > 0) {
-          for (i = 0; i < num_matching_rxns; i++) {
-            smash = (struct collision *)CHECKED_MEM_GET(sv->local_storage->coll,
-                                                        "collision data");
-            smash->target = (void *)mp;
-            smash->what = COLLIDE_VOL;
-            smash->intermediate = matching_rxns[i];
-            smash->next = shead;
-            shead = smash;
-            if (stail == NULL)
-              stail = shead;
-          }
-        }
-      }
+      smash = (struct collision *)CHECKED_MEM_GET(sv->local_storage->coll,
+                                                  "collision data");
+      smash->target = (void *)mp;
+      smash->what = COLLIDE_VOL;
+      smash->intermediate = cc->rxns[i];
+      smash->next = shead;
+      shead = smash;
+      if (stail == NULL)
+        stail = shead;
     }
   }
 
@@ -2719,7 +2992,7 @@ pretend_to_call_diffuse_3D: /* Label to allow fake recursion */
                                       world->ny_parts,
                                       world->nz_parts, world->x_fineparts,
                                       world->y_fineparts, world->z_fineparts,
-                                      world->rx_hashsize, world->reaction_hash);
+                                      &world->rxn_pairs);
     if (stail != NULL)
       stail->next = shead_exp;
     else {
@@ -2731,10 +3004,19 @@ pretend_to_call_diffuse_3D: /* Label to allow fake recursion */
     }
   }
 
+  /* Nothing to hit: with no walls in this subvolume and no molecules to
+     react with, a move that stays in the subvolume is made right away,
+     just as the ray_trace below would find it */
+  if (shead == NULL && sv->wall_head == NULL && inertness != inert_to_all &&
+      move_stays_in_subvolume(world, sv, &vm->pos, &displacement)) {
+    make_free_move(world, vm, &displacement, t_steps);
+    collision_vector_free(&hits);
+    return vm;
+  }
+
 #define CLEAN_AND_RETURN(x)                                                    \
   do {                                                                         \
-    if (shead2 != NULL)                                                        \
-      mem_put_list(sv->local_storage->coll, shead2);                           \
+    collision_vector_free(&hits);                                              \
     if (shead != NULL)                                                         \
       mem_put_list(sv->local_storage->coll, shead);                            \
     return (x);                                                                \
@@ -2760,8 +3042,7 @@ pretend_to_call_diffuse_3D: /* Label to allow fake recursion */
         shead_exp = expand_collision_list(
             vm, &displacement, sv, world->rx_radius_3d,
             world->ny_parts, world->nz_parts, world->x_fineparts,
-            world->y_fineparts, world->z_fineparts, world->rx_hashsize,
-            world->reaction_hash);
+            world->y_fineparts, world->z_fineparts, &world->rxn_pairs);
         if (stail != NULL)
           stail->next = shead_exp;
         else {
@@ -2774,15 +3055,11 @@ pretend_to_call_diffuse_3D: /* Label to allow fake recursion */
       }
     }
 
-    shead2 = ray_trace(world, &(vm->pos), shead, sv, &displacement, reflectee);
+    shead2 = ray_trace(world, &(vm->pos), shead, sv, &displacement, reflectee,
+                       &hits);
     if (shead2 == NULL)
       mcell_internal_error("ray_trace returned NULL.");
 
-    if (shead2->next != NULL) {
-      shead2 =
-          (struct collision *)ae_list_sort((struct abstract_element *)shead2);
-    }
-
     loc_certain = NULL;
     tentative = shead2;
 
@@ -2883,8 +3160,7 @@ pretend_to_call_diffuse_3D: /* Label to allow fake recursion */
               sm = w->grid->mol[j];
               if (mol_grid_flag) {
                 num_matching_rxns = trigger_bimolecular(
-                    world->reaction_hash, world->rx_hashsize, spec->hashval,
-                    sm->properties->hashval, (struct abstract_molecule *)vm,
+                    &world->rxn_pairs, (struct abstract_molecule *)vm,
                     (struct abstract_molecule *)sm, k, sm->orient,
                     matching_rxns);
                 if (num_matching_rxns > 0) {
@@ -2994,6 +3270,7 @@ pretend_to_call_diffuse_3D: /* Label to allow fake recursion */
                 struct surface_molecule *smp; /* Neighboring molecules */
                 struct tile_neighbor *tile_nbr_head = NULL, *curr;
                 int list_length = 0;
+                int own_list; /* did we make tile_nbr_head ourselves? */
                 int n = 0; /* total number of possible reactions for a given
                                molecule with all its neighbors */
                 int kk, ll;
@@ -3001,8 +3278,8 @@ pretend_to_call_diffuse_3D: /* Label to allow fake recursion */
                 num_matching_rxns = 0;
 
                 /* find neighbor molecules to react with */
-                find_neighbor_tiles(world, sm, sm->grid, sm->grid_index, 0, 1,
-                                    &tile_nbr_head, &list_length);
+                own_list = neighbor_tiles_for_reactant(
+                    world, sm, &tile_nbr_head, &list_length);
                 if (tile_nbr_head != NULL) {
                   const int num_nbrs = list_length;
                   double local_prob_factor; /*local probability factor for the
@@ -3081,7 +3358,8 @@ pretend_to_call_diffuse_3D: /* Label to allow fake recursion */
                       n += num_matching_rxns;
                     }
                   }
-                  delete_tile_neighbor_list(tile_nbr_head);
+                  if (own_list)
+                    delete_tile_neighbor_list(tile_nbr_head);
 
                   if (n == 1) {
                     ii =
@@ -3178,9 +3456,9 @@ pretend_to_call_diffuse_3D: /* Label to allow fake recursion */
         if ((spec->flags & CAN_VOLWALL) != 0) {
           vm->index = -1;
           num_matching_rxns = trigger_intersect(
-              world->reaction_hash, world->rx_hashsize, world->all_mols,
-              world->all_volume_mols, world->all_surface_mols, spec->hashval,
-              (struct abstract_molecule *)vm, k, w, matching_rxns, 1, 0, 0);
+              &world->rxn_pairs, world->all_mols, world->all_volume_mols,
+              world->all_surface_mols, (struct abstract_molecule *)vm, k, w,
+              matching_rxns, 1, 0, 0);
           if (num_matching_rxns > 0) {
             for (ii = 0; ii < num_matching_rxns; ii++) {
               rx = matching_rxns[ii];
@@ -3197,7 +3475,7 @@ pretend_to_call_diffuse_3D: /* Label to allow fake recursion */
                 world->vol_wall_colls++;
             }
             if (is_transp_flag) {
-              transp_rx->n_occurred++;
+              count_add_llong(world, &transp_rx->n_occurred, 1);
               if ((vm->flags & COUNT_ME) != 0 &&
                   (spec->flags & COUNT_SOME_MASK) != 0) {
                 /* Count as far up as we can unambiguously */
@@ -3357,6 +3635,7 @@ pretend_to_call_diffuse_3D: /* Label to allow fake recursion */
 
         /* Update molecule location to the point of reflection */
         vm->pos = reflect_pt;
+        update_packed_position(vm);
         vm->t += t_steps * reflect_t;
         reflectee = reflect_w;
 
@@ -3404,6 +3683,7 @@ pretend_to_call_diffuse_3D: /* Label to allow fake recursion */
         vm->pos.x = smash->loc.x;
         vm->pos.y = smash->loc.y;
         vm->pos.z = smash->loc.z;
+        update_packed_position(vm);
 
         displacement.x *= (1.0 - smash->t);
         displacement.y *= (1.0 - smash->t);
@@ -3422,25 +3702,29 @@ pretend_to_call_diffuse_3D: /* Label to allow fake recursion */
               "A %s molecule escaped the world at [%.2f, %.2f, %.2f]",
               spec->sym->name, vm->pos.x * world->length_unit,
               vm->pos.y * world->length_unit, vm->pos.z * world->length_unit);
-        } else {
-          vm = migrate_volume_molecule(vm, nsv);
         }
 
-        if (shead2 != NULL)
-          mem_put_list(sv->local_storage->coll, shead2);
         if (shead != NULL)
           mem_put_list(sv->local_storage->coll, shead);
         calculate_displacement = 0;
 
         if (vm->properties == NULL)
           mcell_internal_error("A defunct molecule is diffusing.");
+
+        /* The new storage belongs to another worker; let it adopt the
+           molecule and finish the step */
+        if (world->active_storage != NULL &&
+            nsv->local_storage != world->active_storage) {
+          hand_off_step(vm, nsv, &displacement, &displacement2, t_steps,
+                        r_rate_factor, step_sched_time, inertness);
+          collision_vector_free(&hits);
+          return NULL;
+        }
+        vm = migrate_volume_molecule(vm, nsv);
         goto pretend_to_call_diffuse_3D; /* Jump to beginning of function */
       }
     }
 
-    if (shead2 != NULL)
-      mem_put_list(sv->local_storage->coll, shead2);
-
   } while (smash != NULL);
 
 #undef CLEAN_AND_RETURN
@@ -3448,6 +3732,7 @@ pretend_to_call_diffuse_3D: /* Label to allow fake recursion */
   vm->pos.x += displacement.x;
   vm->pos.y += displacement.y;
   vm->pos.z += displacement.z;
+  update_packed_position(vm);
   vm->t += t_steps;
 
   if (inertness ==
@@ -3463,6 +3748,7 @@ pretend_to_call_diffuse_3D: /* Label to allow fake recursion */
   vm->index = -1;
   vm->previous_wall = NULL;
 
+  collision_vector_free(&hits);
   if (shead != NULL)
     mem_put_list(sv->local_storage->coll, shead);
 
@@ -3470,53 +3756,38 @@ pretend_to_call_diffuse_3D: /* Label to allow fake recursion */
 }
 
 /*************************************************************************
-diffuse_2D:
+diffuse_3D:
   In: world: simulation state
-      sm: molecule that is moving
+      vm: molecule that is moving
       max_time: maximum time we can spend diffusing
-      advance_time: how much to advance molecule internal time (return value)
-  Out: Pointer to the molecule, or NULL if there was an error (right now
-       there is no reallocation)
-       Position and time are updated, but molecule is not rescheduled,
-       nor does it react
-  To-do: This doesn't work with triggers.  Change style of counting code
-         so that it can update as we go, like with 3D diffusion.
+  Out: Pointer to the molecule if it still exists (may have been
+       reallocated), NULL otherwise.
+       Position and time are updated, but molecule is not rescheduled.
 *************************************************************************/
-struct surface_molecule *diffuse_2D(struct volume *world,
-                                    struct surface_molecule *sm,
-                                    double max_time, double *advance_time) {
-  struct species *sg;
-  struct vector2 displacement, new_loc;
-  double disp_length; /* length of the displacement */
-  struct wall *new_wall;
-  double f;
-  double steps, t_steps;
-  double space_factor;
-  int find_new_position;
-  unsigned int new_idx;
-  int kill_me = 0; /* flag */
-  struct rxn *rxp = NULL;
-  struct hit_data *hd_info = NULL;
-  int g_is_complex = 0;
-
-  sg = sm->properties;
-  if (sg == NULL)
-    mcell_internal_error(
-        "Attempted to take a 2-D diffusion step for a defunct molecule.");
-
-  if (sm->flags & COMPLEX_MEMBER)
-    g_is_complex = 1;
+struct volume_molecule *diffuse_3D(struct volume *world,
+                                   struct volume_molecule *vm, double max_time) {
+  return diffuse_3D_step(world, vm, max_time, NULL);
+}
 
-  if (sg->space_step <= 0.0) {
-    sm->t += max_time;
-    return sm;
-  }
+/*************************************************************************
+plan_2D_step:
+  In: world: simulation state
+      sm: molecule that is about to move
+      max_time: maximum time we can spend diffusing
+      t_steps: place to store how much the step advances the molecule
+  Out: Scale factor for the displacement of the step.
+  Note: The step is counted in the diffusion statistics.
+*************************************************************************/
+static double plan_2D_step(struct volume *world, struct surface_molecule *sm,
+                           double max_time, double *t_steps) {
+  struct species *sg = sm->properties;
+  double steps;
 
   if (sg->time_step > 1.0) {
     double sched_time = convert_iterations_to_seconds(
         world->start_iterations, world->time_unit,
         world->simulation_start_seconds, sm->t);
-    f = 1 + 0.2 * ((sched_time - sm->birthday)/world->time_unit);
+    double f = 1 + 0.2 * ((sched_time - sm->birthday)/world->time_unit);
     if (f < 1)
       mcell_internal_error("A %s molecule is scheduled to move before it was "
                            "born [birthday=%.15g, t=%.15g]",
@@ -3527,29 +3798,63 @@ struct surface_molecule *diffuse_2D(struct volume *world,
 
   /* Where are we going? */
   if (sg->time_step > max_time) {
-    t_steps = max_time;
+    *t_steps = max_time;
     steps = max_time / sg->time_step;
   } else {
-    t_steps = sg->time_step;
+    *t_steps = sg->time_step;
     steps = 1.0;
   }
   if (steps < EPS_C) {
     steps = EPS_C;
-    t_steps = EPS_C * sg->time_step;
+    *t_steps = EPS_C * sg->time_step;
   }
 
+  world->diffusion_number++;
+  world->diffusion_cumtime += steps;
+
   if (steps == 1.0)
-    space_factor = sg->space_step;
+    return sg->space_step;
   else
-    space_factor = sg->space_step * sqrt(steps);
+    return sg->space_step * sqrt(steps);
+}
 
-  world->diffusion_number++;
-  world->diffusion_cumtime += steps;
+/*************************************************************************
+diffuse_2D_step:
+  In: world: simulation state
+      sm: molecule that is moving
+      space_factor: scale factor for the displacement (see plan_2D_step)
+      t_steps: how much the step advances the molecule
+      first_disp: displacement to try first, or NULL to pick one
+      advance_time: how much to advance molecule internal time (return value)
+  Out: Pointer to the molecule, or NULL if it was absorbed.  Position is
+       updated as for diffuse_2D.
+  Note: Displacements tried after first_disp are picked as usual.
+*************************************************************************/
+static struct surface_molecule *
+diffuse_2D_step(struct volume *world, struct surface_molecule *sm,
+                double space_factor, double t_steps,
+                struct vector2 const *first_disp, double *advance_time) {
+  struct vector2 displacement, new_loc;
+  double disp_length; /* length of the displacement */
+  struct wall *new_wall;
+  int find_new_position;
+  unsigned int new_idx;
+  int kill_me = 0; /* flag */
+  struct rxn *rxp = NULL;
+  struct hit_data *hd_info = NULL;
+  int g_is_complex = 0;
+
+  if (sm->flags & COMPLEX_MEMBER)
+    g_is_complex = 1;
 
   for (find_new_position = (SURFACE_DIFFUSION_RETRIES + 1);
        find_new_position > 0; find_new_position--) {
     hd_info = NULL;
-    pick_2d_displacement(&displacement, space_factor, world->rng);
+    if (first_disp != NULL) {
+      displacement = *first_disp;
+      first_disp = NULL;
+    } else
+      pick_2d_displacement(&displacement, space_factor, world->rng);
 
     if (sm->properties->flags & SET_MAX_STEP_LENGTH) {
       disp_length = sqrt(displacement.u * displacement.u +
@@ -3610,6 +3915,7 @@ struct surface_molecule *diffuse_2D(struct volume *world,
                                 world->count_hashmask, world->count_hash,
                                 &world->ray_polygon_colls);
         sm->grid->mol[sm->grid_index] = NULL;
+        mark_free_tile(sm->grid, sm->grid_index);
         sm->grid->mol[new_idx] = sm;
         sm->grid_index = new_idx;
       } else
@@ -3645,8 +3951,8 @@ struct surface_molecule *diffuse_2D(struct volume *world,
       count_moved_surface_mol(world, sm, new_wall->grid, &new_loc,
                               world->count_hashmask, world->count_hash,
                               &world->ray_polygon_colls);
-
       sm->grid->mol[sm->grid_index] = NULL;
+      mark_free_tile(sm->grid, sm->grid_index);
       sm->grid->n_occupied--;
       sm->grid = new_wall->grid;
       sm->grid_index = new_idx;
@@ -3670,6 +3976,38 @@ struct surface_molecule *diffuse_2D(struct volume *world,
   return sm;
 }
 
+/*************************************************************************
+diffuse_2D:
+  In: world: simulation state
+      sm: molecule that is moving
+      max_time: maximum time we can spend diffusing
+      advance_time: how much to advance molecule internal time (return value)
+  Out: Pointer to the molecule, or NULL if there was an error (right now
+       there is no reallocation)
+       Position and time are updated, but molecule is not rescheduled,
+       nor does it react
+  To-do: This doesn't work with triggers.  Change style of counting code
+         so that it can update as we go, like with 3D diffusion.
+*************************************************************************/
+struct surface_molecule *diffuse_2D(struct volume *world,
+                                    struct surface_molecule *sm,
+                                    double max_time, double *advance_time) {
+  struct species *sg = sm->properties;
+  if (sg == NULL)
+    mcell_internal_error(
+        "Attempted to take a 2-D diffusion step for a defunct molecule.");
+
+  if (sg->space_step <= 0.0) {
+    sm->t += max_time;
+    return sm;
+  }
+
+  double t_steps;
+  double space_factor = plan_2D_step(world, sm, max_time, &t_steps);
+  return diffuse_2D_step(world, sm, space_factor, t_steps, NULL,
+                         advance_time);
+}
+
 /*************************************************************************
 react_2D:
   In: world: simulation state
@@ -3729,10 +4067,11 @@ struct surface_molecule *react_2D(struct volume *world,
         }
       }
 
-      if (smp[kk] != NULL) {
+      if (smp[kk] != NULL &&
+          trigger_bimolecular_preliminary(&world->rxn_pairs, sm->properties,
+                                          smp[kk]->properties)) {
         num_matching_rxns = trigger_bimolecular(
-            world->reaction_hash, world->rx_hashsize, sm->properties->hashval,
-            smp[kk]->properties->hashval, (struct abstract_molecule *)sm,
+            &world->rxn_pairs, (struct abstract_molecule *)sm,
             (struct abstract_molecule *)smp[kk], sm->orient, smp[kk]->orient,
             matching_rxns);
         if (num_matching_rxns > 0) {
@@ -3814,6 +4153,34 @@ struct surface_molecule *react_2D(struct volume *world,
   return sm;
 }
 
+/***************************************************************************
+reserve_surf_rxn_scratch:
+  In: scratch: a thread's scratch space for react_2D_all_neighbors
+      n: number of candidate reactions it must hold
+  Out: No return value.  The arrays are grown if they are too small; their
+       old contents are not kept.
+****************************************************************************/
+static void reserve_surf_rxn_scratch(struct surf_rxn_scratch *scratch,
+                                     int n) {
+  if (n <= scratch->max_items)
+    return;
+
+  int max_items = 2 * scratch->max_items;
+  if (max_items < n)
+    max_items = n;
+
+  free(scratch->rxns);
+  free(scratch->cf);
+  free(scratch->mols);
+  scratch->rxns = CHECKED_MALLOC_ARRAY(struct rxn *, max_items,
+                                       "surface reaction scratch space");
+  scratch->cf = CHECKED_MALLOC_ARRAY(double, max_items,
+                                     "surface reaction scratch space");
+  scratch->mols = CHECKED_MALLOC_ARRAY(struct surface_molecule *, max_items,
+                                       "surface reaction scratch space");
+  scratch->max_items = max_items;
+}
+
 /***************************************************************************
 react_2D_all_neighbors:
   In: world: simulation state
@@ -3850,6 +4217,7 @@ react_2D_all_neighbors(struct volume *world, struct surface_molecule *sm,
   /* linked list of the tile neighbors */
   struct tile_neighbor *tile_nbr_head = NULL, *curr;
   int list_length = 0; /* length of the linked lists above */
+  int own_list;        /* did we make the list ourselves? */
 
   if (sm->flags & COMPLEX_MEMBER)
     mcell_internal_error("Function 'react_2D_all_neighbors()' is called for "
@@ -3860,21 +4228,24 @@ react_2D_all_neighbors(struct volume *world, struct surface_molecule *sm,
                          (u_int)sm->grid_index, sm->grid->n_tiles);
   }
 
-  find_neighbor_tiles(world, sm, sm->grid, sm->grid_index, 0, 1, &tile_nbr_head,
-                      &list_length);
+  own_list =
+      neighbor_tiles_for_reactant(world, sm, &tile_nbr_head, &list_length);
 
   if (tile_nbr_head == NULL)
     return sm; /* no reaction may happen */
 
   const int num_nbrs = list_length;
-  int max_size = num_nbrs * MAX_MATCHING_RXNS;
-  struct rxn *rxn_array[max_size]; /* array of reaction objects with neighbor
-                                     molecules */
+  struct surf_rxn_scratch *scratch = world->surf_rxn_scratch;
+  reserve_surf_rxn_scratch(scratch, num_nbrs * MAX_MATCHING_RXNS);
+  struct rxn **rxn_array = scratch->rxns; /* array of reaction objects with
+                                             neighbor molecules */
   double local_prob_factor; /* local probability factor for the
                                  reactions */
-  double cf[max_size]; /* Correction factors for area for those molecules */
+  double *cf = scratch->cf; /* Correction factors for area for those
+                               molecules */
 
-  struct surface_molecule *smol[max_size]; /* points to neighbor molecules */
+  struct surface_molecule **smol = scratch->mols; /* points to neighbor
+                                                     molecules */
 
   /* Calculate local_prob_factor for the reaction probability.
      Here we convert from 3 neighbor tiles (upper probability
@@ -3882,12 +4253,6 @@ react_2D_all_neighbors(struct volume *world, struct surface_molecule *sm,
 
   local_prob_factor = 3.0 / num_nbrs;
 
-  for (int kk = 0; kk < max_size; kk++) {
-    rxn_array[kk] = NULL;
-    smol[kk] = NULL;
-    cf[kk] = 0;
-  }
-
   /* step through the neighbors */
   for (curr = tile_nbr_head; curr != NULL; curr = curr->next) {
     /* Neighboring molecule */
@@ -3899,6 +4264,11 @@ react_2D_all_neighbors(struct volume *world, struct surface_molecule *sm,
     if (smp == NULL)
       continue;
 
+    /* no possible reactions. skip it. */
+    if (!trigger_bimolecular_preliminary(&world->rxn_pairs, sm->properties,
+                                         smp->properties))
+      continue;
+
     /* check whether the neighbor molecule is behind
        the restrictive region boundary   */
     if ((sm->properties->flags & CAN_REGION_BORDER) ||
@@ -3917,8 +4287,7 @@ react_2D_all_neighbors(struct volume *world, struct surface_molecule *sm,
     }
 
     num_matching_rxns = trigger_bimolecular(
-        world->reaction_hash, world->rx_hashsize, sm->properties->hashval,
-        smp->properties->hashval, (struct abstract_molecule *)sm,
+        &world->rxn_pairs, (struct abstract_molecule *)sm,
         (struct abstract_molecule *)smp, sm->orient, smp->orient,
         matching_rxns);
 
@@ -3943,7 +4312,8 @@ react_2D_all_neighbors(struct volume *world, struct surface_molecule *sm,
     }
   }
 
-  delete_tile_neighbor_list(tile_nbr_head);
+  if (own_list)
+    delete_tile_neighbor_list(tile_nbr_head);
 
   if (n == 0) {
     return sm; /* Nobody to react with */
@@ -3982,22 +4352,10 @@ clean_up_old_molecules:
  This function just removes defunct molecules from the scheduler.
 *************************************************************************/
 void clean_up_old_molecules(struct storage *local) {
-  if (local->timer->defunct_count > MIN_DEFUNCT_FOR_GC &&
-      MAX_DEFUNCT_FRAC * (local->timer->count) < local->timer->defunct_count) {
-    struct abstract_molecule *am;
-    am = (struct abstract_molecule *)schedule_cleanup(local->timer,
-                                                      *is_defunct_molecule);
-    while (am != NULL) {
-      struct abstract_molecule *temp = am;
-      am = am->next;
-      if ((temp->flags & IN_MASK) == IN_SCHEDULE) {
-        temp->next = NULL;
-        mem_put(temp->birthplace, temp);
-      } else {
-        temp->flags &= ~IN_SCHEDULE;
-      }
-    }
-  }
+  int defunct = schedule_defunct_count(local->timer);
+  if (defunct > MIN_DEFUNCT_FOR_GC &&
+      MAX_DEFUNCT_FRAC * (local->timer->count) < defunct)
+    remove_defunct_molecules(local->timer);
 }
 
 /*************************************************************************
@@ -4050,6 +4408,436 @@ void reschedule_surface_molecules(
   }
 }
 
+/*************************************************************************
+finish_pending_steps:
+  In: state: simulation state
+      local: local storage area to use
+  Out: No return value.  Diffusion steps handed over to this storage by
+       neighbouring storages are completed and the molecules rescheduled.
+*************************************************************************/
+static void finish_pending_steps(struct volume *state, struct storage *local) {
+  struct pending_step *ps;
+  while ((ps = take_pending_steps(local)) != NULL) {
+    while (ps != NULL) {
+      struct pending_step *next = ps->next;
+      struct volume_molecule *vm = ps->vm;
+      struct mem_helper *birthplace = ps->birthplace;
+      if (vm->properties == NULL) /* Reacted while waiting.  Remove it. */
+      {
+        struct schedule_helper *timer = vm->subvol->local_storage->timer;
+        if ((vm->flags & IN_MASK) == IN_SCHEDULE) {
+          vm->next = NULL;
+          mem_put(vm->birthplace, vm);
+        } else
+          vm->flags &= ~IN_SCHEDULE;
+        schedule_drop_defunct(timer);
+        mem_put(birthplace, ps);
+        ps = next;
+        continue;
+      }
+
+      vm->flags &= ~IN_SCHEDULE;
+      vm = migrate_volume_molecule(vm, ps->subvol);
+      double sched_time = ps->sched_time;
+      vm = diffuse_3D_step(state, vm, 0.0, ps);
+      mem_put(birthplace, ps);
+      ps = next;
+      if (vm == NULL)
+        continue;
+
+      if ((vm->flags & ACT_REACT) != 0) {
+        vm->t2 -= vm->t - sched_time;
+        if (vm->t2 < 0)
+          vm->t2 = 0;
+      }
+
+      vm->flags |= IN_SCHEDULE;
+      double t = ceil(vm->t) * (1.0 + 0.1 * EPS_C);
+      if (!distinguishable(t, vm->t, EPS_C))
+        vm->t = t;
+      if (schedule_add(vm->subvol->local_storage->timer, vm))
+        mcell_allocfailed("Failed to add a '%s' volume molecule to scheduler "
+                          "after taking a diffusion step.",
+                          vm->properties->sym->name);
+    }
+  }
+}
+
+/*************************************************************************
+reschedule_molecule:
+  In: state: simulation state
+      local: storage whose scheduler the molecule came from
+      am: molecule that has taken its step or reacted
+  Out: No return value.  The molecule is put back into its scheduler,
+       with its time rounded up to the next iteration if it is just short
+       of it.
+*************************************************************************/
+static void reschedule_molecule(struct volume *state, struct storage *local,
+                                struct abstract_molecule *am) {
+  am->flags |= IN_SCHEDULE;
+
+  /* If we're near an integer boundary, advance to the next integer */
+  double t = ceil(am->t) * (1.0 + 0.1 * EPS_C);
+  if (!distinguishable(t, am->t, EPS_C))
+    am->t = t;
+
+  if (am->flags & TYPE_SURF) {
+    reschedule_surface_molecules(state, local, am);
+  } else {
+    if (schedule_add(
+            ((struct volume_molecule *)am)->subvol->local_storage->timer, am))
+      mcell_allocfailed("Failed to add a '%s' volume molecule to scheduler "
+                        "after taking a diffusion step.",
+                        am->properties->sym->name);
+  }
+}
+
+/*************************************************************************
+can_batch_3D_step:
+  In: state: simulation state
+      am: molecule taken from the scheduler
+  Out: 1 if the molecule can take its next step in a batch (see
+       run_3D_batch), 0 otherwise.
+  Note: Molecules that are due for a unimolecular reaction check, that
+        are clamped or still maturing, or whose species can react with
+        volume molecules or has a maximum step length, are left to
+        diffuse_3D.
+*************************************************************************/
+static int can_batch_3D_step(struct volume *state,
+                             struct abstract_molecule const *am) {
+  struct species const *spec = am->properties;
+  if (spec == NULL)
+    return 0;
+  if ((am->flags & (TYPE_VOL | ACT_DIFFUSE | ACT_CLAMPED)) !=
+      (TYPE_VOL | ACT_DIFFUSE))
+    return 0;
+  if ((am->t2 < EPS_C || am->t2 < EPS_C * am->t) &&
+      (am->flags & (ACT_NEWBIE | ACT_CHANGE | ACT_REACT)) != 0)
+    return 0;
+  if ((am->flags & MATURE_MOLECULE) == 0 && spec->time_step > 1.0)
+    return 0;
+  if (spec->space_step <= 0.0)
+    return 0;
+  if ((spec->flags & (CAN_VOLVOL | CANT_INITIATE)) == CAN_VOLVOL ||
+      (spec->flags & (CAN_VOLVOLVOL | CAN_VOLVOLSURF | SET_MAX_STEP_LENGTH)))
+    return 0;
+  return !state->volume_reversibility && !state->surface_reversibility;
+}
+
+/*************************************************************************
+run_3D_batch:
+  In: state: simulation state
+      local: storage whose scheduler the molecules came from
+      first: molecule just taken from the scheduler, which can_batch_3D_step
+             accepts
+      release_time: time of the next release event
+      checkpt_time: time of the next checkpoint
+  Out: No return value.  first, and the molecules of its species and
+       subvolume that follow it in the scheduler, each take one diffusion
+       step and are rescheduled.
+  Note: The displacements of the whole batch are drawn with one call to
+        rng_gauss_batch, and every move is then tested against the
+        subvolume's faces and walls (walls_along_ray).  Moves that stay
+        inside the subvolume with no wall in reach are made without tracing
+        them.  Only the other molecules go through diffuse_3D, which
+        resumes with the displacement already drawn.  As every
+        displacement is drawn before any of these molecules hits anything,
+        random numbers are used in a different order than when molecules
+        are stepped one at a time.
+*************************************************************************/
+static void run_3D_batch(struct volume *state, struct storage *local,
+                         struct volume_molecule *first, double release_time,
+                         double checkpt_time) {
+  struct volume_molecule *batch[DIFFUSION_BATCH_SIZE];
+  double max_time[DIFFUSION_BATCH_SIZE];
+  double t_steps[DIFFUSION_BATCH_SIZE];
+  double rate_factor[DIFFUSION_BATCH_SIZE];
+  double g[3 * DIFFUSION_BATCH_SIZE];
+  struct vector3 displacement[DIFFUSION_BATCH_SIZE];
+  int clear[DIFFUSION_BATCH_SIZE];
+  struct species *spec = first->properties;
+  struct subvolume *sv = first->subvol;
+
+  /* Gather the molecules like the first one that are due now */
+  int n = 0;
+  batch[n++] = first;
+  while (n < DIFFUSION_BATCH_SIZE) {
+    struct abstract_molecule *am = schedule_peek(local->timer);
+    if (am == NULL || am->properties != spec ||
+        !can_batch_3D_step(state, am) ||
+        ((struct volume_molecule *)am)->subvol != sv)
+      break;
+    batch[n++] = schedule_next(local->timer);
+  }
+
+  /* Work out how long each step is, as diffuse_3D would */
+  for (int i = 0; i < n; i++) {
+    struct volume_molecule *vm = batch[i];
+    vm->flags &= ~IN_SCHEDULE;
+
+    max_time[i] = checkpt_time - vm->t;
+    if (local->max_timestep < max_time[i])
+      max_time[i] = local->max_timestep;
+    if ((vm->flags & ACT_REACT) != 0 && vm->t2 < max_time[i])
+      max_time[i] = vm->t2;
+    if (max_time[i] > release_time - vm->t)
+      max_time[i] = release_time - vm->t;
+
+    double steps = 1.0;
+    if (max_time[i] > MULTISTEP_WORTHWHILE)
+      steps = safe_diffusion_step(vm, NULL, state->radial_subdivisions,
+                                  state->r_step, state->x_fineparts,
+                                  state->y_fineparts, state->z_fineparts);
+
+    t_steps[i] = steps * spec->time_step;
+    if (t_steps[i] > max_time[i]) {
+      t_steps[i] = max_time[i];
+      steps = max_time[i] / spec->time_step;
+    }
+    if (steps < EPS_C) {
+      steps = EPS_C;
+      t_steps[i] = EPS_C * spec->time_step;
+    }
+    rate_factor[i] = (steps == 1.0) ? 1.0 : sqrt(steps);
+
+    state->diffusion_number++;
+    state->diffusion_cumtime += steps;
+  }
+
+  rng_gauss_batch(state->rng, g, 3 * n);
+
+  /* Test every move against the subvolume's walls and faces; only the
+     molecules that may hit something are traced */
+  for (int i = 0; i < n; i++) {
+    struct volume_molecule *vm = batch[i];
+    displacement_from_gauss(&displacement[i],
+                            rate_factor[i] * spec->space_step, &g[3 * i]);
+
+    long long polygon_tests = state->ray_polygon_tests;
+    clear[i] =
+        move_stays_in_subvolume(state, sv, &vm->pos, &displacement[i]) &&
+        walls_along_ray(state, sv, &vm->pos, &displacement[i], NULL) == NULL;
+    if (!clear[i])
+      state->ray_polygon_tests = polygon_tests; /* ray_trace counts them */
+  }
+
+  for (int i = 0; i < n; i++) {
+    struct volume_molecule *vm = batch[i];
+    double save_sched_time = vm->t;
+
+    if (clear[i])
+      make_free_move(state, vm, &displacement[i], t_steps[i]);
+    else {
+      struct pending_step ps;
+      ps.displacement = displacement[i];
+      ps.displacement2.x = ps.displacement2.y = ps.displacement2.z = 0.0;
+      ps.t_steps = t_steps[i];
+      ps.r_rate_factor = 1.0 / rate_factor[i];
+      ps.sched_time = save_sched_time;
+      ps.inertness = 0;
+      vm = diffuse_3D_step(state, vm, max_time[i], &ps);
+      if (vm == NULL)
+        continue;
+    }
+
+    // Perform only for unimolecular reactions
+    if ((vm->flags & ACT_REACT) != 0) {
+      vm->t2 -= vm->t - save_sched_time;
+      if (vm->t2 < 0)
+        vm->t2 = 0;
+    }
+
+    reschedule_molecule(state, local, (struct abstract_molecule *)vm);
+  }
+}
+
+/*************************************************************************
+advance_surface_molecule:
+  In: am: surface molecule that has taken its step or looked for partners
+      advance_time: how much to advance its time
+      old_wall: wall the molecule was on before the step
+  Out: No return value.  The molecule's time is advanced, and its
+       unimolecular reaction time is used up or marked for recomputing.
+*************************************************************************/
+static void advance_surface_molecule(struct abstract_molecule *am,
+                                     double advance_time,
+                                     struct wall const *old_wall) {
+  am->t += advance_time;
+
+  // Perform only for unimolecular reactions
+  if ((am->flags & ACT_REACT) != 0) {
+    /* This case takes care of newly created surface products A which
+     * only have a unimolecular surface reaction defined (A @surf) and
+     * are thus scheduled am->t2 = FOREVER */
+    int can_surf_react = ((am->properties->flags & CAN_SURFWALL) != 0);
+    if (can_surf_react && !distinguishable(am->t2, FOREVER, EPS_C)) {
+      am->t2 = 0;
+      am->flags |= ACT_CHANGE; /* Reschedule reaction time */
+    }
+    else {
+      am->t2 -= advance_time;
+      if (am->t2 < 0) {
+        am->t2 = 0;
+      }
+      /* If the molecule didn't move to a wall with another list of
+       * surface classes AND its lifetime hasn't run out, then we don't
+       * need to reschedule, as its reactions are the same. */
+      struct surface_molecule *sm = (struct surface_molecule *)am;
+      if ((old_wall->surf_class_set != sm->grid->surface->surf_class_set) &&
+          (am->t2 > EPS_C || am->t2 > EPS_C * am->t)) {
+        am->t2 = 0;
+        am->flags |= ACT_CHANGE; /* Reschedule reaction time */
+      }
+    }
+  }
+}
+
+/*************************************************************************
+can_batch_2D_step:
+  In: am: molecule taken from the scheduler
+  Out: 1 if the molecule can take its next step in a batch (see
+       run_2D_batch), 0 otherwise.
+  Note: Molecules that are due for a unimolecular reaction check or that
+        belong to a complex, and species that can start reactions with
+        surface molecules or have a maximum step length, are left to
+        diffuse_2D.
+*************************************************************************/
+static int can_batch_2D_step(struct abstract_molecule const *am) {
+  struct species const *spec = am->properties;
+  if (spec == NULL)
+    return 0;
+  if ((am->flags & (TYPE_SURF | ACT_DIFFUSE | COMPLEX_MEMBER)) !=
+      (TYPE_SURF | ACT_DIFFUSE))
+    return 0;
+  if ((am->t2 < EPS_C || am->t2 < EPS_C * am->t) &&
+      (am->flags & (ACT_NEWBIE | ACT_CHANGE | ACT_REACT)) != 0)
+    return 0;
+  if (spec->space_step <= 0.0)
+    return 0;
+  if ((spec->flags & (CAN_SURFSURF | CANT_INITIATE)) == CAN_SURFSURF ||
+      (spec->flags & (CAN_SURFSURFSURF | CANT_INITIATE)) == CAN_SURFSURFSURF)
+    return 0;
+  return (spec->flags & SET_MAX_STEP_LENGTH) == 0;
+}
+
+/*************************************************************************
+run_2D_batch:
+  In: state: simulation state
+      local: storage whose scheduler the molecules came from
+      first: molecule just taken from the scheduler, which can_batch_2D_step
+             accepts
+      release_time: time of the next release event
+      checkpt_time: time of the next checkpoint
+  Out: No return value.  first, and the molecules of its species that
+       follow it in the scheduler, each take one diffusion step and are
+       rescheduled.
+  Note: The displacements of the whole batch are drawn with one call to
+        rng_gauss_batch, and the end points are tested against the
+        molecules' walls in one pass.  Moves that end well inside the wall
+        on a free tile are made without ray_trace_2d; only the others go
+        through diffuse_2D_step, which tries the drawn displacement first.
+        Random numbers are used in a different order than when molecules
+        are stepped one at a time.
+*************************************************************************/
+static void run_2D_batch(struct volume *state, struct storage *local,
+                         struct surface_molecule *first, double release_time,
+                         double checkpt_time) {
+  struct surface_molecule *batch[DIFFUSION_BATCH_SIZE];
+  struct wall *old_wall[DIFFUSION_BATCH_SIZE];
+  double t_steps[DIFFUSION_BATCH_SIZE];
+  double space_factor[DIFFUSION_BATCH_SIZE];
+  struct vector2 disp[DIFFUSION_BATCH_SIZE];
+  struct vector2 end[DIFFUSION_BATCH_SIZE];
+  int inside[DIFFUSION_BATCH_SIZE];
+  double g[2 * DIFFUSION_BATCH_SIZE];
+  struct species *spec = first->properties;
+
+  /* Gather the molecules like the first one that are due now */
+  int n = 0;
+  batch[n++] = first;
+  while (n < DIFFUSION_BATCH_SIZE) {
+    struct abstract_molecule *am = schedule_peek(local->timer);
+    if (am == NULL || am->properties != spec || !can_batch_2D_step(am))
+      break;
+    batch[n++] = schedule_next(local->timer);
+  }
+
+  /* Work out how long each step is, as run_timestep and diffuse_2D would */
+  for (int i = 0; i < n; i++) {
+    struct surface_molecule *sm = batch[i];
+    sm->flags &= ~IN_SCHEDULE;
+
+    double max_time = checkpt_time - sm->t;
+    if (local->max_timestep < max_time)
+      max_time = local->max_timestep;
+    if ((sm->flags & ACT_REACT) != 0 && sm->t2 < max_time)
+      max_time = sm->t2;
+    if (max_time > release_time - sm->t)
+      max_time = release_time - sm->t;
+
+    old_wall[i] = sm->grid->surface;
+    space_factor[i] = plan_2D_step(state, sm, max_time, &t_steps[i]);
+  }
+
+  rng_gauss_batch(state->rng, g, 2 * n);
+
+  /* Find the moves that end at least EPS_C inside their wall.  The wall is
+     convex and the molecule starts on it, so the whole move is too. */
+  for (int i = 0; i < n; i++) {
+    struct wall const *w = old_wall[i];
+    disp[i].u = space_factor[i] * g[2 * i] * .70710678118654752440;
+    disp[i].v = space_factor[i] * g[2 * i + 1] * .70710678118654752440;
+    end[i].u = batch[i]->s_pos.u + disp[i].u;
+    end[i].v = batch[i]->s_pos.v + disp[i].v;
+
+    double e1u = w->uv_vert2.u - w->uv_vert1_u;
+    double d1 = e1u * end[i].v - w->uv_vert2.v * (end[i].u - w->uv_vert1_u);
+    double d2 = end[i].u * w->uv_vert2.v - end[i].v * w->uv_vert2.u;
+    inside[i] =
+        end[i].v > EPS_C &&
+        d1 > EPS_C * sqrt(e1u * e1u + w->uv_vert2.v * w->uv_vert2.v) &&
+        d2 > EPS_C * sqrt(w->uv_vert2.u * w->uv_vert2.u +
+                          w->uv_vert2.v * w->uv_vert2.v);
+  }
+
+  for (int i = 0; i < n; i++) {
+    struct surface_molecule *sm = batch[i];
+    struct surface_grid *grid = sm->grid;
+    double advance_time = t_steps[i];
+    unsigned int new_idx = 0;
+
+    if (inside[i]) {
+      new_idx = uv2grid(&end[i], grid);
+      if (new_idx != sm->grid_index && grid->mol[new_idx] != NULL)
+        inside[i] = 0; /* Tile taken--leave it to diffuse_2D_step */
+      else {
+        count_moved_surface_mol(state, sm, grid, &end[i],
+                                state->count_hashmask, state->count_hash,
+                                &state->ray_polygon_colls);
+        if (new_idx != sm->grid_index) {
+          grid->mol[sm->grid_index] = NULL;
+          mark_free_tile(grid, sm->grid_index);
+          grid->mol[new_idx] = sm;
+          sm->grid_index = new_idx;
+        }
+      }
+    }
+
+    if (inside[i])
+      sm->s_pos = end[i];
+    else {
+      sm = diffuse_2D_step(state, sm, space_factor[i], t_steps[i], &disp[i],
+                           &advance_time);
+      if (sm == NULL)
+        continue;
+    }
+
+    advance_surface_molecule((struct abstract_molecule *)sm, advance_time,
+                             old_wall[i]);
+    reschedule_molecule(state, local, (struct abstract_molecule *)sm);
+  }
+}
+
 /*************************************************************************
 run_timestep:
   In: state: simulation state
@@ -4059,7 +4847,9 @@ run_timestep:
   Out: No return value.  Every molecule in the subvolume is updated in
        position and rescheduled at least one timestep ahead.
   Note: This also occasionally does garbage collection on the scheduling
-        queue.
+        queue.  With batch_diffusion set, runs of volume molecules of one
+        species in one subvolume, and runs of surface molecules of one
+        species, are stepped together (see run_3D_batch and run_2D_batch).
 *************************************************************************/
 void run_timestep(struct volume *state, struct storage *local,
                   double release_time, double checkpt_time) {
@@ -4068,11 +4858,14 @@ void run_timestep(struct volume *state, struct storage *local,
   // Check for garbage collection first
   clean_up_old_molecules(local);
 
+  // Finish steps that neighbouring storages started
+  finish_pending_steps(state, local);
+
   // Now run the timestep
 
   /* Do not trigger the scheduler to advance!  This will be done
    * by the main loop. */
-  while (local->timer->current != NULL) {
+  while (schedule_has_current(local->timer)) {
     am = (struct abstract_molecule *)schedule_next(local->timer);
     if (am->properties == NULL) /* Defunct!  Remove molecule. */
     {
@@ -4081,14 +4874,24 @@ void run_timestep(struct volume *state, struct storage *local,
         mem_put(am->birthplace, am);
       } else
         am->flags &= ~IN_SCHEDULE;
-      if (local->timer->defunct_count > 0)
-        local->timer->defunct_count--;
+      schedule_drop_defunct(local->timer);
 
       continue;
     }
 
     am->flags &= ~IN_SCHEDULE;
 
+    if (state->batch_diffusion && can_batch_3D_step(state, am)) {
+      run_3D_batch(state, local, (struct volume_molecule *)am, release_time,
+                   checkpt_time);
+      continue;
+    }
+    if (state->batch_diffusion && can_batch_2D_step(am)) {
+      run_2D_batch(state, local, (struct surface_molecule *)am, release_time,
+                   checkpt_time);
+      continue;
+    }
+
     // Check for unimolecular reactions
     // If molec is new or need rescheduled, this just computes a new lifetime
     if (am->t2 < EPS_C || am->t2 < EPS_C * am->t) {
@@ -4199,36 +5002,7 @@ void run_timestep(struct volume *state, struct storage *local,
 
     // Advance surface molecule scheduling time
     if ((am->flags & TYPE_SURF) != 0 && (can_diffuse || can_surface_mol_react)) {
-      am->t += surface_mol_advance_time;
-
-      // Perform only for unimolecular reactions
-      if ((am->flags & ACT_REACT) != 0) {
-        /* This case takes care of newly created surface products A which
-         * only have a unimolecular surface reaction defined (A @surf) and
-         * are thus scheduled am->t2 = FOREVER */
-        int can_surf_react = ((am->properties->flags & CAN_SURFWALL) != 0);
-        if (can_surf_react && !distinguishable(am->t2, FOREVER, EPS_C)) {
-          am->t2 = 0;
-          am->flags |= ACT_CHANGE; /* Reschedule reaction time */
-        }
-        else {
-          am->t2 -= surface_mol_advance_time;
-          if (am->t2 < 0) {
-            am->t2 = 0;
-          }
-          /* If the molecule didn't leave its wall AND its lifetime hasn't run
-           * out, then we don't need to reschedule.
-           * NOTE: We really only have to make sure that the new wall has the
-           * same collection of surface classes. Doing so could be
-           * significantly more efficient. */
-          if ((current_wall !=
-              ((struct surface_molecule *)am)->grid->surface) &&
-              (am->t2 > EPS_C || am->t2 > EPS_C * am->t)) {
-            am->t2 = 0;
-            am->flags |= ACT_CHANGE; /* Reschedule reaction time */
-          }
-        }
-      }
+      advance_surface_molecule(am, surface_mol_advance_time, current_wall);
     } else if (!can_diffuse) {
       // NOTE: t2 should only be 0 at this point if "am" is inert. This is
       // basically just a clunky way to ignore it, although it's not clear why
@@ -4241,22 +5015,7 @@ void run_timestep(struct volume *state, struct storage *local,
       }
     }
 
-    am->flags |= IN_SCHEDULE;
-
-    /* If we're near an integer boundary, advance to the next integer */
-    double t = ceil(am->t) * (1.0 + 0.1 * EPS_C);
-    if (!distinguishable(t, am->t, EPS_C))
-      am->t = t;
-
-    if (am->flags & TYPE_SURF) {
-      reschedule_surface_molecules(state, local, am);
-    } else {
-      if (schedule_add(
-              ((struct volume_molecule *)am)->subvol->local_storage->timer, am))
-        mcell_allocfailed("Failed to add a '%s' volume molecule to scheduler "
-                          "after taking a diffusion step.",
-                          am->properties->sym->name);
-    }
+    reschedule_molecule(state, local, am);
   }
   if (local->timer->error)
     mcell_internal_error("Scheduler reported an out-of-memory error while "
@@ -30,6 +30,8 @@
 #define MULTISTEP_PERCENTILE 0.99
 #define MULTISTEP_FRACTION 0.9
 #define MAX_UNI_TIMESKIP 100000
+#define DIFFUSION_BATCH_SIZE 64 /* Most molecules stepped together (see
+                                    run_timestep) */
 
 void pick_displacement(struct vector3 *v, double scale, struct rng_state *rng);
 
@@ -51,9 +53,13 @@ struct wall *ray_trace_2d(struct volume *world, struct surface_molecule *sm,
                           int *kill_me, struct rxn **rxp,
                           struct hit_data **hd_info);
 
+void collision_vector_init(struct collision_vector *cv);
+void collision_vector_free(struct collision_vector *cv);
+
 struct collision *ray_trace(struct volume *world, struct vector3 *init_pos,
                             struct collision *c, struct subvolume *sv,
-                            struct vector3 *v, struct wall *reflectee);
+                            struct vector3 *v, struct wall *reflectee,
+                            struct collision_vector *hits);
 
 struct sp_collision *ray_trace_trimol(struct volume *world,
                                       struct volume_molecule *m,
@@ -105,7 +111,7 @@ struct sp_collision *expand_collision_partner_list_for_neighbor(
     struct subvolume *new_sv, struct vector3 *path_llf,
     struct vector3 *path_urb, struct sp_collision *shead1, double trim_x,
     double trim_y, double trim_z, double *x_fineparts, double *y_fineparts,
-    double *z_fineparts, int rx_hashsize, struct rxn **reaction_hash);
+    double *z_fineparts, struct rxn_pair_table const *rxn_pairs);
 
 double safe_diffusion_step(struct volume_molecule *m, struct collision *shead,
                            u_int radial_subdivisions, double *r_step,
@@ -81,9 +81,8 @@ struct sp_collision *ray_trace_trimol(struct volume *world,
   smash = (struct sp_collision *)CHECKED_MEM_GET(sv->local_storage->sp_coll,
                                                  "collision structure");
 
-  fake_wlp.next = sv->wall_head;
-
-  for (wlp = sv->wall_head; wlp != NULL; wlp = wlp->next) {
+  for (wlp = walls_along_ray(world, sv, &m->pos, v, reflectee);
+       wlp != NULL; wlp = wlp->next) {
     if (wlp->this_wall == reflectee)
       continue;
 
@@ -93,6 +92,8 @@ struct sp_collision *ray_trace_trimol(struct volume *world,
       if (shead != NULL)
         mem_put_list(sv->local_storage->sp_coll, shead);
       shead = NULL;
+      /* The move has changed, so start over with its walls */
+      fake_wlp.next = walls_along_ray(world, sv, &m->pos, v, reflectee);
       wlp = &fake_wlp;
       continue;
     } else if (i != COLLIDE_MISS) {
@@ -292,7 +293,7 @@ static struct sp_collision *expand_collision_partner_list(
     struct volume_molecule *m, struct vector3 *mv, struct subvolume *sv,
     double rx_radius_3d, double *x_fineparts, double *y_fineparts,
     double *z_fineparts, int nx_parts, int ny_parts, int nz_parts,
-    int rx_hashsize, struct rxn **reaction_hash) {
+    struct rxn_pair_table const *rxn_pairs) {
   struct sp_collision *shead1 = NULL;
   /* lower left and upper_right corners of the molecule path
      bounding box expanded by R. */
@@ -323,26 +324,26 @@ static struct sp_collision *expand_collision_partner_list(
     struct subvolume *newsv_x = sv + (nz_parts - 1) * (ny_parts - 1);
     shead1 = expand_collision_partner_list_for_neighbor(
         sv, m, mv, newsv_x, &path_llf, &path_urb, shead1, R, 0.0, 0.0,
-        x_fineparts, y_fineparts, z_fineparts, rx_hashsize, reaction_hash);
+        x_fineparts, y_fineparts, z_fineparts, rxn_pairs);
 
     /* go +X, +Y */
     if (y_pos) {
       struct subvolume *newsv_y = newsv_x + (nz_parts - 1);
       shead1 = expand_collision_partner_list_for_neighbor(
           sv, m, mv, newsv_y, &path_llf, &path_urb, shead1, R, R, 0.0,
-          x_fineparts, y_fineparts, z_fineparts, rx_hashsize, reaction_hash);
+          x_fineparts, y_fineparts, z_fineparts, rxn_pairs);
 
       /* go +X, +Y, +Z */
       if (z_pos)
         shead1 = expand_collision_partner_list_for_neighbor(
             sv, m, mv, newsv_y + 1, &path_llf, &path_urb, shead1, R, R, R,
-            x_fineparts, y_fineparts, z_fineparts, rx_hashsize, reaction_hash);
+            x_fineparts, y_fineparts, z_fineparts, rxn_pairs);
 
       /* go +X, +Y, -Z */
       if (z_neg)
         shead1 = expand_collision_partner_list_for_neighbor(
             sv, m, mv, newsv_y - 1, &path_llf, &path_urb, shead1, R, R, -R,
-            x_fineparts, y_fineparts, z_fineparts, rx_hashsize, reaction_hash);
+            x_fineparts, y_fineparts, z_fineparts, rxn_pairs);
     }
 
     /* go +X, -Y */
@@ -350,32 +351,32 @@ static struct sp_collision *expand_collision_partner_list(
       struct subvolume *newsv_y = newsv_x - (nz_parts - 1);
       shead1 = expand_collision_partner_list_for_neighbor(
           sv, m, mv, newsv_y, &path_llf, &path_urb, shead1, R, -R, 0.0,
-          x_fineparts, y_fineparts, z_fineparts, rx_hashsize, reaction_hash);
+          x_fineparts, y_fineparts, z_fineparts, rxn_pairs);
 
       /* go +X, -Y, +Z */
       if (z_pos)
         shead1 = expand_collision_partner_list_for_neighbor(
             sv, m, mv, newsv_y + 1, &path_llf, &path_urb, shead1, R, -R, R,
-            x_fineparts, y_fineparts, z_fineparts, rx_hashsize, reaction_hash);
+            x_fineparts, y_fineparts, z_fineparts, rxn_pairs);
 
       /* go +X, -Y, -Z */
       if (z_neg)
         shead1 = expand_collision_partner_list_for_neighbor(
             sv, m, mv, newsv_y - 1, &path_llf, &path_urb, shead1, R, -R, -R,
-            x_fineparts, y_fineparts, z_fineparts, rx_hashsize, reaction_hash);
+            x_fineparts, y_fineparts, z_fineparts, rxn_pairs);
     }
 
     /* go +X, +Z */
     if (z_pos)
       shead1 = expand_collision_partner_list_for_neighbor(
           sv, m, mv, newsv_x + 1, &path_llf, &path_urb, shead1, R, 0.0, R,
-          x_fineparts, y_fineparts, z_fineparts, rx_hashsize, reaction_hash);
+          x_fineparts, y_fineparts, z_fineparts, rxn_pairs);
 
     /* go +X, -Z */
     if (z_neg)
       shead1 = expand_collision_partner_list_for_neighbor(
           sv, m, mv, newsv_x - 1, &path_llf, &path_urb, shead1, R, 0.0, -R,
-          x_fineparts, y_fineparts, z_fineparts, rx_hashsize, reaction_hash);
+          x_fineparts, y_fineparts, z_fineparts, rxn_pairs);
   }
 
   /* go -X */
@@ -383,26 +384,26 @@ static struct sp_collision *expand_collision_partner_list(
     struct subvolume *newsv_x = sv - (nz_parts - 1) * (ny_parts - 1);
     shead1 = expand_collision_partner_list_for_neighbor(
         sv, m, mv, newsv_x, &path_llf, &path_urb, shead1, -R, 0.0, 0.0,
-        x_fineparts, y_fineparts, z_fineparts, rx_hashsize, reaction_hash);
+        x_fineparts, y_fineparts, z_fineparts, rxn_pairs);
 
     /* go -X, +Y */
     if (y_pos) {
       struct subvolume *newsv_y = newsv_x + (nz_parts - 1);
       shead1 = expand_collision_partner_list_for_neighbor(
           sv, m, mv, newsv_y, &path_llf, &path_urb, shead1, -R, R, 0.0,
-          x_fineparts, y_fineparts, z_fineparts, rx_hashsize, reaction_hash);
+          x_fineparts, y_fineparts, z_fineparts, rxn_pairs);
 
       /* go -X, +Y, +Z */
       if (z_pos)
         shead1 = expand_collision_partner_list_for_neighbor(
             sv, m, mv, newsv_y + 1, &path_llf, &path_urb, shead1, -R, R, R,
-            x_fineparts, y_fineparts, z_fineparts, rx_hashsize, reaction_hash);
+            x_fineparts, y_fineparts, z_fineparts, rxn_pairs);
 
       /* go -X, +Y, -Z */
       if (z_neg)
         shead1 = expand_collision_partner_list_for_neighbor(
             sv, m, mv, newsv_y - 1, &path_llf, &path_urb, shead1, -R, R, -R,
-            x_fineparts, y_fineparts, z_fineparts, rx_hashsize, reaction_hash);
+            x_fineparts, y_fineparts, z_fineparts, rxn_pairs);
     }
 
     /* go -X, -Y */
@@ -410,32 +411,32 @@ static struct sp_collision *expand_collision_partner_list(
       struct subvolume *newsv_y = newsv_x - (nz_parts - 1);
       shead1 = expand_collision_partner_list_for_neighbor(
           sv, m, mv, newsv_y, &path_llf, &path_urb, shead1, -R, -R, 0.0,
-          x_fineparts, y_fineparts, z_fineparts, rx_hashsize, reaction_hash);
+          x_fineparts, y_fineparts, z_fineparts, rxn_pairs);
 
       /* go -X, -Y, +Z */
       if (z_pos)
         shead1 = expand_collision_partner_list_for_neighbor(
             sv, m, mv, newsv_y + 1, &path_llf, &path_urb, shead1, -R, -R, R,
-            x_fineparts, y_fineparts, z_fineparts, rx_hashsize, reaction_hash);
+            x_fineparts, y_fineparts, z_fineparts, rxn_pairs);
 
       /* go -X, -Y, -Z */
       if (z_neg)
         shead1 = expand_collision_partner_list_for_neighbor(
             sv, m, mv, newsv_y - 1, &path_llf, &path_urb, shead1, -R, -R, -R,
-            x_fineparts, y_fineparts, z_fineparts, rx_hashsize, reaction_hash);
+            x_fineparts, y_fineparts, z_fineparts, rxn_pairs);
     }
 
     /* go -X, +Z */
     if (z_pos)
       shead1 = expand_collision_partner_list_for_neighbor(
           sv, m, mv, newsv_x + 1, &path_llf, &path_urb, shead1, -R, 0.0, R,
-          x_fineparts, y_fineparts, z_fineparts, rx_hashsize, reaction_hash);
+          x_fineparts, y_fineparts, z_fineparts, rxn_pairs);
 
     /* go -X, -Z */
     if (z_neg)
       shead1 = expand_collision_partner_list_for_neighbor(
           sv, m, mv, newsv_x - 1, &path_llf, &path_urb, shead1, -R, 0.0, -R,
-          x_fineparts, y_fineparts, z_fineparts, rx_hashsize, reaction_hash);
+          x_fineparts, y_fineparts, z_fineparts, rxn_pairs);
   }
 
   /* go +Y */
@@ -443,19 +444,19 @@ static struct sp_collision *expand_collision_partner_list(
     struct subvolume *newsv_y = sv + (nz_parts - 1);
     shead1 = expand_collision_partner_list_for_neighbor(
         sv, m, mv, newsv_y, &path_llf, &path_urb, shead1, 0.0, R, 0.0,
-        x_fineparts, y_fineparts, z_fineparts, rx_hashsize, reaction_hash);
+        x_fineparts, y_fineparts, z_fineparts, rxn_pairs);
 
     /* go +Y, +Z */
     if (z_pos)
       shead1 = expand_collision_partner_list_for_neighbor(
           sv, m, mv, newsv_y + 1, &path_llf, &path_urb, shead1, 0.0, R, R,
-          x_fineparts, y_fineparts, z_fineparts, rx_hashsize, reaction_hash);
+          x_fineparts, y_fineparts, z_fineparts, rxn_pairs);
 
     /* go +Y, -Z */
     if (z_neg)
       shead1 = expand_collision_partner_list_for_neighbor(
           sv, m, mv, newsv_y - 1, &path_llf, &path_urb, shead1, 0.0, R, -R,
-          x_fineparts, y_fineparts, z_fineparts, rx_hashsize, reaction_hash);
+          x_fineparts, y_fineparts, z_fineparts, rxn_pairs);
   }
 
   /* go -Y */
@@ -463,32 +464,32 @@ static struct sp_collision *expand_collision_partner_list(
     struct subvolume *newsv_y = sv - (nz_parts - 1);
     shead1 = expand_collision_partner_list_for_neighbor(
         sv, m, mv, newsv_y, &path_llf, &path_urb, shead1, 0.0, -R, 0.0,
-        x_fineparts, y_fineparts, z_fineparts, rx_hashsize, reaction_hash);
+        x_fineparts, y_fineparts, z_fineparts, rxn_pairs);
 
     /* go -Y, +Z */
     if (z_pos)
       shead1 = expand_collision_partner_list_for_neighbor(
           sv, m, mv, newsv_y + 1, &path_llf, &path_urb, shead1, 0.0, -R, R,
-          x_fineparts, y_fineparts, z_fineparts, rx_hashsize, reaction_hash);
+          x_fineparts, y_fineparts, z_fineparts, rxn_pairs);
 
     /* go -Y, -Z */
     if (z_neg)
       shead1 = expand_collision_partner_list_for_neighbor(
           sv, m, mv, newsv_y - 1, &path_llf, &path_urb, shead1, 0.0, -R, -R,
-          x_fineparts, y_fineparts, z_fineparts, rx_hashsize, reaction_hash);
+          x_fineparts, y_fineparts, z_fineparts, rxn_pairs);
   }
 
   /* go +Z */
   if (z_pos)
     shead1 = expand_collision_partner_list_for_neighbor(
         sv, m, mv, sv + 1, &path_llf, &path_urb, shead1, 0.0, 0.0, R,
-        x_fineparts, y_fineparts, z_fineparts, rx_hashsize, reaction_hash);
+        x_fineparts, y_fineparts, z_fineparts, rxn_pairs);
 
   /* go -Z */
   if (z_neg)
     shead1 = expand_collision_partner_list_for_neighbor(
         sv, m, mv, sv - 1, &path_llf, &path_urb, shead1, 0.0, 0.0, -R,
-        x_fineparts, y_fineparts, z_fineparts, rx_hashsize, reaction_hash);
+        x_fineparts, y_fineparts, z_fineparts, rxn_pairs);
 
   return shead1;
 }
@@ -716,7 +717,7 @@ pretend_to_call_diffuse_3D_big_list: /* Label to allow fake recursion */
       if (psl->head == NULL) {
         *psl_head = psl->next;
         ht_remove(&sv->mol_by_species, psl);
-        mem_put(sv->local_storage->pslv, psl);
+        collect_species_list(sv->local_storage, psl);
         continue;
       } else
         psl_head = &psl->next;
@@ -732,9 +733,8 @@ pretend_to_call_diffuse_3D_big_list: /* Label to allow fake recursion */
           ((psl->properties->flags & CAN_VOLVOLSURF) == CAN_VOLVOLSURF);
 
       if (col_bi_molecular_flag &&
-          !trigger_bimolecular_preliminary(
-               world->reaction_hash, world->rx_hashsize, spec->hashval,
-               psl->properties->hashval, spec, psl->properties))
+          !trigger_bimolecular_preliminary(&world->rxn_pairs, spec,
+                                           psl->properties))
         col_bi_molecular_flag = 0;
 
       /* What types of collisions are we concerned with for this molecule type?
@@ -789,8 +789,7 @@ pretend_to_call_diffuse_3D_big_list: /* Label to allow fake recursion */
       shead_exp = expand_collision_partner_list(
           m, &displacement, sv, world->rx_radius_3d, world->x_fineparts,
           world->y_fineparts, world->z_fineparts, world->nx_parts,
-          world->ny_parts, world->nz_parts, world->rx_hashsize,
-          world->reaction_hash);
+          world->ny_parts, world->nz_parts, &world->rxn_pairs);
 
       if (stail != NULL)
         stail->next = shead_exp;
@@ -836,8 +835,7 @@ pretend_to_call_diffuse_3D_big_list: /* Label to allow fake recursion */
         shead_exp = expand_collision_partner_list(
             m, &displacement, sv, world->rx_radius_3d, world->x_fineparts,
             world->y_fineparts, world->z_fineparts, world->nx_parts,
-            world->ny_parts, world->nz_parts, world->rx_hashsize,
-            world->reaction_hash);
+            world->ny_parts, world->nz_parts, &world->rxn_pairs);
 
         /* combine two collision lists */
         if (shead_exp != NULL) {
@@ -914,9 +912,9 @@ pretend_to_call_diffuse_3D_big_list: /* Label to allow fake recursion */
           is_reflec_flag = 0;
 
           num_matching_rxns = trigger_intersect(
-              world->reaction_hash, world->rx_hashsize, world->all_mols,
-              world->all_volume_mols, world->all_surface_mols, spec->hashval,
-              (struct abstract_molecule *)m, k, w, matching_rxns, 1, 1, 0);
+              &world->rxn_pairs, world->all_mols, world->all_volume_mols,
+              world->all_surface_mols, (struct abstract_molecule *)m, k, w,
+              matching_rxns, 1, 1, 0);
 
           if (num_matching_rxns > 0) {
             for (int ii = 0; ii < num_matching_rxns; ii++) {
@@ -936,6 +934,7 @@ pretend_to_call_diffuse_3D_big_list: /* Label to allow fake recursion */
             m->pos.x = smash->loc.x;
             m->pos.y = smash->loc.y;
             m->pos.z = smash->loc.z;
+            update_packed_position(m);
             m->t += t_steps * smash->t;
             reflectee = w;
 
@@ -968,6 +967,7 @@ pretend_to_call_diffuse_3D_big_list: /* Label to allow fake recursion */
           m->pos.x = smash->loc.x;
           m->pos.y = smash->loc.y;
           m->pos.z = smash->loc.z;
+          update_packed_position(m);
           m->t += t_steps * smash->t;
           reflectee = w;
 
@@ -997,6 +997,7 @@ pretend_to_call_diffuse_3D_big_list: /* Label to allow fake recursion */
         m->pos.x = smash->loc.x;
         m->pos.y = smash->loc.y;
         m->pos.z = smash->loc.z;
+        update_packed_position(m);
 
         displacement.x *= (1.0 - smash->t);
         displacement.y *= (1.0 - smash->t);
@@ -1080,8 +1081,7 @@ pretend_to_call_diffuse_3D_big_list: /* Label to allow fake recursion */
 
       if (moving_bi_molecular_flag && ((smash->what & COLLIDE_VOL) != 0)) {
         num_matching_rxns = trigger_bimolecular(
-            world->reaction_hash, world->rx_hashsize, spec->hashval,
-            mp->properties->hashval, (struct abstract_molecule *)m,
+            &world->rxn_pairs, (struct abstract_molecule *)m,
             (struct abstract_molecule *)mp, 0, 0, matching_rxns);
 
         if (num_matching_rxns > 0) {
@@ -1255,8 +1255,7 @@ pretend_to_call_diffuse_3D_big_list: /* Label to allow fake recursion */
             sm = w->grid->mol[j];
             // look for bimolecular reactions between volume and surface mols
             num_matching_rxns = trigger_bimolecular(
-                world->reaction_hash, world->rx_hashsize, spec->hashval,
-                sm->properties->hashval, (struct abstract_molecule *)m,
+                &world->rxn_pairs, (struct abstract_molecule *)m,
                 (struct abstract_molecule *)sm, k, sm->orient, matching_rxns);
             if (num_matching_rxns > 0) {
               for (i = 0; i < num_matching_rxns; i++) {
@@ -1299,11 +1298,12 @@ pretend_to_call_diffuse_3D_big_list: /* Label to allow fake recursion */
               struct surface_molecule *smp; /* Neighboring molecules */
               struct tile_neighbor *tile_nbr_head = NULL, *curr;
               int list_length = 0;
+              int own_list; /* did we make tile_nbr_head ourselves? */
 
               if ((sm->flags & COMPLEX_MEMBER) == 0) {
                 /* find neighbor molecules to react with */
-                find_neighbor_tiles(world, sm, sm->grid, sm->grid_index, 0, 1,
-                                    &tile_nbr_head, &list_length);
+                own_list = neighbor_tiles_for_reactant(
+                    world, sm, &tile_nbr_head, &list_length);
                 if (tile_nbr_head != NULL) {
                   double local_prob_factor; /*local probability factor for the
                                                reaction */
@@ -1371,7 +1371,7 @@ pretend_to_call_diffuse_3D_big_list: /* Label to allow fake recursion */
                       }
                     }
                   }
-                  if (tile_nbr_head != NULL)
+                  if (own_list)
                     delete_tile_neighbor_list(tile_nbr_head);
                 }
               }
@@ -1386,9 +1386,9 @@ pretend_to_call_diffuse_3D_big_list: /* Label to allow fake recursion */
 
         /*  m->index = -1;  */
         num_matching_rxns = trigger_intersect(
-            world->reaction_hash, world->rx_hashsize, world->all_mols,
-            world->all_volume_mols, world->all_surface_mols, spec->hashval,
-            (struct abstract_molecule *)m, k, w, matching_rxns, 1, 1, 0);
+            &world->rxn_pairs, world->all_mols, world->all_volume_mols,
+            world->all_surface_mols, (struct abstract_molecule *)m, k, w,
+            matching_rxns, 1, 1, 0);
 
         for (i = 0; i < num_matching_rxns; i++) {
           rx = matching_rxns[i];
@@ -1602,7 +1602,7 @@ pretend_to_call_diffuse_3D_big_list: /* Label to allow fake recursion */
           }
 
           if (rx->n_pathways == RX_TRANSP) {
-            rx->n_occurred++;
+            count_add_llong(world, &rx->n_occurred, 1);
             if ((m->flags & COUNT_ME) != 0 &&
                 (spec->flags & COUNT_SOME_MASK) != 0) {
               /* Count as far up as we can unambiguously */
@@ -1721,6 +1721,7 @@ pretend_to_call_diffuse_3D_big_list: /* Label to allow fake recursion */
   m->pos.x += displacement.x;
   m->pos.y += displacement.y;
   m->pos.z += displacement.z;
+  update_packed_position(m);
   m->t += t_steps;
 
   m->index = -1;
@@ -1767,6 +1768,7 @@ struct surface_molecule *react_2D_trimol_all_neighbors(
   struct tile_neighbor *tile_nbr_head_f = NULL, *tile_nbr_head_s = NULL,
                        *curr_f, *curr_s;
   int list_length_f, list_length_s; /* length of the linked lists above */
+  int own_list_f, own_list_s; /* did we make those lists ourselves? */
 
   if (sm->flags & COMPLEX_MEMBER) {
     mcell_internal_error("Trimolecular reaction between macromolecule and two "
@@ -1794,8 +1796,8 @@ struct surface_molecule *react_2D_trimol_all_neighbors(
   }
 
   /* find first level neighbor molecules to react with */
-  find_neighbor_tiles(world, sm, sm->grid, sm->grid_index, 0, 1,
-                      &tile_nbr_head_f, &list_length_f);
+  own_list_f = neighbor_tiles_for_reactant(world, sm, &tile_nbr_head_f,
+                                           &list_length_f);
 
   if (tile_nbr_head_f == NULL)
     return sm;
@@ -1833,8 +1835,8 @@ struct surface_molecule *react_2D_trimol_all_neighbors(
     }
 
     /* find nearest neighbor molecules to react with (2nd level) */
-    find_neighbor_tiles(world, gm_f, gm_f->grid, gm_f->grid_index, 0, 1,
-                        &tile_nbr_head_s, &list_length_s);
+    own_list_s = neighbor_tiles_for_reactant(world, gm_f, &tile_nbr_head_s,
+                                             &list_length_s);
 
     if (tile_nbr_head_s == NULL)
       continue;
@@ -1914,11 +1916,11 @@ struct surface_molecule *react_2D_trimol_all_neighbors(
         n += num_matching_rxns;
       }
     }
-    if (tile_nbr_head_s != NULL)
+    if (own_list_s)
       delete_tile_neighbor_list(tile_nbr_head_s);
   }
 
-  if (tile_nbr_head_f != NULL)
+  if (own_list_f)
     delete_tile_neighbor_list(tile_nbr_head_f);
 
   if (n > max_size)
@@ -343,6 +343,20 @@ int create_grid(struct volume *world, struct wall *w, struct subvolume *guess) {
   for (unsigned int i = 0; i < sg->n_tiles; i++)
     sg->mol[i] = NULL;
 
+  /* every tile starts out free */
+  unsigned int n_words = (sg->n_tiles + 63) / 64;
+  sg->free_tiles = CHECKED_MALLOC_ARRAY(unsigned long long, n_words,
+                                        "surface grid");
+  sg->free_words = CHECKED_MALLOC_ARRAY(unsigned long long, (n_words + 63) / 64,
+                                        "surface grid");
+  memset(sg->free_tiles, 0, n_words * sizeof(unsigned long long));
+  memset(sg->free_words, 0, (n_words + 63) / 64 * sizeof(unsigned long long));
+  for (unsigned int i = 0; i < sg->n_tiles; i++)
+    mark_free_tile(sg, i);
+
+  sg->adjacency = NULL;
+  sg->no_adjacency = 0;
+
   w->grid = sg;
 
   return 0;
@@ -487,6 +501,83 @@ void grid_neighbors(struct volume *world, struct surface_grid *grid, int idx,
   }
 }
 
+/*************************************************************************
+mark_free_tile:
+  In: a surface grid
+      index of a tile on that grid that has just been emptied
+  Out: No return value.  The tile is marked in the grid's bit set of tiles
+       that may be free.
+  Note: Every place that empties a tile must call this.  Tiles that fill
+        up keep their bit until nearest_free next looks at them.
+  Note: A grid may span storages running on different threads, so the
+        bit sets are only changed atomically.
+*************************************************************************/
+void mark_free_tile(struct surface_grid *g, unsigned int idx) {
+  unsigned int word = idx / 64;
+  __atomic_fetch_or(&g->free_tiles[word], 1ULL << (idx % 64),
+                    __ATOMIC_SEQ_CST);
+  __atomic_fetch_or(&g->free_words[word / 64], 1ULL << (word % 64),
+                    __ATOMIC_SEQ_CST);
+}
+
+/*************************************************************************
+lowest_bit:
+  In: a non-zero word
+  Out: the index of its lowest set bit
+*************************************************************************/
+static int lowest_bit(unsigned long long bits) {
+  static const int de_bruijn_index[64] = {
+    0,  1,  48, 2,  57, 49, 28, 3,  61, 58, 50, 42, 38, 29, 17, 4,
+    62, 55, 59, 36, 53, 51, 43, 22, 45, 39, 33, 30, 24, 18, 12, 5,
+    63, 47, 56, 27, 60, 41, 37, 16, 54, 35, 52, 21, 44, 32, 23, 11,
+    46, 26, 40, 15, 34, 20, 31, 10, 25, 14, 19, 9,  13, 8,  7,  6
+  };
+  return de_bruijn_index[((bits & -bits) * 0x03f79d71b4cb0a89ULL) >> 58];
+}
+
+/*************************************************************************
+next_free_tile:
+  In: a surface grid
+      first and last tile index to look at
+  Out: the lowest index in that range whose tile may be free, or -1
+  Note: Words of the bit set found empty are dropped from the summary.
+        If mark_free_tile fills the word meanwhile, the second look at it
+        puts it back.
+*************************************************************************/
+static int next_free_tile(struct surface_grid *g, int from, int to) {
+  while (from <= to) {
+    int word = from / 64;
+    unsigned long long *summary = &g->free_words[word / 64];
+    unsigned long long summary_bits =
+        __atomic_load_n(summary, __ATOMIC_RELAXED);
+    if (summary_bits == 0) {
+      from = (word / 64 + 1) * 64 * 64;
+      continue;
+    }
+    if ((summary_bits & (1ULL << (word % 64))) == 0) {
+      from = (word + 1) * 64;
+      continue;
+    }
+
+    unsigned long long *tiles = &g->free_tiles[word];
+    unsigned long long bits = __atomic_load_n(tiles, __ATOMIC_RELAXED);
+    if ((bits >> (from % 64)) == 0) {
+      if (bits == 0) {
+        __atomic_fetch_and(summary, ~(1ULL << (word % 64)), __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(tiles, __ATOMIC_SEQ_CST) != 0)
+          __atomic_fetch_or(summary, 1ULL << (word % 64), __ATOMIC_SEQ_CST);
+      }
+      from = (word + 1) * 64;
+      continue;
+    }
+    bits >>= from % 64;
+
+    from += lowest_bit(bits);
+    return (from <= to) ? from : -1;
+  }
+  return -1;
+}
+
 /*************************************************************************
 nearest_free:
   In: a surface grid
@@ -496,15 +587,17 @@ nearest_free:
        to the vector, or -1 if no unoccupied points are found in range
   Note: we assume you've already checked the grid element that contains
         the point, so we don't bother looking there first.
-  Note: if no unoccupied tile is found, found_dist2 contains distance to
-        closest occupied tile.
+  Note: if no unoccupied tile is found, found_dist2 is larger than max_d2.
+  Note: Only the tiles that the grid's bit set says may be free are
+        visited, and in each strip only those within reach along u.
+        A bit found stale is cleared; if the tile was emptied meanwhile,
+        the second look at it puts the bit back.
 *************************************************************************/
 
 int nearest_free(struct surface_grid *g, struct vector2 *v, double max_d2,
                  double *found_dist2) {
   int h, i, j, k;
   int span;
-  int can_flip;
   int idx;
   double d2;
   double f, ff, fff;
@@ -519,6 +612,10 @@ int nearest_free(struct surface_grid *g, struct vector2 *v, double max_d2,
   idx = -1;
   d2 = 2 * max_d2 + 1.0;
 
+  /* width of a tile along u, and how far along u we may look */
+  double step = g->surface->uv_vert1_u / (double)(g->n);
+  double reach = sqrt(max_d2);
+
   for (k = 0; k < g->n; k++) {
     f = v->v - ((double)(3 * k + 1)) * over3n * g->surface->uv_vert2.v;
     ff = f - over3n * g->surface->uv_vert2.v;
@@ -528,30 +625,54 @@ int nearest_free(struct surface_grid *g, struct vector2 *v, double max_d2,
       continue; /* Entire strip is too far away */
 
     span = (g->n - k);
-    for (j = 0; j < span; j++) {
-      can_flip = (j != span - 1);
-      for (i = 0; i <= can_flip; i++) {
-        fff =
-            v->u - over3n * ((double)(3 * j + i + 1) * g->surface->uv_vert1_u +
+
+    /* Tile j of the strip is centred at j * step plus one of these
+       offsets along u; skip the tiles that are out of reach, with one
+       tile to spare for roundoff. */
+    int j_lo = 0, j_hi = span - 1;
+    if (step > 0.0 && reach < step * span) {
+      double c0 = over3n * (g->surface->uv_vert1_u +
+                            (double)(3 * k + 1) * g->surface->uv_vert2.u);
+      double c1 = over3n * (2.0 * g->surface->uv_vert1_u +
+                            (double)(3 * k + 2) * g->surface->uv_vert2.u);
+      double lo = (v->u - reach - max2d(c0, c1)) / step - 1.0;
+      double hi = (v->u + reach - min2d(c0, c1)) / step + 1.0;
+      if (lo > 0.0)
+        j_lo = (lo < span) ? (int)lo : span;
+      if (hi < span - 1)
+        j_hi = (hi > -1.0) ? (int)hi + 1 : -1;
+    }
+    if (j_lo > j_hi)
+      continue;
+
+    int first = (span - 1) * (span - 1);
+    int last = first + 2 * j_hi + 1;
+    if (last > first + 2 * span - 2)
+      last = first + 2 * span - 2;
+
+    for (h = next_free_tile(g, first + 2 * j_lo, last); h != -1;
+         h = next_free_tile(g, h + 1, last)) {
+      if (__atomic_load_n(&g->mol[h], __ATOMIC_SEQ_CST) != NULL) {
+        __atomic_fetch_and(&g->free_tiles[h / 64], ~(1ULL << (h % 64)),
+                           __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&g->mol[h], __ATOMIC_SEQ_CST) != NULL)
+          continue;
+        mark_free_tile(g, h);
+      }
+
+      j = (h - first) / 2;
+      i = (h - first) % 2;
+      fff = v->u - over3n * ((double)(3 * j + i + 1) * g->surface->uv_vert1_u +
                              (double)(3 * k + i + 1) * g->surface->uv_vert2.u);
-        fff *= fff;
-        if (i)
-          fff += ff;
-        else
-          fff += f;
-
-        if (fff < max_d2 && (idx == -1 || fff < d2)) {
-          h = (g->n - k) - 1;
-          h = h * h + 2 * j + i;
-
-          if (g->mol[h] == NULL) {
-            idx = h;
-            d2 = fff;
-          } else if (idx == -1) {
-            if (fff < d2)
-              d2 = fff;
-          }
-        }
+      fff *= fff;
+      if (i)
+        fff += ff;
+      else
+        fff += f;
+
+      if (fff < max_d2 && (idx == -1 || fff < d2)) {
+        idx = h;
+        d2 = fff;
       }
     }
   }
@@ -2969,4 +3090,271 @@ void find_neighbor_tiles(struct volume *world, struct surface_molecule *sm,
   *list_length = tmp_list_length;
 }
 
+/**************************************************************************
+free_tile_adjacency:
+  In: a tile adjacency table
+  Out: No return value.  The table is freed.
+****************************************************************************/
+static void free_tile_adjacency(struct tile_adjacency *adj) {
+  free(adj->start);
+  free(adj->nbrs);
+  free(adj->pending);
+  free(adj);
+}
+
+/**************************************************************************
+find_pending_walls:
+  In: world: simulation state
+      adj: tile adjacency table being built for grid
+      grid: a surface grid
+  Out: No return value.  The walls next to the grid's wall that have no
+       grid yet, and so gave no neighbour tiles, are stored in the table.
+****************************************************************************/
+static void find_pending_walls(struct volume *world,
+                               struct tile_adjacency *adj,
+                               struct surface_grid *grid) {
+  struct wall *walls[3];
+  int n_walls = 0;
+  for (int kk = 0; kk < 3; kk++) {
+    struct wall *w = grid->surface->nb_walls[kk];
+    if (w != NULL && w->grid == NULL)
+      walls[n_walls++] = w;
+  }
+
+  /* walls that share only a vertex matter to the corner tiles */
+  long long shared_vert[3] = { -1, -1, -1 };
+  for (unsigned int idx = 0; idx < grid->n_tiles; idx++) {
+    if (!is_inner_tile(grid, idx) && is_corner_tile(grid, idx))
+      find_shared_vertices_corner_tile_parent_wall(world, grid, idx,
+                                                   shared_vert);
+  }
+  struct wall_list *wall_nbr_head =
+      find_nbr_walls_shared_one_vertex(world, grid->surface, shared_vert);
+
+  int n_vert_walls = 0;
+  for (struct wall_list *wl = wall_nbr_head; wl != NULL; wl = wl->next) {
+    if (wl->this_wall->grid == NULL)
+      n_vert_walls++;
+  }
+
+  if (n_walls + n_vert_walls > 0) {
+    adj->pending = CHECKED_MALLOC_ARRAY(struct wall *, n_walls + n_vert_walls,
+                                        "tile adjacency table");
+    for (int kk = 0; kk < n_walls; kk++)
+      adj->pending[adj->n_pending++] = walls[kk];
+    for (struct wall_list *wl = wall_nbr_head; wl != NULL; wl = wl->next) {
+      if (wl->this_wall->grid == NULL)
+        adj->pending[adj->n_pending++] = wl->this_wall;
+    }
+    adj->bytes += adj->n_pending * sizeof(struct wall *);
+  }
+
+  if (wall_nbr_head != NULL)
+    delete_wall_list(wall_nbr_head);
+}
+
+/**************************************************************************
+build_tile_adjacency:
+  In: world: simulation state
+      grid: a surface grid
+      budget: the most bytes the table may take
+  Out: The adjacency table of the grid, or NULL if it would take more than
+       budget bytes.  Each tile gets the neighbours that find_neighbor_tiles
+       finds for a reactant search that may not create grids, in the same
+       order.
+****************************************************************************/
+static struct tile_adjacency *build_tile_adjacency(struct volume *world,
+                                                   struct surface_grid *grid,
+                                                   size_t budget) {
+  if (sizeof(struct tile_adjacency) +
+          (grid->n_tiles + 1) * sizeof(unsigned int) > budget)
+    return NULL;
+
+  struct tile_adjacency *adj =
+      CHECKED_MALLOC_STRUCT(struct tile_adjacency, "tile adjacency table");
+  adj->start = CHECKED_MALLOC_ARRAY(unsigned int, grid->n_tiles + 1,
+                                    "tile adjacency table");
+  adj->nbrs = NULL;
+  adj->n_pending = 0;
+  adj->pending = NULL;
+  adj->bytes = sizeof(struct tile_adjacency) +
+               (grid->n_tiles + 1) * sizeof(unsigned int);
+
+  unsigned int n_nbrs = 0, max_nbrs = 0;
+  for (unsigned int idx = 0; idx < grid->n_tiles; idx++) {
+    struct tile_neighbor *tile_nbr_head = NULL;
+    int list_length = 0;
+    find_neighbor_tiles(world, NULL, grid, idx, 0, 1, &tile_nbr_head,
+                        &list_length);
+
+    adj->start[idx] = n_nbrs;
+    if (n_nbrs + list_length > max_nbrs) {
+      if (adj->bytes + (n_nbrs + list_length) * sizeof(struct tile_neighbor) >
+          budget) {
+        delete_tile_neighbor_list(tile_nbr_head);
+        free_tile_adjacency(adj);
+        return NULL;
+      }
+      max_nbrs = 2 * max_nbrs + list_length;
+      adj->nbrs = (struct tile_neighbor *)realloc(
+          adj->nbrs, max_nbrs * sizeof(struct tile_neighbor));
+      if (adj->nbrs == NULL)
+        mcell_allocfailed("Failed to allocate tile adjacency table.");
+    }
+
+    for (struct tile_neighbor *tn = tile_nbr_head; tn != NULL; tn = tn->next)
+      adj->nbrs[n_nbrs++] = *tn;
+    delete_tile_neighbor_list(tile_nbr_head);
+  }
+  adj->start[grid->n_tiles] = n_nbrs;
+
+  if (n_nbrs > 0 && n_nbrs < max_nbrs) {
+    adj->nbrs = (struct tile_neighbor *)realloc(
+        adj->nbrs, n_nbrs * sizeof(struct tile_neighbor));
+    if (adj->nbrs == NULL)
+      mcell_allocfailed("Failed to allocate tile adjacency table.");
+  }
+  adj->bytes += n_nbrs * sizeof(struct tile_neighbor);
+
+  /* link each tile's neighbours in their own list */
+  for (unsigned int idx = 0; idx < grid->n_tiles; idx++) {
+    for (unsigned int k = adj->start[idx]; k < adj->start[idx + 1]; k++) {
+      adj->nbrs[k].next =
+          (k + 1 < adj->start[idx + 1]) ? &adj->nbrs[k + 1] : NULL;
+    }
+  }
+
+  find_pending_walls(world, adj, grid);
+  if (adj->bytes > budget) {
+    free_tile_adjacency(adj);
+    return NULL;
+  }
+
+  return adj;
+}
+
+/**************************************************************************
+tile_adjacency_is_stale:
+  In: a tile adjacency table
+  Out: 1 if a neighbour wall that had no grid when the table was built has
+       one now, 0 otherwise
+****************************************************************************/
+static int tile_adjacency_is_stale(struct tile_adjacency *adj) {
+  for (int kk = 0; kk < adj->n_pending; kk++) {
+    if (adj->pending[kk]->grid != NULL)
+      return 1;
+  }
+  return 0;
+}
+
+/**************************************************************************
+reserve_adjacency_bytes:
+  In: world: the shared simulation state
+      bytes: size of a tile adjacency table
+  Out: 1 if the bytes were taken from the world's adjacency budget, 0 if
+       too few are left.  Any number of workers may call this at once.
+****************************************************************************/
+static int reserve_adjacency_bytes(struct volume *world, size_t bytes) {
+  size_t left = __atomic_load_n(&world->adjacency_budget, __ATOMIC_RELAXED);
+  do {
+    if (left < bytes)
+      return 0;
+  } while (!__atomic_compare_exchange_n(&world->adjacency_budget, &left,
+                                        left - bytes, 1, __ATOMIC_RELAXED,
+                                        __ATOMIC_RELAXED));
+  return 1;
+}
+
+/**************************************************************************
+neighbor_tiles_for_reactant:
+  In: world: simulation state
+      sm: surface molecule looking for reaction partners
+      tile_nbr_head: list of neighbor tiles of sm's tile (return value)
+      list_length: length of that list (return value)
+  Out: 1 if the list was made for this call and must be freed with
+       delete_tile_neighbor_list, 0 if it belongs to the grid's adjacency
+       table and must be left alone.
+  Note: Gives the same list as find_neighbor_tiles(world, sm, sm->grid,
+        sm->grid_index, 0, 1, ...).  The grid's adjacency table is built on
+        first use and rebuilt once a neighbour wall that had no grid gets
+        one.  Molecules that can meet region borders see neighbours that
+        depend on the molecule, so they still take the slow path, as do
+        grids whose table would not fit in what is left of the world's
+        budget.
+****************************************************************************/
+int neighbor_tiles_for_reactant(struct volume *world,
+                                struct surface_molecule *sm,
+                                struct tile_neighbor **tile_nbr_head,
+                                int *list_length) {
+  struct surface_grid *grid = sm->grid;
+
+  if ((sm->properties->flags & CAN_REGION_BORDER) ||
+      __atomic_load_n(&grid->no_adjacency, __ATOMIC_RELAXED) ||
+      !world->create_shared_walls_info_flag) {
+    find_neighbor_tiles(world, sm, grid, sm->grid_index, 0, 1, tile_nbr_head,
+                        list_length);
+    return 1;
+  }
+
+  struct tile_adjacency *adj =
+      __atomic_load_n(&grid->adjacency, __ATOMIC_ACQUIRE);
+  if (adj == NULL || tile_adjacency_is_stale(adj)) {
+    /* A grid may be reached from storages running on different threads, so
+       two of them may build its table at once; the first to publish it
+       wins.  Tables only go stale while grids are still being created on
+       demand, which never happens once worker threads are running, so no
+       reader can hold a list from a table freed here. */
+    struct volume *shared =
+        (world->shared_world != NULL) ? world->shared_world : world;
+    struct tile_adjacency *old = adj;
+    adj = NULL;
+    if (!__atomic_load_n(&grid->no_adjacency, __ATOMIC_RELAXED)) {
+      adj = build_tile_adjacency(
+          world, grid,
+          __atomic_load_n(&shared->adjacency_budget, __ATOMIC_RELAXED));
+      if (adj != NULL && !reserve_adjacency_bytes(shared, adj->bytes)) {
+        free_tile_adjacency(adj);
+        adj = NULL;
+      }
+    }
+
+    if (adj == NULL) {
+      __atomic_store_n(&grid->no_adjacency, 1, __ATOMIC_RELAXED);
+      if (old != NULL &&
+          __atomic_compare_exchange_n(&grid->adjacency, &old, NULL, 0,
+                                      __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        __atomic_fetch_add(&shared->adjacency_budget, old->bytes,
+                           __ATOMIC_RELAXED);
+        free_tile_adjacency(old);
+      }
+    } else if (__atomic_compare_exchange_n(&grid->adjacency, &old, adj, 0,
+                                           __ATOMIC_ACQ_REL,
+                                           __ATOMIC_ACQUIRE)) {
+      if (old != NULL) {
+        __atomic_fetch_add(&shared->adjacency_budget, old->bytes,
+                           __ATOMIC_RELAXED);
+        free_tile_adjacency(old);
+      }
+    } else {
+      /* Another thread got there first; "old" now holds its table */
+      __atomic_fetch_add(&shared->adjacency_budget, adj->bytes,
+                         __ATOMIC_RELAXED);
+      free_tile_adjacency(adj);
+      adj = old;
+    }
+
+    if (adj == NULL) {
+      find_neighbor_tiles(world, sm, grid, sm->grid_index, 0, 1,
+                          tile_nbr_head, list_length);
+      return 1;
+    }
+  }
+
+  unsigned int begin = adj->start[sm->grid_index];
+  unsigned int end = adj->start[sm->grid_index + 1];
+  *tile_nbr_head = (end > begin) ? &adj->nbrs[begin] : NULL;
+  *list_length = end - begin;
+  return 0;
+}
+
 
@@ -36,6 +36,20 @@ struct tile_neighbor {
   struct tile_neighbor *next;
 };
 
+/* Bytes all tile adjacency tables together may take */
+#define TILE_ADJACENCY_BUDGET (256 << 20)
+
+/* Neighbour tiles of every tile of a surface grid, as found for a reactant
+   search; the neighbours of tile i are nbrs[start[i]] up to nbrs[start[i+1]]
+   and are linked through their next pointers. */
+struct tile_adjacency {
+  unsigned int *start;        /* n_tiles+1 offsets into nbrs */
+  struct tile_neighbor *nbrs; /* Neighbours of all tiles */
+  int n_pending;              /* Number of walls in pending */
+  struct wall **pending;      /* Neighbour walls that had no grid yet */
+  size_t bytes;               /* Memory charged to the storage's budget */
+};
+
 void xyz2uv(struct vector3 *a, struct wall *w, struct vector2 *b);
 
 void uv2xyz(struct vector2 *a, struct wall *w, struct vector3 *b);
@@ -59,6 +73,8 @@ void grid_neighbors(struct volume *world, struct surface_grid *grid, int idx,
                     int create_grid_flag, struct surface_grid **nb_grid,
                     int *nb_idx);
 
+void mark_free_tile(struct surface_grid *g, unsigned int idx);
+
 int nearest_free(struct surface_grid *sm, struct vector2 *v, double max_d2,
                  double *found_dist2);
 
@@ -107,6 +123,11 @@ void find_neighbor_tiles(struct volume *world, struct surface_molecule *sm,
                          struct tile_neighbor **tile_nbr_head,
                          int *list_length);
 
+int neighbor_tiles_for_reactant(struct volume *world,
+                                struct surface_molecule *sm,
+                                struct tile_neighbor **tile_nbr_head,
+                                int *list_length);
+
 void grid_all_neighbors_for_inner_tile(struct volume *world,
                                        struct surface_grid *grid, int idx,
                                        struct vector2 *pos,
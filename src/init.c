@@ -79,6 +79,8 @@ static int compute_bb_polygon_object(struct volume *world, struct object *objp,
 
 static int init_species_defaults(struct volume *world);
 static int init_regions_helper(struct volume *world);
+static int index_surf_class_sets(struct volume *world, struct object *objp);
+static int init_surf_unimol_table(struct volume *world);
 
 static struct ccn_clamp_data* find_clamped_object_in_list(struct ccn_clamp_data *ccd,
   struct object *obj);
@@ -112,6 +114,8 @@ int init_notifications(struct volume *world) {
     world->notify->volume_output_report = NOTIFY_NONE;
     world->notify->viz_output_report = NOTIFY_NONE;
     world->notify->molecule_collision_report = NOTIFY_NONE;
+    world->notify->memory_pool_report = NOTIFY_NONE;
+    world->notify->memory_pool_report_value = 0;
   } else {
     world->notify->progress_report = NOTIFY_FULL;
     world->notify->diffusion_constants = NOTIFY_BRIEF;
@@ -131,6 +135,8 @@ int init_notifications(struct volume *world) {
     world->notify->volume_output_report = NOTIFY_NONE;
     world->notify->viz_output_report = NOTIFY_NONE;
     world->notify->molecule_collision_report = NOTIFY_NONE;
+    world->notify->memory_pool_report = NOTIFY_NONE;
+    world->notify->memory_pool_report_value = 0;
   }
   /* Warnings */
   world->notify->neg_diffusion = WARN_WARN;
@@ -281,6 +287,7 @@ int init_variables(struct volume *world) {
   world->r_step_release = NULL;
   world->d_step = NULL;
   world->dissociation_index = DISSOCIATION_MAX;
+  world->adjacency_budget = TILE_ADJACENCY_BUDGET;
   world->place_waypoints_flag = 0;
   world->count_scheduler = NULL;
   world->volume_output_scheduler = NULL;
@@ -297,6 +304,7 @@ int init_variables(struct volume *world) {
   world->mem_part_y = 14;
   world->mem_part_z = 14;
   world->mem_part_pool = 0;
+  world->mem_compact_interval = 0;
   world->complex_placement_attempts = 100;
   world->all_vertices = NULL;
   world->walls_using_vertex = NULL;
@@ -613,6 +621,95 @@ int init_species(struct volume *world) {
   return 0;
 }
 
+/***********************************************************************
+ *
+ * initialize the table of reactions by pair of species
+ *
+ * Each reaction of two or more reactants is listed under its first two
+ * players (both ways round) if it sits in the reaction_hash chain those
+ * players hash to, which is the chain the trigger functions used to walk.
+ * Each species also gets the bit set of the species it has any such
+ * reaction with.
+ *
+ ***********************************************************************/
+int init_rxn_pairs(struct volume *world) {
+  struct rxn_pair_table *pairs = &world->rxn_pairs;
+  int n = world->n_species;
+  u_int mask = world->rx_hashsize - 1;
+
+  pairs->n_species = n;
+  pairs->first = (int *)calloc((size_t)n * n + 1, sizeof(int));
+  if (pairs->first == NULL) {
+    mcell_allocfailed_nodie("Failed to allocate reaction pair table.");
+    return 1;
+  }
+
+  /* Count the reactions of each pair one entry up, then fill them in */
+  int n_rxns = 0;
+  for (int pass = 0; pass < 2; pass++) {
+    for (int i = 0; i < world->rx_hashsize; i++) {
+      for (struct rxn *rx = world->reaction_hash[i]; rx != NULL;
+           rx = rx->next) {
+        if (rx->n_reactants < 2)
+          continue;
+
+        struct species *a = rx->players[0];
+        struct species *b = rx->players[1];
+        if (((a->hashval + b->hashval) & mask) != (u_int)i)
+          continue;
+        if (a->species_id >= (u_int)n || b->species_id >= (u_int)n ||
+            world->species_list[a->species_id] != a ||
+            world->species_list[b->species_id] != b)
+          mcell_internal_error("Reaction '%s' has a player missing from the "
+                               "species table.",
+                               rx->sym->name);
+
+        int ab = a->species_id * n + b->species_id;
+        int ba = b->species_id * n + a->species_id;
+        if (pass == 0) {
+          pairs->first[ab + 1]++;
+          if (ba != ab)
+            pairs->first[ba + 1]++;
+        } else {
+          pairs->rxns[pairs->first[ab]++] = rx;
+          if (ba != ab)
+            pairs->rxns[pairs->first[ba]++] = rx;
+        }
+      }
+    }
+
+    if (pass == 0) {
+      for (int k = 0; k < n * n; k++)
+        pairs->first[k + 1] += pairs->first[k];
+      n_rxns = pairs->first[n * n];
+      pairs->rxns = CHECKED_MALLOC_ARRAY_NODIE(struct rxn *, n_rxns + 1,
+                                               "reaction pair table");
+      if (pairs->rxns == NULL)
+        return 1;
+    }
+  }
+
+  /* Filling in moved each entry up to the start of the next pair */
+  memmove(pairs->first + 1, pairs->first, (size_t)n * n * sizeof(int));
+  pairs->first[0] = 0;
+
+  pairs->partner_words = (n + 63) / 64;
+  pairs->partners = (unsigned long long *)calloc(
+      (size_t)n * pairs->partner_words, sizeof(unsigned long long));
+  if (pairs->partners == NULL) {
+    mcell_allocfailed_nodie("Failed to allocate reaction partner sets.");
+    return 1;
+  }
+  for (int a = 0; a < n; a++) {
+    unsigned long long *partners = pairs->partners + a * pairs->partner_words;
+    for (int b = 0; b < n; b++) {
+      if (pairs->first[a * n + b] < pairs->first[a * n + b + 1])
+        partners[b / 64] |= 1ULL << (b % 64);
+    }
+  }
+  return 0;
+}
+
 /***********************************************************************
  *
  * initialize the models' vertices and walls
@@ -694,6 +791,11 @@ int init_vertices_walls(struct volume *world) {
                       "among partitions.");
     return 1;
   }
+  if (build_wall_trees(world)) {
+    mcell_error_nodie("Out of memory while indexing the walls of each "
+                      "partition.");
+    return 1;
+  }
 
   if (world->notify->progress_report != NOTIFY_NONE)
     mcell_log("Creating edges...");
@@ -722,6 +824,12 @@ int init_regions(struct volume *world) {
     return 1;
   }
 
+  if (init_surf_unimol_table(world)) {
+    mcell_error_nodie("Unknown error while tabulating surface class "
+                      "reactions.");
+    return 1;
+  }
+
   if (check_counter_geometry(world->count_hashmask, world->count_hash,
                              &world->place_waypoints_flag)) {
     mcell_error_nodie(
@@ -1036,9 +1144,10 @@ int reschedule_release_events(struct volume *world) {
   struct reschedule_helper *helper = NULL;
   for (struct schedule_helper *sh = world->releaser; sh != NULL; sh = sh->next_scale) {
     for (int i = -1; i < sh->buf_len; i++) {
-      for (struct abstract_element *ae = (i == -1) ? sh->current : sh->circ_buf_head[i];
-        ae != NULL; ae = ae->next) {
-        struct release_event_queue *req = (struct release_event_queue *)ae;
+      struct sched_bucket *slot = schedule_slot(sh, i);
+      for (int k = 0; k < slot->count; k++) {
+        struct release_event_queue *req =
+          (struct release_event_queue *)sched_bucket_item(slot, k);
         struct reschedule_helper *tmp =
           CHECKED_MALLOC_STRUCT(struct reschedule_helper,
             "Error creating reschedule helper");
@@ -1498,6 +1607,12 @@ static struct storage *create_storage(struct volume *world, int nsubvols) {
                                            "per species list")) == NULL)
     mcell_allocfailed(
         "Failed to create memory pool for per-species molecule lists.");
+  if ((shared_mem->pend = create_mem_named(sizeof(struct pending_step), 32,
+                                           "pending step")) == NULL)
+    mcell_allocfailed("Failed to create memory pool for pending steps.");
+
+  /* Scratch pools are shared; a worker thread lends its own to a storage
+   * while running it (see run_storage in thread_util.c) */
   shared_mem->coll = world->coll_mem;
   shared_mem->sp_coll = world->sp_coll_mem;
   shared_mem->tri_coll = world->tri_coll_mem;
@@ -1509,6 +1624,12 @@ static struct storage *create_storage(struct volume *world, int nsubvols) {
     shared_mem->current_time = 0.0;
   }
 
+  /* Storages run by the thread pool draw from their own streams (seeded by
+   * seed_storage_rngs) */
+  if (world->num_threads > 0)
+    shared_mem->rng = CHECKED_MALLOC_STRUCT(struct rng_state,
+                                            "storage random number stream");
+
   if (world->time_step_max == 0.0)
     shared_mem->max_timestep = MICROSEC_PER_YEAR;
   else {
@@ -1631,6 +1752,9 @@ int init_partitions(struct volume *world) {
                                           "exact disk vertex")) == NULL)
     mcell_allocfailed(
         "Failed to create memory pool for exact disk calculation vertices.");
+  world->surf_rxn_scratch = CHECKED_MALLOC_STRUCT(
+      struct surf_rxn_scratch, "surface reaction scratch space");
+  memset(world->surf_rxn_scratch, 0, sizeof(struct surf_rxn_scratch));
 
   /* How many storage subdivisions along each axis? */
   int nx = (world->nx_parts + (world->mem_part_x) - 2) / (world->mem_part_x);
@@ -1658,6 +1782,14 @@ int init_partitions(struct volume *world) {
       yd = (world->ny_parts - 1) % world->mem_part_y;
     if (cz == nz - 1)
       zd = (world->nz_parts - 1) % world->mem_part_z;
+
+    /* Allocate this storage */
+    if ((shared_mem[i] = create_storage(world, xd * yd * zd)) == NULL)
+      mcell_internal_error("Unknown error while creating a storage.");
+    shared_mem[i]->grid_x = cx;
+    shared_mem[i]->grid_y = cy;
+    shared_mem[i]->grid_z = cz;
+
     if (++cx == nx) {
       cx = 0;
       if (++cy == ny) {
@@ -1666,10 +1798,6 @@ int init_partitions(struct volume *world) {
       }
     }
 
-    /* Allocate this storage */
-    if ((shared_mem[i] = create_storage(world, xd * yd * zd)) == NULL)
-      mcell_internal_error("Unknown error while creating a storage.");
-
     /* Add to the storage list */
     struct storage_list *l = (struct storage_list *)CHECKED_MEM_GET(
         world->storage_allocator, "storage list item");
@@ -1677,6 +1805,7 @@ int init_partitions(struct volume *world) {
     l->store = shared_mem[i];
     world->storage_head = l;
   }
+  seed_storage_rngs(world);
 
   /* Initialize each subvolume */
   for (int i = 0; i < world->nx_parts - 1; i++)
@@ -1685,9 +1814,14 @@ int init_partitions(struct volume *world) {
         int h = k + (world->nz_parts - 1) * (j + (world->ny_parts - 1) * i);
         struct subvolume *sv = &(world->subvol[h]);
         sv->wall_head = NULL;
+        sv->wall_pack = NULL;
+        sv->wall_tree = NULL;
+        sv->wall_field = NULL;
         memset(&sv->mol_by_species, 0, sizeof(struct pointer_hash));
         sv->species_head = NULL;
         sv->mol_count = 0;
+        sv->mol_epoch = 0;
+        sv->candidates = NULL;
 
         sv->llf.x = bisect_near(world->x_fineparts, world->n_fineparts,
                                 world->x_partitions[i]);
@@ -1728,6 +1862,23 @@ int init_partitions(struct volume *world) {
   return 0;
 }
 
+/*******************************************************************
+ seed_storage_rngs:
+    In:  world: simulation state
+    Out: No return value.  Each storage's random number stream is restarted
+         from the random sequence number and the storage's position in the
+         storage list, so a storage draws the same numbers no matter which
+         thread runs it.
+ *******************************************************************/
+void seed_storage_rngs(struct volume *world) {
+  unsigned int stream = 0;
+  for (struct storage_list *sl = world->storage_head; sl != NULL;
+       sl = sl->next, ++stream) {
+    if (sl->store->rng != NULL)
+      rng_init(sl->store->rng, rng_stream_seed(world->seed_seq, stream));
+  }
+}
+
 /**
  * Initializes the bounding boxes of the world.
  */
@@ -2193,6 +2344,35 @@ static int compute_bb_release_site(struct volume *world, struct object *objp,
   return 0;
 }
 
+/**
+ * Records a vertex of the geometry, in world coordinates, for
+ * set_auto_partitions to place adaptive partitions by.
+ * Used by compute_bb_polygon_object().
+ */
+static int add_partition_sample(struct volume *world, double x, double y,
+                                double z) {
+  if (world->n_partition_samples == world->max_partition_samples) {
+    int max_samples = (world->max_partition_samples == 0)
+                          ? 1024
+                          : 2 * world->max_partition_samples;
+    struct vector3 *samples = (struct vector3 *)realloc(
+        world->partition_samples, max_samples * sizeof(struct vector3));
+    if (samples == NULL) {
+      mcell_allocfailed_nodie("Failed to store vertices for adaptive "
+                              "partitioning.");
+      return 1;
+    }
+    world->partition_samples = samples;
+    world->max_partition_samples = max_samples;
+  }
+
+  struct vector3 *v = &world->partition_samples[world->n_partition_samples++];
+  v->x = x;
+  v->y = y;
+  v->z = z;
+  return 0;
+}
+
 /**
  * Updates the bounding box of the world based on the size
  * and location of a polygon_object.  Also updates the vertices in
@@ -2213,6 +2393,9 @@ static int compute_bb_polygon_object(struct volume *world, struct object *objp,
     p[0][2] = vl->vertex->z;
     p[0][3] = 1.0;
     mult_matrix(p, im, p, 1, 4, 4);
+    if (world->adaptive_partitions &&
+        add_partition_sample(world, p[0][0], p[0][1], p[0][2]))
+      return 1;
     if (p[0][0] < world->bb_llf.x)
       world->bb_llf.x = p[0][0];
     if (p[0][1] < world->bb_llf.y)
@@ -2389,6 +2572,8 @@ int instance_obj_regions(struct volume *world, struct object *objp) {
     if (init_wall_regions(world->length_unit, world->clamp_list,
                           world->species_list, world->n_species, objp))
       return 1;
+    if (index_surf_class_sets(world, objp))
+      return 1;
     break;
 
   case VOXEL_OBJ:
@@ -2399,6 +2584,135 @@ int instance_obj_regions(struct volume *world, struct object *objp) {
   return 0;
 }
 
+/***********************************************************************
+ *
+ * give each wall of an object the index of its list of surface classes
+ * among the distinct lists seen so far, adding new lists as they turn up
+ *
+ * Two walls share an index only if their lists hold the same surface
+ * classes in the same order, as the order decides which reaction a given
+ * random number picks.  Set 0 stands for walls without surface classes.
+ *
+ ***********************************************************************/
+static int index_surf_class_sets(struct volume *world, struct object *objp) {
+  struct surf_unimol_table *table = &world->surf_unimol;
+  if (table->n_sets == 0)
+    table->n_sets = 1;
+
+  for (int n_wall = 0; n_wall < objp->n_walls; n_wall++) {
+    struct wall *w = objp->wall_p[n_wall];
+    if (w == NULL)
+      continue;
+
+    w->surf_class_set = 0;
+    if (w->surf_class_head == NULL)
+      continue;
+
+    for (int set = 1; set < table->n_sets; set++) {
+      struct wall *other = table->sets[set];
+      if (other->num_surf_classes != w->num_surf_classes)
+        continue;
+
+      struct surf_class_list *a = w->surf_class_head;
+      struct surf_class_list *b = other->surf_class_head;
+      while (a != NULL && b != NULL && a->surf_class == b->surf_class) {
+        a = a->next;
+        b = b->next;
+      }
+      if (a == NULL && b == NULL) {
+        w->surf_class_set = set;
+        break;
+      }
+    }
+    if (w->surf_class_set != 0)
+      continue;
+
+    if (table->n_sets >= table->max_sets) {
+      int max_sets = (table->max_sets > 0) ? 2 * table->max_sets : 16;
+      struct wall **sets = (struct wall **)realloc(
+          table->sets, (size_t)max_sets * sizeof(struct wall *));
+      if (sets == NULL) {
+        mcell_allocfailed_nodie("Failed to allocate surface class sets.");
+        return 1;
+      }
+      sets[0] = NULL;
+      table->sets = sets;
+      table->max_sets = max_sets;
+    }
+    w->surf_class_set = table->n_sets;
+    table->sets[table->n_sets++] = w;
+  }
+  return 0;
+}
+
+/***********************************************************************
+ *
+ * initialize the table of unimolecular reactions of surface molecules
+ * with the surface classes of their wall
+ *
+ * For each distinct list of surface classes, each species that can react
+ * with a surface class and each orientation, the reactions are those
+ * trigger_surface_unimol finds for such a molecule on a wall with that
+ * list.  Molecules of other species are never looked up.
+ *
+ ***********************************************************************/
+static int init_surf_unimol_table(struct volume *world) {
+  struct surf_unimol_table *table = &world->surf_unimol;
+  int n = world->n_species;
+  if (table->n_sets == 0)
+    table->n_sets = 1;
+  int n_entries = table->n_sets * n * 2;
+
+  table->n_species = n;
+  table->first = (int *)calloc((size_t)n_entries + 1, sizeof(int));
+  if (table->first == NULL) {
+    mcell_allocfailed_nodie("Failed to allocate surface class reaction "
+                            "table.");
+    return 1;
+  }
+
+  /* Count the reactions of each entry one entry up, then fill them in */
+  struct rxn *matching_rxns[MAX_MATCHING_RXNS];
+  struct surface_molecule sm;
+  memset(&sm, 0, sizeof(struct surface_molecule));
+  sm.flags = TYPE_SURF;
+  for (int pass = 0; pass < 2; pass++) {
+    for (int set = 1; set < table->n_sets; set++) {
+      for (int i = 0; i < n; i++) {
+        struct species *sp = world->species_list[i];
+        if ((sp->flags & (ON_GRID | CAN_SURFWALL)) != (ON_GRID | CAN_SURFWALL))
+          continue;
+
+        sm.properties = sp;
+        for (int up = 0; up < 2; up++) {
+          int entry = (set * n + i) * 2 + up;
+          sm.orient = up ? 1 : -1;
+          int num_matching_rxns = trigger_intersect(
+              &world->rxn_pairs, world->all_mols, world->all_volume_mols,
+              world->all_surface_mols, (struct abstract_molecule *)&sm,
+              sm.orient, table->sets[set], matching_rxns, 0, 0, 0);
+          if (pass == 0)
+            table->first[entry + 1] = num_matching_rxns;
+          else
+            memcpy(table->rxns + table->first[entry], matching_rxns,
+                   (size_t)num_matching_rxns * sizeof(struct rxn *));
+        }
+      }
+    }
+
+    if (pass == 0) {
+      for (int k = 0; k < n_entries; k++)
+        table->first[k + 1] += table->first[k];
+      table->rxns = CHECKED_MALLOC_ARRAY_NODIE(
+          struct rxn *, table->first[n_entries] + 1,
+          "surface class reaction table");
+      if (table->rxns == NULL)
+        return 1;
+    }
+  }
+  return 0;
+}
+
 /**
  * Initialize data associated with wall regions.
  * This function is called during wall instantiation Pass #3
@@ -3462,6 +3776,8 @@ int init_surf_mols_by_number(struct volume *world, struct object *objp,
                 for (unsigned int n_tile = 0; n_tile < sg->n_tiles; ++n_tile) {
                   if (sg->mol[n_tile] != NULL)
                     sg->n_occupied++;
+                  else
+                    mark_free_tile(sg, n_tile);
                 }
               }
             }
@@ -3612,6 +3928,8 @@ int init_surf_mols_by_number(struct volume *world, struct object *objp,
                        ++n_tile) {
                     if (sg->mol[n_tile] != NULL)
                       sg->n_occupied++;
+                    else
+                      mark_free_tile(sg, n_tile);
                   }
                 }
               }
@@ -4157,15 +4475,14 @@ init_releases:
 ***************************************************************************/
 int init_releases(struct schedule_helper *releaser) {
   struct release_event_queue *req;
-  struct abstract_element *ae;
   struct schedule_helper *sh;
   int i;
 
   for (sh = releaser; sh != NULL; sh = sh->next_scale) {
     for (i = -1; i < sh->buf_len; i++) {
-      for (ae = (i == -1) ? sh->current : sh->circ_buf_head[i]; ae != NULL;
-           ae = ae->next) {
-        req = (struct release_event_queue *)ae;
+      struct sched_bucket *slot = schedule_slot(sh, i);
+      for (int k = 0; k < slot->count; k++) {
+        req = (struct release_event_queue *)sched_bucket_item(slot, k);
         switch ((int)req->release_site->release_shape) {
         case SHAPE_REGION:
           if (req->release_site->mol_type == NULL)
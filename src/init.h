@@ -30,8 +30,11 @@ int init_notifications(struct volume *world);
 int init_variables(struct volume *world);
 int init_data_structures(struct volume *world);
 int init_species(struct volume *world);
+int init_rxn_pairs(struct volume *world);
 int init_bounding_box(struct volume *world);
 int init_partitions(struct volume *world);
+
+void seed_storage_rngs(struct volume *world);
 int init_vertices_walls(struct volume *world);
 int init_regions(struct volume *world);
 int init_checkpoint_state(struct volume *world, long long *exec_iterations);
@@ -595,6 +595,7 @@ static int macro_place_subunits_grid(struct volume *world,
           unit->cmplx = NULL;
           if (unit->grid != NULL && unit->grid->mol[unit->grid_index] == unit) {
             unit->grid->mol[unit->grid_index] = NULL;
+            mark_free_tile(unit->grid, unit->grid_index);
             --unit->grid->n_occupied;
           }
 
@@ -47,6 +47,7 @@
 #include "mcell_init.h"
 #include "mcell_misc.h"
 #include "mcell_reactions.h"
+#include "thread_util.h"
 
 /* simple wrapper for executing the supplied function call. In case
  * of an error returns with MCELL_FAIL and prints out error_message */
@@ -93,6 +94,8 @@ MCELL_STATE *mcell_create() {
 #endif
 
   state->procnum = 0;
+  state->num_threads = 0; /* no thread pool unless -threads is given */
+  state->batch_diffusion = 0;
   state->rx_hashsize = 0;
   state->iterations = INT_MIN; /* indicates iterations not set */
   state->chkpt_infile = NULL;
@@ -175,6 +178,9 @@ mcell_init_simulation(MCELL_STATE *state) {
 
   CHECKED_CALL(init_species(state), "Error initializing species.");
 
+  CHECKED_CALL(init_rxn_pairs(state),
+               "Error initializing reaction pair table.");
+
   if (has_micro_rev_and_trimol_rxns(state->species_list, state->n_species,
     state->volume_reversibility, state->surface_reversibility)) {
     mcell_error("Tri-molecular reactions can not be combined with microscopic "
@@ -209,6 +215,8 @@ mcell_init_simulation(MCELL_STATE *state) {
       &state->counter_by_name, state->output_block_head),
       "Error while initializing counter name hash.");
 
+  CHECKED_CALL(init_thread_pool(state), "Error while starting worker threads.");
+
   return MCELL_SUCCESS;
 }
 
@@ -43,6 +43,7 @@
 #include "init.h"
 #include "chkpt.h"
 #include "argparse.h"
+#include "thread_util.h"
 
 #include "mcell_run.h"
 
@@ -384,6 +385,14 @@ mcell_run_iteration(MCELL_STATE *world, long long frequency,
       mcell_log_raw("\n");
     }
 
+    /* Produce memory pool report */
+    if (world->notify->memory_pool_report_value > 0 &&
+        world->current_iterations % world->notify->memory_pool_report_value ==
+            0) {
+      mcell_log("Iteration %lld:", world->current_iterations);
+      mem_dump_pool_stats(mcell_get_log_file());
+    }
+
     /* Check for a checkpoint on this iteration */
     if (world->chkpt_iterations && world->current_iterations != world->start_iterations &&
         ((world->current_iterations - world->start_iterations) % world->chkpt_iterations == 0)) {
@@ -409,6 +418,11 @@ mcell_run_iteration(MCELL_STATE *world, long long frequency,
   // reset this flag to zero
   *restarted_from_checkpoint = 0;
 
+  /* Re-pack the volume molecules now and then */
+  if (world->mem_compact_interval > 0 && world->current_iterations > 0 &&
+      world->current_iterations % world->mem_compact_interval == 0)
+    compact_volume_molecules(world);
+
   run_concentration_clamp(world, world->current_iterations);
 
   double next_release_time;
@@ -427,15 +441,20 @@ mcell_run_iteration(MCELL_STATE *world, long long frequency,
 
   while (world->storage_head != NULL &&
          world->storage_head->store->current_time <= not_yet) {
-    int done = 0;
-    while (!done) {
-      done = 1;
-      for (struct storage_list *local = world->storage_head; local != NULL;
-           local = local->next) {
-        if (local->store->timer->current != NULL) {
-          run_timestep(world, local->store, next_barrier,
-                       (double)world->iterations + 1.0);
-          done = 0;
+    if (world->thread_pool != NULL) {
+      run_storages_in_parallel(world, next_barrier,
+                               (double)world->iterations + 1.0);
+    } else {
+      int done = 0;
+      while (!done) {
+        done = 1;
+        for (struct storage_list *local = world->storage_head; local != NULL;
+             local = local->next) {
+          if (schedule_has_current(local->store->timer)) {
+            run_timestep(world, local->store, next_barrier,
+                         (double)world->iterations + 1.0);
+            done = 0;
+          }
         }
       }
     }
@@ -628,7 +647,8 @@ mcell_print_final_statistics(MCELL_STATE *world) {
     if (world->diffusion_number > 0)
       mcell_log("Average diffusion jump was %.2f timesteps\n",
                 world->diffusion_cumtime / (double)world->diffusion_number);
-    mcell_log("Total number of random number use: %lld", rng_uses(world->rng));
+    mcell_log("Total number of random number use: %lld",
+              rng_uses(world->rng) + storage_rng_uses(world));
     mcell_log("Total number of ray-subvolume intersection tests: %lld",
               world->ray_voxel_tests);
     mcell_log("Total number of ray-polygon intersection tests: %lld",
@@ -674,5 +694,8 @@ mcell_print_final_statistics(MCELL_STATE *world) {
               (long)difftime(t_end, world->t_start));
   }
 
+  if (world->notify->memory_pool_report == NOTIFY_FULL)
+    mem_dump_pool_stats(mcell_get_log_file());
+
   return 0;
 }
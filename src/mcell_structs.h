@@ -585,6 +585,26 @@ struct per_species_list {
   struct per_species_list *next; /* pointer to next p-s-l */
   struct species *properties;    /* species for items in this bin */
   struct volume_molecule *head;  /* linked list of mols */
+
+  /* The same molecules again, with their positions packed by coordinate so
+   * that proximity scans only touch coordinates */
+  int n_mols;                    /* Number of molecules in the arrays */
+  int max_mols;                  /* Allocated length of the arrays */
+  double *x, *y, *z;             /* Positions of the molecules */
+  struct volume_molecule **mols; /* The molecules themselves */
+};
+
+/* Volume molecules that molecules of one species may react with in a
+   subvolume, kept while no molecule enters or leaves it */
+struct candidate_cache {
+  struct candidate_cache *next;  /* Cache for the next species */
+  struct species *properties;    /* Species of the moving molecules */
+  int complex_member;            /* Nonzero for moving COMPLEX_MEMBERs */
+  unsigned long epoch;           /* Subvolume's mol_epoch when filled */
+  int n_candidates;              /* Number of (molecule, reaction) pairs */
+  int max_candidates;            /* Allocated length of the arrays */
+  struct volume_molecule **mols; /* Molecule of each pair */
+  struct rxn **rxns;             /* Reaction of each pair */
 };
 
 /* Properties of one type of molecule or surface */
@@ -660,6 +680,36 @@ struct rxn {
   struct pathway_info *info;    /* Counts and names for each pathway */
 };
 
+/* The reactions between each pair of species, so that colliding molecules
+ * can find theirs without walking a reaction_hash chain */
+struct rxn_pair_table {
+  int n_species;     /* Species are indexed by species_id */
+  int *first;        /* Where each pair's reactions start in rxns; pair (a, b)
+                        is entry a * n_species + b, and one more entry marks
+                        the end */
+  struct rxn **rxns; /* Reactions with at least two reactants, in the order
+                        of their reaction_hash chains */
+  int partner_words; /* Words in the bit set of each species' partners */
+  unsigned long long *partners; /* Bit set for each species of the species it
+                                   has reactions with, so that molecules it
+                                   cannot react with are skipped cheaply */
+};
+
+/* Unimolecular reactions of surface molecules with the surface classes of
+   their wall, worked out once for each distinct list of surface classes */
+struct surf_unimol_table {
+  int n_sets;          /* Distinct lists of surface classes on walls */
+  int max_sets;        /* Room in sets */
+  struct wall **sets;  /* A wall with each list (NULL for set 0, no classes) */
+  int n_species;       /* Species are indexed by species_id */
+  int *first;          /* Where the reactions of each set, species and
+                          orientation start in rxns; entry
+                          (set * n_species + species) * 2 + (orient > 0), and
+                          one more entry marks the end (NULL until built) */
+  struct rxn **rxns;   /* Reactions in the order trigger_surface_unimol finds
+                          them */
+};
+
 /* User-defined name of a reaction pathway */
 struct rxn_pathname {
   struct sym_entry *sym;    /* Ptr to symbol table entry for this rxn name */
@@ -756,6 +806,9 @@ struct volume_molecule {
 
   struct volume_molecule **prev_v; /* Previous molecule in this subvolume */
   struct volume_molecule *next_v;  /* Next molecule in this subvolume */
+
+  struct per_species_list *psl; /* List we are in, or NULL if none */
+  int psl_slot;                 /* Our index in the list's packed arrays */
 };
 
 /* Fixed molecule on a grid on a surface */
@@ -799,6 +852,8 @@ struct wall {
   surf_class_head; /* linked list of surface classes for this wall (multiple
                       surface classes may come from the overlapping regions */
   int num_surf_classes; /* number of attached surface classes */
+  int surf_class_set;   /* Index of this wall's list of surface classes among
+                           the distinct lists (see surf_unimol_table) */
 
   int side; /* index of this wall in its parent object */
 
@@ -867,9 +922,19 @@ struct surface_grid {
   u_int n_occupied; /* Number of tiles occupied by surface_molecules */
   struct surface_molecule **mol; /* Array of pointers to surface_molecule for
                                     each tile */
+  unsigned long long *free_tiles; /* Bit set of the tiles that may be free
+                                     (see mark_free_tile) */
+  unsigned long long *free_words; /* Bit set of the words of free_tiles that
+                                     may be non-zero */
 
   struct subvolume *subvol; /* Best match for which subvolume we're in */
   struct wall *surface;     /* The wall that we are in */
+
+  struct tile_adjacency *adjacency; /* Neighbour tiles of every tile for
+                                       reactant searches, built on first use
+                                       (see neighbor_tiles_for_reactant) */
+  int no_adjacency; /* Set if the adjacency table did not fit in its
+                       storage's budget */
 };
 
 /* 3D vector of integers */
@@ -888,6 +953,44 @@ struct waypoint {
   antiregions; /* We are outside of (but hit) these regions */
 };
 
+/* A volume molecule whose diffusion step was interrupted at the edge of a
+   storage while storages were running in parallel.  The storage the molecule
+   moved into finishes the step. */
+struct pending_step {
+  struct pending_step *next;
+  struct volume_molecule *vm;   /* Molecule in mid-step */
+  struct subvolume *subvol;     /* Subvolume the molecule is moving into */
+  struct mem_helper *birthplace; /* Pool this record came from */
+  struct vector3 displacement;  /* Remaining displacement */
+  struct vector3 displacement2; /* Displacement after unbinding (see
+                                   diffuse_3D) */
+  double t_steps;               /* Time left in this step */
+  double r_rate_factor;         /* Rate scaling for this step */
+  double sched_time;            /* Scheduling time when the step began */
+  int inertness;                /* Unbinding state (see diffuse_3D) */
+};
+
+/* Kinds of count_update */
+enum count_update_kind {
+  COUNT_UPDATE_DOUBLE, /* Add value to the double at target */
+  COUNT_UPDATE_INT,    /* Add value to the int at target */
+  COUNT_UPDATE_UINT,   /* Add value to the u_int at target */
+  COUNT_UPDATE_LLONG,  /* Add value to the long long at target */
+  COUNT_UPDATE_TRIGGER /* Fire the trigger counter at target */
+};
+
+/* An update of a shared count made while a storage runs on a worker thread,
+   held back until the end of the iteration (see apply_count_updates) */
+struct count_update {
+  void *target;       /* Field to add to, or trigger counter */
+  double value;       /* Amount to add, or event time */
+  struct vector3 loc; /* Where the trigger event happened */
+  int n;              /* Number of trigger events (or hit direction) */
+  short orient;       /* Orientation of the triggering molecule */
+  byte what;          /* Report Type Flags of the trigger event */
+  byte kind;          /* enum count_update_kind */
+};
+
 /* Contains local memory and scheduler for molecules, walls, wall_lists, etc. */
 struct storage {
   struct mem_helper *list;    /* Wall lists */
@@ -903,6 +1006,7 @@ struct storage {
   struct mem_helper *regl;     /* Region lists */
   struct mem_helper *exdv; /* Vertex lists for exact interaction disk area */
   struct mem_helper *pslv; /* Per-species-lists for vol mols */
+  struct mem_helper *pend; /* Steps handed over from neighbouring storages */
 
   struct wall *wall_head; /* Locally stored walls */
   int wall_count;         /* How many local walls? */
@@ -911,6 +1015,23 @@ struct storage {
   struct schedule_helper *timer; /* Local scheduler */
   double current_time;           /* Local time */
   double max_timestep;           /* Local maximum timestep */
+
+  int grid_x, grid_y, grid_z;    /* Position in the grid of storages */
+  struct pending_step *inbound;  /* Steps waiting to be finished here; only
+                                    touched through queue_pending_step and
+                                    take_pending_steps */
+
+  struct rng_state *rng; /* Random number stream used while running on a
+                            worker thread */
+  int index;             /* Position in the storage list */
+  u_long next_mol_id;    /* Next molecule id used while running on a worker
+                            thread; ids step by the number of storages */
+  int dissociation_index; /* Dissociation index used while running on a
+                             worker thread; steps like next_mol_id */
+  struct count_update *counts; /* Updates of shared counts made by the
+                                  last run on a worker thread */
+  int n_counts;
+  int max_counts;
 };
 
 /* Linked list of storage areas. */
@@ -920,12 +1041,78 @@ struct storage_list {
 };
 
 /* Walls and molecules in a spatial subvolume */
+/* Node of a wall_tree.  An inner node's left child follows it directly. */
+struct wall_tree_node {
+  struct vector3 llf; /* Lower left front corner of the walls below */
+  struct vector3 urb; /* Upper right back corner of the walls below */
+  int first;          /* Leaf: first entry in leaf_walls; inner: right child */
+  int count;          /* Leaf: number of walls; 0 for inner nodes */
+};
+
+/* Bounding volume hierarchy over the walls of a subvolume, so that a ray
+ * need only be tested against the walls whose bounds its line passes
+ * through */
+struct wall_tree {
+  int *leaf_walls;              /* Indices into wall_pack, grouped by leaf */
+  struct wall_tree_node *nodes; /* The tree, root first */
+};
+
+/* The planes of a subvolume's walls, packed by coordinate so that a ray
+ * can be tested against several walls at once */
+struct wall_pack {
+  int n_walls;          /* Number of walls in the subvolume */
+  struct wall **walls;  /* The walls, in wall_head order */
+  double *nx, *ny, *nz; /* Normals of the walls */
+  double *d;            /* Distance of each wall's plane from the origin */
+};
+
+/* Cells along each axis of a wall_field */
+#define WALL_FIELD_CELLS 4
+
+/* Cell of a wall_field.  The wall nearest the cell is kept so that the
+ * distance to it can be measured from the point itself. */
+struct wall_field_cell {
+  struct wall *nearest; /* Wall with the smallest bound, or NULL if none */
+  double nearest_d2;    /* Lower bound on the squared distance to it */
+  double others_d2;     /* Lower bound on the squared distance to the rest */
+};
+
+/* Coarse grid over a subvolume bounding the distance from any point in a
+ * cell to the subvolume's walls */
+struct wall_field {
+  struct vector3 llf;   /* Lower left front corner of the subvolume */
+  struct vector3 scale; /* Cells per unit length along each axis */
+  struct wall_field_cell
+      cells[WALL_FIELD_CELLS * WALL_FIELD_CELLS * WALL_FIELD_CELLS];
+};
+
+/* Scratch space for the candidate reactions of react_2D_all_neighbors; each
+   thread needs its own */
+struct surf_rxn_scratch {
+  int max_items;                  /* Room in each array */
+  struct rxn **rxns;              /* Candidate reactions */
+  double *cf;                     /* Area correction factor of each */
+  struct surface_molecule **mols; /* Neighbor molecule of each */
+};
+
+/* Scratch space for walls_along_ray; each thread needs its own */
+struct wall_ray_scratch {
+  int *idx;                  /* Indices of walls still in the running */
+  unsigned long long *marks; /* Bit set of walls the tree found */
+  struct wall_list *walls;   /* The walls returned */
+};
+
 struct subvolume {
   struct wall_list *wall_head; /* Head of linked list of intersecting walls */
+  struct wall_pack *wall_pack; /* Those walls packed, or NULL if very few */
+  struct wall_tree *wall_tree; /* Tree over those walls, or NULL if few */
+  struct wall_field *wall_field; /* Distances to the walls, or NULL if none */
 
   struct pointer_hash mol_by_species; /* table of species->molecule list */
   struct per_species_list *species_head;
   int mol_count; /* How many molecules are here? */
+  unsigned long mol_epoch; /* Changes whenever a molecule enters or leaves */
+  struct candidate_cache *candidates; /* Reaction partners by species */
 
   struct int3D llf; /* Indices of left lower front corner */
   struct int3D urb; /* Indices of upper right back corner */
@@ -1025,11 +1212,17 @@ struct volume {
   double *x_partitions; /* Coarse X partition boundaries */
   double *y_partitions; /* Coarse Y partition boundaries */
   double *z_partitions; /* Coarse Z partition boundaries */
+  int adaptive_partitions; /* Crowd automatic partitions where walls are? */
+  int n_partition_samples; /* Wall vertices kept for adaptive partitions */
+  int max_partition_samples; /* Allocated length of partition_samples */
+  struct vector3 *partition_samples; /* The vertices (freed once used) */
   int mem_part_x; /* Granularity of memory-partition binning for the X-axis */
   int mem_part_y; /* Granularity of memory-partition binning for the Y-axis */
   int mem_part_z; /* Granularity of memory-partition binning for the Z-axis */
   int mem_part_pool; /* Scaling factor for sizes of memory pools in each
                         storage. */
+  long long mem_compact_interval; /* Iterations between re-packings of the
+                                     volume molecules (0: never) */
 
   /* Fine partitions are intended to allow subdivision of coarse partitions */
   /* Subdivision is not yet implemented */
@@ -1057,6 +1250,9 @@ struct volume {
   int rx_hashsize;            /* How many slots in our reaction hash table? */
   int n_reactions;            /* How many reactions are there, total? */
   struct rxn **reaction_hash; /* A hash table of all reactions. */
+  struct rxn_pair_table rxn_pairs; /* Reactions by pair of species */
+  struct surf_unimol_table surf_unimol; /* Surface-class reactions of surface
+                                           molecules by wall class list */
   struct mem_helper *tv_rxn_mem; /* Memory to store time-varying reactions */
 
   int count_hashmask;          /* Mask for looking up count hash table */
@@ -1210,6 +1406,22 @@ struct volume {
   long long last_timing_iteration; /* during the main run_iteration loop */
 
   int procnum;          /* Processor number for a parallel run */
+  int num_threads;      /* Worker threads used to run storages (0: serial) */
+  int batch_diffusion;  /* Step diffusing molecules in batches by species
+                           (see run_timestep) */
+  struct thread_pool *thread_pool; /* Workers (NULL if running serially) */
+  struct volume *shared_world; /* Set only in a worker's private copy of the
+                                  world: the world shared by all workers */
+  struct storage *active_storage; /* Storage a worker copy is running */
+  size_t adjacency_budget; /* Bytes left for tile adjacency tables; workers
+                              draw on the shared world's */
+
+  int max_packed_walls; /* Most walls in any wall_pack */
+  struct wall_ray_scratch ray_scratch; /* This thread's walls_along_ray
+                                          scratch */
+  struct surf_rxn_scratch *surf_rxn_scratch; /* This thread's
+                                                react_2D_all_neighbors
+                                                scratch */
   int quiet_flag;       /* Quiet mode */
   int with_checks_flag; /* Check geometry for overlapped walls? */
 
@@ -1284,6 +1496,18 @@ struct collision {
   struct vector3 loc;       /* Location of impact */
 };
 
+#define COLLISION_VECTOR_INLINE 32
+
+/* Collisions along one ray, stored contiguously.  The array starts out
+   inside the structure, which callers keep on their stack, and only moves
+   to the heap if it overflows (see ray_trace). */
+struct collision_vector {
+  int n_items;              /* Number of collisions stored */
+  int max_items;            /* Room in items */
+  struct collision *items;  /* inline_items, or heap memory */
+  struct collision inline_items[COLLISION_VECTOR_INLINE];
+};
+
 /* Special type of collision - used when moving molecule
    can engage in tri-molecular  collisions */
 struct sp_collision {
@@ -1458,6 +1682,8 @@ struct notifications {
   enum notify_level_t volume_output_report;   /* VOLUME_OUTPUT_REPORT */
   enum notify_level_t viz_output_report;      /* VIZ_OUTPUT_REPORT */
   enum notify_level_t molecule_collision_report; /* MOLECULE_COLLISION_REPORT */
+  enum notify_level_t memory_pool_report;     /* MEMORY_POOL_REPORT */
+  long long memory_pool_report_value;         /* MEMORY_POOL_REPORT */
 
   /* Warning stuff, possible values IGNORED, WARNING, ERROR */
   /* see corresponding keywords */
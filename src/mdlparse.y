@@ -157,6 +157,7 @@ struct macro_relation_state *relation_state;
 %token       ABSORPTIVE
 %token       ACCURATE_3D_REACTIONS
 %token       ACOS
+%token       ADAPTIVE_PARTITIONS
 %token       ALL_CROSSINGS
 %token       ALL_DATA
 %token       ALL_ELEMENTS
@@ -277,10 +278,12 @@ struct macro_relation_state *relation_state;
 %token       MAXIMUM_STEP_LENGTH
 %token       MEAN_DIAMETER
 %token       MEAN_NUMBER
+%token       MEMORY_COMPACTION_INTERVAL
 %token       MEMORY_PARTITION_X
 %token       MEMORY_PARTITION_Y
 %token       MEMORY_PARTITION_Z
 %token       MEMORY_PARTITION_POOL
+%token       MEMORY_POOL_REPORT
 %token       MESHES
 %token       MICROSCOPIC_REVERSIBILITY
 %token       MIN_TOK
@@ -1020,6 +1023,8 @@ notification_item_def:
                                                       }
       | ITERATION_REPORT '=' num_expr                 { if (!parse_state->vol->quiet_flag) CHECK(mdl_set_iteration_report_freq(parse_state, (long long) $3)); }
       | MOLECULE_COLLISION_REPORT '=' notify_bilevel    { if (!parse_state->vol->quiet_flag) parse_state->vol->notify->molecule_collision_report    = $3; }
+      | MEMORY_POOL_REPORT '=' notify_bilevel         { if (!parse_state->vol->quiet_flag) parse_state->vol->notify->memory_pool_report     = $3; }
+      | MEMORY_POOL_REPORT '=' num_expr               { if (!parse_state->vol->quiet_flag) CHECK(mdl_set_memory_pool_report_freq(parse_state, (long long) $3)); }
 ;
 
 notify_bilevel:
@@ -1124,10 +1129,12 @@ memory_partition_def:
         | MEMORY_PARTITION_Y '=' num_expr             { parse_state->vol->mem_part_y = (int) $3; }
         | MEMORY_PARTITION_Z '=' num_expr             { parse_state->vol->mem_part_z = (int) $3; }
         | MEMORY_PARTITION_POOL '=' num_expr          { parse_state->vol->mem_part_pool = (int) $3; }
+        | MEMORY_COMPACTION_INTERVAL '=' num_expr     { parse_state->vol->mem_compact_interval = (long long) $3; }
 ;
 
 partition_def:
           partition_dimension '=' array_value         { CHECK(mcell_set_partition(parse_state->vol, $1, & $3)); }
+        | ADAPTIVE_PARTITIONS '=' boolean             { parse_state->vol->adaptive_partitions = $3; }
 ;
 
 partition_dimension:
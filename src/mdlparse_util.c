@@ -1851,6 +1851,7 @@ void mdl_set_all_notifications(struct volume *vol, byte notify_value) {
   vol->notify->file_writes = notify_value;
   vol->notify->final_summary = notify_value;
   vol->notify->molecule_collision_report = notify_value;
+  vol->notify->memory_pool_report = notify_value;
 }
 
 /*************************************************************************
@@ -1877,6 +1878,27 @@ int mdl_set_iteration_report_freq(struct mdlparse_vars *parse_state,
   return 0;
 }
 
+/*************************************************************************
+ mdl_set_memory_pool_report_freq:
+    Set how often memory pool statistics are reported.  They are also
+    reported at the end of the run.
+
+ In:  parse_state: parser state
+      interval: report frequency to request
+ Out: 0 on success, 1 on failure
+*************************************************************************/
+int mdl_set_memory_pool_report_freq(struct mdlparse_vars *parse_state,
+                                    long long interval) {
+  if (interval < 1) {
+    mdlerror(parse_state,
+             "Invalid memory pool reporting interval: use value >= 1");
+    return 1;
+  }
+  parse_state->vol->notify->memory_pool_report_value = interval;
+  parse_state->vol->notify->memory_pool_report = NOTIFY_FULL;
+  return 0;
+}
+
 /*************************************************************************
  mdl_set_all_warnings:
     Set all warning levels to a particular value.  Corresponds to
@@ -188,6 +188,10 @@ void mdl_set_all_notifications(struct volume *vol, byte notify_value);
 int mdl_set_iteration_report_freq(struct mdlparse_vars *parse_state,
                                   long long interval);
 
+/* Set the memory pool report frequency. */
+int mdl_set_memory_pool_report_freq(struct mdlparse_vars *parse_state,
+                                    long long interval);
+
 /* Set all warning levels to a particular value. */
 void mdl_set_all_warnings(struct volume *vol, byte warning_level);
 
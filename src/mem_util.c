@@ -313,15 +313,20 @@ void mem_dump_stats(FILE *out) {
 
 #endif
 
+/* Every pool made by create_mem_named, newest first (see
+ * mem_dump_pool_stats) */
+static struct mem_helper *mem_pool_head = NULL;
+
 /*************************************************************************
-create_mem_named:
+create_mem_block:
    In: Size of a single element (including the leading "next" pointer)
        Number of elements to allocate at once
        Name of "arena" (used for statistics)
-   Out: Pointer to a new mem_helper struct.
+   Out: Pointer to a new mem_helper struct, not yet in the list of pools.
 *************************************************************************/
 
-struct mem_helper *create_mem_named(size_t size, int length, char const *name) {
+static struct mem_helper *create_mem_block(size_t size, int length,
+                                           char const *name) {
   struct mem_helper *mh;
   mh = (struct mem_helper *)Malloc(sizeof(struct mem_helper));
 
@@ -334,6 +339,13 @@ struct mem_helper *create_mem_named(size_t size, int length, char const *name) {
   mh->buf_index = 0;
   mh->defunct = NULL;
   mh->next_helper = NULL;
+  mh->name = name;
+  mh->live = 0;
+  mh->peak = 0;
+  mh->free_count = 0;
+  mh->blocks = 1;
+  mh->prev_pool = NULL;
+  mh->next_pool = NULL;
 
 #ifndef MEM_UTIL_NO_POOLING
 #ifdef MEM_UTIL_TRACK_FREED
@@ -366,13 +378,33 @@ struct mem_helper *create_mem_named(size_t size, int length, char const *name) {
     s->max_free = s->cur_free;
   if ((mem_cur_overall_wastage += size * length) > mem_max_overall_wastage)
     mem_max_overall_wastage = mem_cur_overall_wastage;
-#else
-  UNUSED(name);
 #endif
 
   return mh;
 }
 
+/*************************************************************************
+create_mem_named:
+   In: Size of a single element (including the leading "next" pointer)
+       Number of elements to allocate at once
+       Name of "arena" (used for statistics)
+   Out: Pointer to a new mem_helper struct.
+   Note: Not thread-safe; pools are created while setting up the
+         simulation.
+*************************************************************************/
+
+struct mem_helper *create_mem_named(size_t size, int length, char const *name) {
+  struct mem_helper *mh = create_mem_block(size, length, name);
+  if (mh == NULL)
+    return NULL;
+
+  mh->next_pool = mem_pool_head;
+  if (mem_pool_head != NULL)
+    mem_pool_head->prev_pool = mh;
+  mem_pool_head = mh;
+  return mh;
+}
+
 /*************************************************************************
 create_mem:
    In: Size of a single element (including the leading "next" pointer)
@@ -392,12 +424,17 @@ mem_get:
 
 void *mem_get(struct mem_helper *mh) {
 #ifdef MEM_UTIL_NO_POOLING
+  if (++mh->live > mh->peak)
+    mh->peak = mh->live;
   return malloc(mh->record_size);
 #else
   if (mh->defunct != NULL) {
     struct abstract_list *retval;
     retval = mh->defunct;
     mh->defunct = retval->next;
+    --mh->free_count;
+    if (++mh->live > mh->peak)
+      mh->peak = mh->live;
 #ifdef MEM_UTIL_KEEP_STATS
     struct mem_stats *s = mh->stats;
     --s->cur_free;
@@ -442,6 +479,8 @@ void *mem_get(struct mem_helper *mh) {
     size_t offset = mh->buf_index * mh->record_size;
 #endif
     mh->buf_index++;
+    if (++mh->live > mh->peak)
+      mh->peak = mh->live;
 #ifdef MEM_UTIL_KEEP_STATS
     struct mem_stats *s = mh->stats;
     --s->cur_free;
@@ -469,16 +508,17 @@ void *mem_get(struct mem_helper *mh) {
     unsigned char *temp;
 #ifdef MEM_UTIL_KEEP_STATS
     struct mem_stats *s = mh->stats;
-    mhnext = create_mem_named(mh->record_size, mh->buf_len, s->name);
+    mhnext = create_mem_block(mh->record_size, mh->buf_len, s->name);
     ++s->non_head_arenas;
     if (s->non_head_arenas > s->max_non_head_arenas)
       s->max_non_head_arenas = s->non_head_arenas;
     ++s->total_non_head_arenas;
 #else
-    mhnext = create_mem(mh->record_size, mh->buf_len);
+    mhnext = create_mem_block(mh->record_size, mh->buf_len, NULL);
 #endif
     if (mhnext == NULL)
       return NULL;
+    ++mh->blocks;
 
     /* Swap contents of this mem_helper with new one */
     /* Keeps mh at top of list but with freshly allocated space */
@@ -505,6 +545,7 @@ mem_put:
 *************************************************************************/
 
 void mem_put(struct mem_helper *mh, void *defunct) {
+  --mh->live;
 #ifdef MEM_UTIL_NO_POOLING
   free(defunct);
   return;
@@ -523,6 +564,7 @@ void mem_put(struct mem_helper *mh, void *defunct) {
 #endif
   data->next = mh->defunct;
   mh->defunct = data;
+  ++mh->free_count;
 #ifdef MEM_UTIL_KEEP_STATS
   struct mem_stats *s = mh->stats;
   ++s->cur_free;
@@ -554,6 +596,7 @@ void mem_put_list(struct mem_helper *mh, void *defunct) {
   for (alp = data; alp != NULL; alp = alpNext) {
     alpNext = alp->next;
     free(alp);
+    --mh->live;
   }
 #else
 #ifdef MEM_UTIL_ZERO_FREED
@@ -573,10 +616,12 @@ void mem_put_list(struct mem_helper *mh, void *defunct) {
     ptr[-1] = 0;
   }
 #endif
-#ifdef MEM_UTIL_KEEP_STATS
-  int count = 1;
+  long long count = 1;
   for (alp = data; alp->next != NULL; alp = alp->next)
     ++count;
+  mh->live -= count;
+  mh->free_count += count;
+#ifdef MEM_UTIL_KEEP_STATS
   struct mem_stats *s = mh->stats;
   s->cur_free += count;
   s->cur_alloc -= count;
@@ -586,9 +631,6 @@ void mem_put_list(struct mem_helper *mh, void *defunct) {
   if ((mem_cur_overall_wastage += mh->record_size * count) >
       mem_max_overall_wastage)
     mem_max_overall_wastage = mem_cur_overall_wastage;
-#else
-  for (alp = data; alp->next != NULL; alp = alp->next) {
-  }
 #endif
 
   alp->next = mh->defunct;
@@ -607,6 +649,12 @@ delete_mem:
 void delete_mem(struct mem_helper *mh) {
   if (mh == NULL)
     return;
+  if (mh->prev_pool != NULL)
+    mh->prev_pool->next_pool = mh->next_pool;
+  else if (mem_pool_head == mh)
+    mem_pool_head = mh->next_pool;
+  if (mh->next_pool != NULL)
+    mh->next_pool->prev_pool = mh->prev_pool;
 #ifndef MEM_UTIL_NO_POOLING
 #ifdef MEM_UTIL_KEEP_STATS
   struct mem_stats *s = mh->stats;
@@ -628,3 +676,124 @@ void delete_mem(struct mem_helper *mh) {
 #endif
   free(mh);
 }
+
+/*************************************************************************
+mem_exchange_blocks:
+   In: Two mem_helpers with the same record size
+   Out: No return value.  The blocks, free lists and usage counts of the
+        two are exchanged.  Each keeps its name and its place in the list
+        of pools, so records can be copied into a new pool and the new
+        blocks handed to the old pool in one step.
+*************************************************************************/
+
+void mem_exchange_blocks(struct mem_helper *a, struct mem_helper *b) {
+  struct mem_helper tmp = *a;
+
+  a->buf_len = b->buf_len;
+  a->buf_index = b->buf_index;
+  a->heap_array = b->heap_array;
+  a->defunct = b->defunct;
+  a->next_helper = b->next_helper;
+  a->live = b->live;
+  a->free_count = b->free_count;
+  a->blocks = b->blocks;
+
+  b->buf_len = tmp.buf_len;
+  b->buf_index = tmp.buf_index;
+  b->heap_array = tmp.heap_array;
+  b->defunct = tmp.defunct;
+  b->next_helper = tmp.next_helper;
+  b->live = tmp.live;
+  b->free_count = tmp.free_count;
+  b->blocks = tmp.blocks;
+
+  if (a->live > a->peak)
+    a->peak = a->live;
+  if (b->live > b->peak)
+    b->peak = b->live;
+}
+
+/* Totals over the pools of one name and record size */
+struct mem_pool_total {
+  char const *name;
+  size_t record_size;
+  long long pools;
+  long long blocks;
+  long long live;
+  long long peak;
+  long long free_count;
+  long long bytes;
+};
+
+static int compare_pool_totals(void const *a, void const *b) {
+  struct mem_pool_total const *ta = (struct mem_pool_total const *)a;
+  struct mem_pool_total const *tb = (struct mem_pool_total const *)b;
+  if (ta->bytes != tb->bytes)
+    return (ta->bytes < tb->bytes) ? 1 : -1;
+  return strcmp(ta->name, tb->name);
+}
+
+/*************************************************************************
+mem_dump_pool_stats:
+   In: Stream to write to
+   Out: No return value.  Pools with the same name and record size are
+        summed into one line, largest first: how many pools and blocks
+        there are, how many records are in use, the sum of each pool's
+        peak, how many records wait on free lists, and the memory held.
+   Note: Records returned to a pool other than the one they came from
+         are counted against the pool they were returned to.
+*************************************************************************/
+
+void mem_dump_pool_stats(FILE *out) {
+  struct mem_pool_total *totals = NULL;
+  int n_totals = 0, max_totals = 0;
+
+  for (struct mem_helper *mh = mem_pool_head; mh != NULL; mh = mh->next_pool) {
+    char const *name = (mh->name != NULL) ? mh->name : "(unnamed)";
+    int i;
+    for (i = 0; i < n_totals; i++) {
+      if (totals[i].record_size == mh->record_size &&
+          !strcmp(totals[i].name, name))
+        break;
+    }
+    if (i == n_totals) {
+      if (n_totals == max_totals) {
+        max_totals = (max_totals > 0) ? 2 * max_totals : 32;
+        struct mem_pool_total *bigger = (struct mem_pool_total *)realloc(
+            totals, max_totals * sizeof(struct mem_pool_total));
+        if (bigger == NULL) {
+          free(totals);
+          mcell_error_nodie("Out of memory while summarizing memory pools.");
+          return;
+        }
+        totals = bigger;
+      }
+      memset(&totals[i], 0, sizeof(struct mem_pool_total));
+      totals[i].name = name;
+      totals[i].record_size = mh->record_size;
+      ++n_totals;
+    }
+
+    struct mem_pool_total *t = &totals[i];
+    ++t->pools;
+    t->blocks += mh->blocks;
+    t->live += mh->live;
+    t->peak += mh->peak;
+    t->free_count += mh->free_count;
+    t->bytes += (long long)mh->blocks * mh->buf_len * mh->record_size;
+  }
+
+  qsort(totals, n_totals, sizeof(struct mem_pool_total), compare_pool_totals);
+
+  fprintf(out, "Memory pools:\n");
+  fprintf(out, "  %-26s %6s %7s %8s %12s %12s %12s %10s\n", "name", "size",
+          "pools", "blocks", "in use", "peak", "free", "KB");
+  for (int i = 0; i < n_totals; i++) {
+    struct mem_pool_total *t = &totals[i];
+    fprintf(out, "  %-26s %6lu %7lld %8lld %12lld %12lld %12lld %10lld\n",
+            t->name, (unsigned long)t->record_size, t->pools, t->blocks,
+            t->live, t->peak, t->free_count, t->bytes / 1024);
+  }
+  fprintf(out, "\n");
+  free(totals);
+}
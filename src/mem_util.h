@@ -24,8 +24,9 @@
 #ifndef MEM_UTIL
 #define MEM_UTIL
 
-#ifdef MEM_UTIL_KEEP_STATS
 #include <stdio.h>
+
+#ifdef MEM_UTIL_KEEP_STATS
 #include <stdlib.h>
 char *mem_util_tracking_strdup(char const *in);
 void *mem_util_tracking_malloc(unsigned int size);
@@ -92,6 +93,15 @@ struct mem_helper {
   struct abstract_list *defunct; /* Linked list of elements that may be reused
                                     for next memory request */
   struct mem_helper *next_helper; /* Next (fully-used) mem_helper */
+
+  /* Pool statistics, kept by the first mem_helper of a pool only */
+  char const *name;       /* Name given to create_mem_named, or NULL */
+  long long live;         /* Records handed out and not yet returned */
+  long long peak;         /* Most records handed out at once */
+  long long free_count;   /* Records on the defunct list */
+  int blocks;             /* Blocks of records allocated so far */
+  struct mem_helper *prev_pool; /* Neighbors in the list of all pools */
+  struct mem_helper *next_pool;
 #ifdef MEM_UTIL_KEEP_STATS
   struct mem_stats *stats;
 #endif
@@ -111,6 +121,8 @@ void *mem_get(struct mem_helper *mh);
 void mem_put(struct mem_helper *mh, void *defunct);
 void mem_put_list(struct mem_helper *mh, void *defunct);
 void delete_mem(struct mem_helper *mh);
+void mem_exchange_blocks(struct mem_helper *a, struct mem_helper *b);
+void mem_dump_pool_stats(FILE *out);
 
 #define stack_nonempty(sh) ((sh)->index > 0 || (sh)->next != NULL)
 
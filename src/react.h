@@ -49,20 +49,38 @@ enum {
 struct rxn *trigger_unimolecular(struct rxn **reaction_hash, int hashsize,
                                  u_int hash, struct abstract_molecule *reac);
 
-int trigger_surface_unimol(struct rxn **reaction_hash, int rx_hashsize,
+int trigger_surface_unimol(struct rxn_pair_table const *rxn_pairs,
                            struct species *all_mols,
                            struct species *all_volume_mols,
                            struct species *all_surface_mols,
                            struct abstract_molecule *reac, struct wall *w,
                            struct rxn **matching_rxns);
 
-int trigger_bimolecular_preliminary(struct rxn **reaction_hash, int hashsize,
-                                    u_int hashA, u_int hashB,
-                                    struct species *reacA,
-                                    struct species *reacB);
-
-int trigger_bimolecular(struct rxn **reaction_hash, int rx_hashsize,
-                        u_int hashA, u_int hashB,
+int cached_surface_unimol(struct surf_unimol_table const *table,
+                          struct abstract_molecule *mol,
+                          struct rxn **matching_rxns);
+
+/*************************************************************************
+trigger_bimolecular_preliminary:
+   In: rxn_pairs - table of reactions by pair of species
+       reacA - species of first molecule
+       reacB - species of second molecule
+   Out: 1 if any reaction exists naming the two specified reactants, 0
+       otherwise.
+   Note: This is a quick test used to determine which per-species lists to
+   traverse when checking for mol-mol collisions, so it only reads reacA's
+   bit set of partners.
+*************************************************************************/
+static inline int
+trigger_bimolecular_preliminary(struct rxn_pair_table const *rxn_pairs,
+                                struct species const *reacA,
+                                struct species const *reacB) {
+  unsigned long long const *partners =
+      rxn_pairs->partners + reacA->species_id * rxn_pairs->partner_words;
+  return (partners[reacB->species_id / 64] >> (reacB->species_id % 64)) & 1;
+}
+
+int trigger_bimolecular(struct rxn_pair_table const *rxn_pairs,
                         struct abstract_molecule *reacA,
                         struct abstract_molecule *reacB, short orientA,
                         short orientB, struct rxn **matching_rxns);
@@ -73,9 +91,9 @@ int trigger_trimolecular(struct rxn **reaction_hash, int rx_hashsize,
                          struct species *reacC, int orientA, int orientB,
                          int orientC, struct rxn **matching_rxns);
 
-int trigger_intersect(struct rxn **reaction_hash, int rx_hashsize,
+int trigger_intersect(struct rxn_pair_table const *rxn_pairs,
                       struct species *all_mols, struct species *all_volume_mols,
-                      struct species *all_surface_mols, u_int hashA,
+                      struct species *all_surface_mols,
                       struct abstract_molecule *reacA, short orientA,
                       struct wall *w, struct rxn **matching_rxns,
                       int allow_rx_transp, int allow_rx_reflec,
@@ -92,19 +110,19 @@ struct rxn *pick_unimolecular_reaction(struct volume *state,
                                        struct abstract_molecule *am);
 
 int find_unimol_reactions_with_surf_classes(
-    struct rxn **reaction_hash, int rx_hashsize,
-    struct abstract_molecule *reacA, struct wall *w, u_int hashA, int orientA,
-    int num_matching_rxns, int allow_rx_transp, int allow_rx_reflec,
-    int allow_rx_absorb_reg_border, struct rxn **matching_rxns);
+    struct rxn_pair_table const *rxn_pairs, struct abstract_molecule *reacA,
+    struct wall *w, int orientA, int num_matching_rxns, int allow_rx_transp,
+    int allow_rx_reflec, int allow_rx_absorb_reg_border,
+    struct rxn **matching_rxns);
 
 int find_surface_mol_reactions_with_surf_classes(
-    struct rxn **reaction_hash, int rx_hashsize, struct species *all_mols,
+    struct rxn_pair_table const *rxn_pairs, struct species *all_mols,
     struct species *all_surface_mols, int orientA, struct species *scl,
     int num_matching_rxns, int allow_rx_transp, int allow_rx_reflec,
     int allow_rx_absorb_reg_border, struct rxn **matching_rxns);
 
 int find_volume_mol_reactions_with_surf_classes(
-    struct rxn **reaction_hash, int rx_hashsize, struct species *all_mols,
+    struct rxn_pair_table const *rxn_pairs, struct species *all_mols,
     struct species *all_volume_mols, int orientA, struct species *scl,
     int num_matching_rxns, int allow_rx_transp, int allow_rx_reflec,
     struct rxn **matching_rxns);
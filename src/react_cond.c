@@ -31,6 +31,7 @@
 #include "rng.h"
 #include "react.h"
 #include "macromolecule.h"
+#include "thread_util.h"
 
 /*************************************************************************
 get_varying_cum_probs:
@@ -233,9 +234,9 @@ int test_bimolecular(struct rxn *rx, double scaling, double local_prob_factor,
     {
       /* How may reactions will we miss? */
       if (scaling == 0.0)
-        rx->n_skipped += GIGANTIC;
+        add_missed_reactions(rx, GIGANTIC);
       else
-        rx->n_skipped += (max_p / scaling) - 1.0;
+        add_missed_reactions(rx, (max_p / scaling) - 1.0);
 
       /* Keep the proportions of outbound pathways the same. */
       p = rng_dbl(rng) * max_p;
@@ -400,13 +401,14 @@ int test_many_bimolecular(struct rxn **rx, double *scaling,
         for (i = 0; i < n; i++)  /* Distribute failures */
         {
           if (all_neighbors_flag && local_prob_factor > 0) {
-            rx[i]->n_skipped += f * ((rx[i]->max_fixed_p) * local_prob_factor +
-                                     rxp[n + i] - rxp[n + i - 1]) /
-                                rxp[n - 1];
+            add_missed_reactions(rx[i],
+                                 f * ((rx[i]->max_fixed_p) * local_prob_factor +
+                                      rxp[n + i] - rxp[n + i - 1]) /
+                                     rxp[n - 1]);
           } else {
-            rx[i]->n_skipped +=
-                f * (rx[i]->max_fixed_p + rxp[n + i] - rxp[n + i - 1]) /
-                rxp[n - 1];
+            add_missed_reactions(
+                rx[i], f * (rx[i]->max_fixed_p + rxp[n + i] - rxp[n + i - 1]) /
+                           rxp[n - 1]);
           }
         }
 
@@ -528,12 +530,14 @@ int test_many_bimolecular(struct rxn **rx, double *scaling,
       for (i = 0; i < n; i++) /* Distribute failures */
       {
         if (all_neighbors_flag && local_prob_factor > 0) {
-          rx[i]->n_skipped += f * ((rx[i]->cum_probs[rx[i]->n_pathways - 1]) *
-                                   local_prob_factor) /
-                              rxp[n - 1];
+          add_missed_reactions(
+              rx[i], f * ((rx[i]->cum_probs[rx[i]->n_pathways - 1]) *
+                          local_prob_factor) /
+                         rxp[n - 1]);
         } else {
-          rx[i]->n_skipped +=
-              f * (rx[i]->cum_probs[rx[i]->n_pathways - 1]) / rxp[n - 1];
+          add_missed_reactions(
+              rx[i],
+              f * (rx[i]->cum_probs[rx[i]->n_pathways - 1]) / rxp[n - 1]);
         }
       }
       p = rng_dbl(rng) * rxp[n - 1];
@@ -583,9 +587,10 @@ int test_intersect(struct rxn *rx, double scaling, struct rng_state *rng) {
 
   if (rx->cum_probs[rx->n_pathways - 1] > scaling) {
     if (scaling <= 0.0)
-      rx->n_skipped += GIGANTIC;
+      add_missed_reactions(rx, GIGANTIC);
     else
-      rx->n_skipped += rx->cum_probs[rx->n_pathways - 1] / scaling - 1.0;
+      add_missed_reactions(rx,
+                           rx->cum_probs[rx->n_pathways - 1] / scaling - 1.0);
     p = rng_dbl(rng) * rx->cum_probs[rx->n_pathways - 1];
   } else {
     p = rng_dbl(rng) * scaling;
@@ -637,8 +642,8 @@ int test_many_intersect(struct rxn **rx, double scaling, int n,
     double f = rxp[n - 1] - 1.0; /* Number of failed reactions */
     for (i = 0; i < n; i++)      /* Distribute failures */
     {
-      rx[i]->n_skipped +=
-          f * (rx[i]->cum_probs[rx[i]->n_pathways - 1]) / rxp[n - 1];
+      add_missed_reactions(
+          rx[i], f * (rx[i]->cum_probs[rx[i]->n_pathways - 1]) / rxp[n - 1]);
     }
     p = rng_dbl(rng) * rxp[n - 1];
   } else {
@@ -896,12 +901,13 @@ int test_many_reactions_all_neighbors(struct rxn **rx, double *scaling,
     for (int i = 0; i < n; i++)  /* Distribute failures */
     {
       if (local_prob_factor[i] > 0) {
-        rx[i]->n_skipped += f * ((rx[i]->cum_probs[rx[i]->n_pathways - 1]) *
-                                 local_prob_factor[i]) /
-                            rxp[n - 1];
+        add_missed_reactions(
+            rx[i], f * ((rx[i]->cum_probs[rx[i]->n_pathways - 1]) *
+                        local_prob_factor[i]) /
+                       rxp[n - 1]);
       } else {
-        rx[i]->n_skipped +=
-            f * (rx[i]->cum_probs[rx[i]->n_pathways - 1]) / rxp[n - 1];
+        add_missed_reactions(
+            rx[i], f * (rx[i]->cum_probs[rx[i]->n_pathways - 1]) / rxp[n - 1]);
       }
     }
     p = rng_dbl(rng) * rxp[n - 1];
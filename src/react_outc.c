@@ -38,6 +38,7 @@
 #include "macromolecule.h"
 #include "wall_util.h"
 #include "diffuse.h"
+#include "thread_util.h"
 
 static int outcome_products(struct volume *world, struct wall *w,
                             struct vector3 *hitpt, double t, struct rxn *rx,
@@ -144,7 +145,7 @@ place_volume_subunit(struct volume *world, struct species *product_species,
   new_volume_mol->birthday = convert_iterations_to_seconds(
       world->start_iterations, world->time_unit,
       world->simulation_start_seconds, t);
-  new_volume_mol->id = world->current_mol_id++;
+  new_volume_mol->id = new_mol_id(world);
   new_volume_mol->t = t;
   new_volume_mol->t2 = 0.0;
   new_volume_mol->properties = product_species;
@@ -241,11 +242,10 @@ void tiny_diffuse_3D(
     struct vector3 *displacement,
     struct vector3 *pos,
     struct wall *w) {
+  struct collision_vector hits;
+  collision_vector_init(&hits);
   struct collision *shead = ray_trace(
-      world, pos, NULL, subvol, displacement, w);
-  if (shead->next != NULL) {
-    shead = (struct collision *)ae_list_sort((struct abstract_element *)shead);
-  }
+      world, pos, NULL, subvol, displacement, w, &hits);
 
   struct collision *smash = NULL;
   for (smash = shead; smash != NULL; smash = smash->next) {
@@ -259,6 +259,7 @@ void tiny_diffuse_3D(
   pos->y += displacement->y;
   pos->z += displacement->z;
   subvol = find_subvolume(world, pos, subvol);
+  collision_vector_free(&hits);
 }
 
 struct volume_molecule *
@@ -287,7 +288,7 @@ place_volume_product(struct volume *world, struct species *product_species,
   new_volume_mol->birthday = convert_iterations_to_seconds(
       world->start_iterations, world->time_unit,
       world->simulation_start_seconds, t);
-  new_volume_mol->id = world->current_mol_id++;
+  new_volume_mol->id = new_mol_id(world);
   new_volume_mol->t = t;
   new_volume_mol->t2 = 0.0;
   new_volume_mol->properties = product_species;
@@ -377,7 +378,7 @@ place_sm_subunit(struct volume *world, struct species *product_species,
   new_surf_mol->birthday = convert_iterations_to_seconds(
       world->start_iterations, world->time_unit,
       world->simulation_start_seconds, t);
-  new_surf_mol->id = world->current_mol_id++;
+  new_surf_mol->id = new_mol_id(world);
   new_surf_mol->t = t;
   new_surf_mol->t2 = 0.0;
   new_surf_mol->properties = product_species;
@@ -467,7 +468,7 @@ place_sm_product(struct volume *world, struct species *product_species,
   new_surf_mol->birthday = convert_iterations_to_seconds(
       world->start_iterations, world->time_unit,
       world->simulation_start_seconds, t);
-  new_surf_mol->id = world->current_mol_id++;
+  new_surf_mol->id = new_mol_id(world);
   new_surf_mol->t = t;
   new_surf_mol->t2 = 0.0;
   new_surf_mol->properties = product_species;
@@ -1339,28 +1340,27 @@ static int outcome_products_random(struct volume *world, struct wall *w,
     }
 
     /* Update molecule counts */
-    ++product_species->population;
+    count_add_uint(world, &product_species->population, 1);
     if (product_species->flags & (COUNT_CONTENTS | COUNT_ENCLOSED))
       count_region_from_scratch(world, this_product, NULL, 1, NULL, NULL, t);
 
     /* preserve molecule id if rxn is unimolecular with one product */
     if (is_unimol && (n_players == 1)) {
       this_product->id = reacA->id;
-      world->current_mol_id--; /* give back id we used */
+      return_mol_id(world); /* give back id we used */
       continue;
     }
     /* preserve molecule id if rxn is surface rxn with one product */
     if ((n_players == 3) && product_type[1] == PLAYER_WALL) {
       this_product->id = reacA->id;
-      world->current_mol_id--; /* give back id we used */
+      return_mol_id(world); /* give back id we used */
       continue;
     }
   }
 
   /* If necessary, update the dissociation index. */
   if (update_dissociation_index) {
-    if (--world->dissociation_index < DISSOCIATION_MIN)
-      world->dissociation_index = DISSOCIATION_MAX;
+    advance_dissociation_index(world);
   }
 
   /* Handle events triggered off of named reactions */
@@ -1445,8 +1445,8 @@ int outcome_unimolecular(struct volume *world, struct rxn *rx, int path,
     return RX_BLOCKED;
 
   if (result != RX_BLOCKED) {
-    rx->info[path].count++;
-    rx->n_occurred++;
+    count_add(world, &rx->info[path].count, 1);
+    count_add_llong(world, &rx->n_occurred, 1);
   }
 
   struct species *who_am_i = rx->players[rx->product_idx[path]];
@@ -1455,17 +1455,19 @@ int outcome_unimolecular(struct volume *world, struct rxn *rx, int path,
     if (vm != NULL) {
       vm->subvol->mol_count--;
       if (vm->flags & IN_SCHEDULE)
-        vm->subvol->local_storage->timer->defunct_count++;
+        schedule_add_defunct(vm->subvol->local_storage->timer);
       if (vm->properties->flags & COUNT_SOME_MASK) {
         count_region_from_scratch(world, (struct abstract_molecule *)vm, NULL,
                                   -1, &(vm->pos), NULL, vm->t);
       }
     } else {
-      if (sm->grid->mol[sm->grid_index] == sm)
+      if (sm->grid->mol[sm->grid_index] == sm) {
         sm->grid->mol[sm->grid_index] = NULL;
+        mark_free_tile(sm->grid, sm->grid_index);
+      }
       sm->grid->n_occupied--;
       if (sm->flags & IN_SCHEDULE) {
-        sm->grid->subvol->local_storage->timer->defunct_count++;
+        schedule_add_defunct(sm->grid->subvol->local_storage->timer);
       }
       if (sm->properties->flags & COUNT_SOME_MASK) {
         count_region_from_scratch(world, (struct abstract_molecule *)sm, NULL,
@@ -1473,13 +1475,13 @@ int outcome_unimolecular(struct volume *world, struct rxn *rx, int path,
       }
     }
 
-    who_was_i->n_deceased++;
+    count_add_llong(world, &who_was_i->n_deceased, 1);
     double t_time = convert_iterations_to_seconds(
         world->start_iterations, world->time_unit,
         world->simulation_start_seconds, t);
-    who_was_i->cum_lifetime_seconds += t_time - reac->birthday;
+    count_add(world, &who_was_i->cum_lifetime_seconds, t_time - reac->birthday);
 
-    who_was_i->population--;
+    count_add_uint(world, &who_was_i->population, -1);
     if (vm != NULL)
       collect_molecule(vm);
     else {
@@ -1548,8 +1550,8 @@ int outcome_bimolecular(struct volume *world, struct rxn *rx, int path,
   if (result == RX_BLOCKED)
     return RX_BLOCKED;
 
-  rx->n_occurred++;
-  rx->info[path].count++;
+  count_add_llong(world, &rx->n_occurred, 1);
+  count_add(world, &rx->info[path].count, 1);
 
   /* Figure out if either of the reactants was destroyed */
   if (rx->players[0] == reacA->properties) {
@@ -1565,19 +1567,21 @@ int outcome_bimolecular(struct volume *world, struct rxn *rx, int path,
     if ((reacB->properties->flags & ON_GRID) != 0) {
       sm = (struct surface_molecule *)reacB;
 
-      if (sm->grid->mol[sm->grid_index] == sm)
+      if (sm->grid->mol[sm->grid_index] == sm) {
         sm->grid->mol[sm->grid_index] = NULL;
+        mark_free_tile(sm->grid, sm->grid_index);
+      }
       sm->grid->n_occupied--;
       if (sm->flags & IN_SURFACE)
         sm->flags -= IN_SURFACE;
       if (sm->flags & IN_SCHEDULE) {
-        sm->grid->subvol->local_storage->timer->defunct_count++;
+        schedule_add_defunct(sm->grid->subvol->local_storage->timer);
       }
     } else if ((reacB->properties->flags & NOT_FREE) == 0) {
       vm = (struct volume_molecule *)reacB;
       vm->subvol->mol_count--;
       if (vm->flags & IN_SCHEDULE) {
-        vm->subvol->local_storage->timer->defunct_count++;
+        schedule_add_defunct(vm->subvol->local_storage->timer);
       }
       reacB_was_free = 1;
     }
@@ -1586,12 +1590,13 @@ int outcome_bimolecular(struct volume *world, struct rxn *rx, int path,
       count_region_from_scratch(world, reacB, NULL, -1, NULL, NULL, t);
     }
 
-    reacB->properties->n_deceased++;
+    count_add_llong(world, &reacB->properties->n_deceased, 1);
     double t_time = convert_iterations_to_seconds(
         world->start_iterations, world->time_unit,
         world->simulation_start_seconds, t);
-    reacB->properties->cum_lifetime_seconds += t_time - reacB->birthday;
-    reacB->properties->population--;
+    count_add(world, &reacB->properties->cum_lifetime_seconds,
+              t_time - reacB->birthday);
+    count_add_uint(world, &reacB->properties->population, -1);
 
     if (vm != NULL)
       collect_molecule(vm);
@@ -1604,17 +1609,19 @@ int outcome_bimolecular(struct volume *world, struct rxn *rx, int path,
     if ((reacA->properties->flags & ON_GRID) != 0) {
       sm = (struct surface_molecule *)reacA;
 
-      if (sm->grid->mol[sm->grid_index] == sm)
+      if (sm->grid->mol[sm->grid_index] == sm) {
         sm->grid->mol[sm->grid_index] = NULL;
+        mark_free_tile(sm->grid, sm->grid_index);
+      }
       sm->grid->n_occupied--;
       if (sm->flags & IN_SCHEDULE) {
-        sm->grid->subvol->local_storage->timer->defunct_count++;
+        schedule_add_defunct(sm->grid->subvol->local_storage->timer);
       }
     } else if ((reacA->properties->flags & NOT_FREE) == 0) {
       vm = (struct volume_molecule *)reacA;
       vm->subvol->mol_count--;
       if (vm->flags & IN_SCHEDULE) {
-        vm->subvol->local_storage->timer->defunct_count++;
+        schedule_add_defunct(vm->subvol->local_storage->timer);
       }
     }
 
@@ -1653,12 +1660,13 @@ int outcome_bimolecular(struct volume *world, struct rxn *rx, int path,
       }
     }
 
-    reacA->properties->n_deceased++;
+    count_add_llong(world, &reacA->properties->n_deceased, 1);
     double t_time = convert_iterations_to_seconds(
         world->start_iterations, world->time_unit,
         world->simulation_start_seconds, t);
-    reacA->properties->cum_lifetime_seconds += t_time - reacA->birthday;
-    reacA->properties->population--;
+    count_add(world, &reacA->properties->cum_lifetime_seconds,
+              t_time - reacA->birthday);
+    count_add_uint(world, &reacA->properties->population, -1);
 
     if (vm != NULL)
       collect_molecule(vm);
@@ -1695,7 +1703,7 @@ int outcome_intersect(struct volume *world, struct rxn *rx, int path,
                       struct vector3 *loc_okay) {
 
   if (rx->n_pathways <= RX_SPECIAL) {
-    rx->n_occurred++;
+    count_add_llong(world, &rx->n_occurred, 1);
     if (rx->n_pathways == RX_REFLEC)
       return RX_A_OK;
     else
@@ -1729,8 +1737,8 @@ int outcome_intersect(struct volume *world, struct rxn *rx, int path,
     if (result == RX_BLOCKED)
       return RX_A_OK; /* reflect the molecule */
 
-    rx->info[path].count++;
-    rx->n_occurred++;
+    count_add(world, &rx->info[path].count, 1);
+    count_add_llong(world, &rx->n_occurred, 1);
 
     if (rx->players[idx] == NULL) {
       /* The code below is also valid for the special reaction
@@ -1754,14 +1762,15 @@ int outcome_intersect(struct volume *world, struct rxn *rx, int path,
                                     t);
         }
       }
-      reac->properties->n_deceased++;
+      count_add_llong(world, &reac->properties->n_deceased, 1);
       double t_time = convert_iterations_to_seconds(
           world->start_iterations, world->time_unit,
           world->simulation_start_seconds, t);
-      reac->properties->cum_lifetime_seconds += t_time - reac->birthday;
-      reac->properties->population--;
+      count_add(world, &reac->properties->cum_lifetime_seconds,
+                t_time - reac->birthday);
+      count_add_uint(world, &reac->properties->population, -1);
       if (m->flags & IN_SCHEDULE) {
-        m->subvol->local_storage->timer->defunct_count++;
+        schedule_add_defunct(m->subvol->local_storage->timer);
       }
       collect_molecule(m);
       return RX_DESTROY;
@@ -2416,9 +2425,12 @@ static int outcome_products(struct volume *world, struct wall *w,
                 if (product_grid[n_placed] == NULL)
                   continue;
                 if (product_grid[n_placed]->mol[product_grid_idx[n_placed]] ==
-                    &sentinel)
+                    &sentinel) {
                   product_grid[n_placed]->mol[product_grid_idx[n_placed]] =
                       NULL;
+                  mark_free_tile(product_grid[n_placed],
+                                 product_grid_idx[n_placed]);
+                }
               }
 
               return RX_BLOCKED;
@@ -2528,15 +2540,14 @@ static int outcome_products(struct volume *world, struct wall *w,
     }
 
     /* Update molecule counts */
-    ++product_species->population;
+    count_add_uint(world, &product_species->population, 1);
     if (product_species->flags & (COUNT_CONTENTS | COUNT_ENCLOSED))
       count_region_from_scratch(world, this_product, NULL, 1, NULL, NULL, t);
   }
 
   /* If necessary, update the dissociation index. */
   if (update_dissociation_index) {
-    if (--world->dissociation_index < DISSOCIATION_MIN)
-      world->dissociation_index = DISSOCIATION_MAX;
+    advance_dissociation_index(world);
   }
 
   /* Handle events triggered off of named reactions */
@@ -37,6 +37,7 @@
 #include "react.h"
 #include "vol_util.h"
 #include "wall_util.h"
+#include "thread_util.h"
 
 static int outcome_products_trimol_reaction_random(
     struct volume *world, struct wall *w, struct vector3 *hitpt, double t,
@@ -1700,15 +1701,14 @@ static int outcome_products_trimol_reaction_random(
     }
 
     /* Update molecule counts */
-    ++product_species->population;
+    count_add_uint(world, &product_species->population, 1);
     if (product_species->flags & (COUNT_CONTENTS | COUNT_ENCLOSED))
       count_region_from_scratch(world, this_product, NULL, 1, NULL, NULL, t);
   }
 
   /* If necessary, update the dissociation index. */
   if (update_dissociation_index) {
-    if (--world->dissociation_index < DISSOCIATION_MIN)
-      world->dissociation_index = DISSOCIATION_MAX;
+    advance_dissociation_index(world);
   }
 
   /* Handle events triggered off of named reactions */
@@ -1803,8 +1803,8 @@ int outcome_trimolecular(struct volume *world, struct rxn *rx, int path,
   if (result == RX_BLOCKED)
     return RX_BLOCKED;
 
-  rx->n_occurred++;
-  rx->info[path].count++;
+  count_add_llong(world, &rx->n_occurred, 1);
+  count_add(world, &rx->info[path].count, 1);
 
   /* Figure out if either of the reactants was destroyed */
 
@@ -1844,20 +1844,22 @@ int outcome_trimolecular(struct volume *world, struct rxn *rx, int path,
     vm = NULL;
     if ((reacC->properties->flags & ON_GRID) != 0) {
       sm = (struct surface_molecule *)reacC;
-      if (sm->grid->mol[sm->grid_index] == sm)
+      if (sm->grid->mol[sm->grid_index] == sm) {
         sm->grid->mol[sm->grid_index] = NULL;
+        mark_free_tile(sm->grid, sm->grid_index);
+      }
       sm->grid->n_occupied--;
       if (sm->flags & IN_SURFACE)
         sm->flags -= IN_SURFACE;
 
       if (sm->flags & IN_SCHEDULE) {
-        sm->grid->subvol->local_storage->timer->defunct_count++;
+        schedule_add_defunct(sm->grid->subvol->local_storage->timer);
       }
     } else {
       vm = (struct volume_molecule *)reacC;
       vm->subvol->mol_count--;
       if (vm->flags & IN_SCHEDULE) {
-        vm->subvol->local_storage->timer->defunct_count++;
+        schedule_add_defunct(vm->subvol->local_storage->timer);
       }
     }
 
@@ -1865,12 +1867,13 @@ int outcome_trimolecular(struct volume *world, struct rxn *rx, int path,
       count_region_from_scratch(world, reacC, NULL, -1, NULL, NULL, t);
     }
 
-    reacC->properties->n_deceased++;
+    count_add_llong(world, &reacC->properties->n_deceased, 1);
     double t_time = convert_iterations_to_seconds(
         world->start_iterations, world->time_unit,
         world->simulation_start_seconds, t);
-    reacC->properties->cum_lifetime_seconds += t_time - reacC->birthday;
-    reacC->properties->population--;
+    count_add(world, &reacC->properties->cum_lifetime_seconds,
+              t_time - reacC->birthday);
+    count_add_uint(world, &reacC->properties->population, -1);
     if (vm != NULL)
       collect_molecule(vm);
     else {
@@ -1884,20 +1887,22 @@ int outcome_trimolecular(struct volume *world, struct rxn *rx, int path,
     vm = NULL;
     if ((reacB->properties->flags & ON_GRID) != 0) {
       sm = (struct surface_molecule *)reacB;
-      if (sm->grid->mol[sm->grid_index] == sm)
+      if (sm->grid->mol[sm->grid_index] == sm) {
         sm->grid->mol[sm->grid_index] = NULL;
+        mark_free_tile(sm->grid, sm->grid_index);
+      }
       sm->grid->n_occupied--;
       if (sm->flags & IN_SURFACE)
         sm->flags -= IN_SURFACE;
 
       if (sm->flags & IN_SCHEDULE) {
-        sm->grid->subvol->local_storage->timer->defunct_count++;
+        schedule_add_defunct(sm->grid->subvol->local_storage->timer);
       }
     } else {
       vm = (struct volume_molecule *)reacB;
       vm->subvol->mol_count--;
       if (vm->flags & IN_SCHEDULE) {
-        vm->subvol->local_storage->timer->defunct_count++;
+        schedule_add_defunct(vm->subvol->local_storage->timer);
       }
     }
 
@@ -1905,12 +1910,13 @@ int outcome_trimolecular(struct volume *world, struct rxn *rx, int path,
       count_region_from_scratch(world, reacB, NULL, -1, NULL, NULL, t);
     }
 
-    reacB->properties->n_deceased++;
+    count_add_llong(world, &reacB->properties->n_deceased, 1);
     double t_time = convert_iterations_to_seconds(
         world->start_iterations, world->time_unit,
         world->simulation_start_seconds, t);
-    reacB->properties->cum_lifetime_seconds += t_time - reacB->birthday;
-    reacB->properties->population--;
+    count_add(world, &reacB->properties->cum_lifetime_seconds,
+              t_time - reacB->birthday);
+    count_add_uint(world, &reacB->properties->population, -1);
     if (vm != NULL)
       collect_molecule(vm);
     else {
@@ -1924,20 +1930,22 @@ int outcome_trimolecular(struct volume *world, struct rxn *rx, int path,
     vm = NULL;
     if ((reacA->properties->flags & ON_GRID) != 0) {
       sm = (struct surface_molecule *)reacA;
-      if (sm->grid->mol[sm->grid_index] == sm)
+      if (sm->grid->mol[sm->grid_index] == sm) {
         sm->grid->mol[sm->grid_index] = NULL;
+        mark_free_tile(sm->grid, sm->grid_index);
+      }
       sm->grid->n_occupied--;
       if (sm->flags & IN_SURFACE)
         sm->flags -= IN_SURFACE;
 
       if (sm->flags & IN_SCHEDULE) {
-        sm->grid->subvol->local_storage->timer->defunct_count++;
+        schedule_add_defunct(sm->grid->subvol->local_storage->timer);
       }
     } else {
       vm = (struct volume_molecule *)reacA;
       vm->subvol->mol_count--;
       if (vm->flags & IN_SCHEDULE) {
-        vm->subvol->local_storage->timer->defunct_count++;
+        schedule_add_defunct(vm->subvol->local_storage->timer);
       }
     }
     if ((reacA->properties->flags & ON_GRID) !=
@@ -1974,12 +1982,13 @@ int outcome_trimolecular(struct volume *world, struct rxn *rx, int path,
         count_region_from_scratch(world, reacA, NULL, -1, &fake_hitpt, NULL, t);
       }
     }
-    reacA->properties->n_deceased++;
+    count_add_llong(world, &reacA->properties->n_deceased, 1);
     double t_time = convert_iterations_to_seconds(
         world->start_iterations, world->time_unit,
         world->simulation_start_seconds, t);
-    reacA->properties->cum_lifetime_seconds += t_time - reacA->birthday;
-    reacA->properties->population--;
+    count_add(world, &reacA->properties->cum_lifetime_seconds,
+              t_time - reacA->birthday);
+    count_add_uint(world, &reacA->properties->population, -1);
     if (vm != NULL)
       collect_molecule(vm);
     else
@@ -420,12 +420,11 @@ int flush_reaction_output(struct volume *world) {
 
   for (sh = world->count_scheduler; sh != NULL; sh = sh->next_scale) {
     for (i = 0; i <= sh->buf_len; i++) {
-      if (i == sh->buf_len)
-        ob = (struct output_block *)sh->current;
-      else
-        ob = (struct output_block *)sh->circ_buf_head[i];
+      struct sched_bucket *slot =
+          (i == sh->buf_len) ? &sh->current : &sh->circ_buf[i];
 
-      for (; ob != NULL; ob = ob->next) {
+      for (int k = 0; k < slot->count; k++) {
+        ob = (struct output_block *)sched_bucket_item(slot, k);
         for (os = ob->data_set_head; os != NULL; os = os->next) {
           if (write_reaction_output(world, os))
             n_errors++;
@@ -37,6 +37,21 @@
 #include "mcell_structs.h"
 #include "react.h"
 
+/*************************************************************************
+pair_rxns:
+   In: table of reactions by pair of species
+       the two species
+       place to hold the end of their reactions in the table
+   Out: index in the table of the first reaction between the two species
+*************************************************************************/
+static int pair_rxns(struct rxn_pair_table const *rxn_pairs,
+                     struct species const *a, struct species const *b,
+                     int *end) {
+  int pair = a->species_id * rxn_pairs->n_species + b->species_id;
+  *end = rxn_pairs->first[pair + 1];
+  return rxn_pairs->first[pair];
+}
+
 /*************************************************************************
 trigger_unimolecular:
    In: hash value of molecule's species
@@ -85,7 +100,7 @@ trigger_surface_unimol:
         All matching reactions are put into an "matching_rxns" array.
    Note: this is just a wrapper around trigger_intersect
 *************************************************************************/
-int trigger_surface_unimol(struct rxn **reaction_hash, int rx_hashsize,
+int trigger_surface_unimol(struct rxn_pair_table const *rxn_pairs,
                            struct species *all_mols,
                            struct species *all_volume_mols,
                            struct species *all_surface_mols,
@@ -97,52 +112,45 @@ int trigger_surface_unimol(struct rxn **reaction_hash, int rx_hashsize,
     w = sm->grid->surface;
   }
 
-  int num_matching_rxns = trigger_intersect(
-      reaction_hash, rx_hashsize, all_mols, all_volume_mols, all_surface_mols,
-      sm->properties->hashval, mol, sm->orient, w, matching_rxns, 0, 0, 0);
+  int num_matching_rxns =
+      trigger_intersect(rxn_pairs, all_mols, all_volume_mols, all_surface_mols,
+                        mol, sm->orient, w, matching_rxns, 0, 0, 0);
 
   return num_matching_rxns;
 }
 
 /*************************************************************************
-trigger_bimolecular_preliminary:
-   In: hashA - hash value for first molecule
-       hashB - hash value for second molecule
-       reacA - species of first molecule
-       reacB - species of second molecule
-   Out: 1 if any reaction exists naming the two specified reactants, 0
-       otherwise.
-   Note: This is a quick test used to determine which per-species lists to
-   traverse when checking for mol-mol collisions.
+cached_surface_unimol:
+   In: table of surface class reactions by wall class list
+       pointer to a surface molecule
+       array of matching reactions
+   Out: Number of matching reactions for the molecule with the surface
+        classes of its own wall, as trigger_surface_unimol would find them,
+        or -1 if the table does not cover this molecule.
+        All matching reactions are put into the "matching_rxns" array.
 *************************************************************************/
-int trigger_bimolecular_preliminary(struct rxn **reaction_hash, int rx_hashsize,
-                                    u_int hashA, u_int hashB,
-                                    struct species *reacA,
-                                    struct species *reacB) {
-  u_int hash; /* index in the reaction hash table */
-  struct rxn *inter;
+int cached_surface_unimol(struct surf_unimol_table const *table,
+                          struct abstract_molecule *mol,
+                          struct rxn **matching_rxns) {
+  struct surface_molecule *sm = (struct surface_molecule *)mol;
 
-  hash = (hashA + hashB) & (rx_hashsize - 1);
+  if (table->first == NULL || (mol->properties->flags & ON_GRID) == 0 ||
+      sm->orient == 0)
+    return -1;
 
-  for (inter = reaction_hash[hash]; inter != NULL; inter = inter->next) {
-    /* Enough reactants? (3=>wall also) */
-    if (inter->n_reactants < 2)
-      continue;
+  int set = sm->grid->surface->surf_class_set;
+  int entry = (set * table->n_species + mol->properties->species_id) * 2 +
+              (sm->orient > 0);
+  int num_matching_rxns = table->first[entry + 1] - table->first[entry];
+  memcpy(matching_rxns, table->rxns + table->first[entry],
+         (size_t)num_matching_rxns * sizeof(struct rxn *));
 
-    /* Do we have the right players? */
-    if ((reacA == inter->players[0] && reacB == inter->players[1])) {
-      return 1;
-    } else if ((reacB == inter->players[0] && reacA == inter->players[1])) {
-      return 1;
-    }
-  }
-
-  return 0;
+  return num_matching_rxns;
 }
 
 /*************************************************************************
 trigger_bimolecular:
-   In: hash values of the two colliding molecules
+   In: table of reactions by pair of species
        pointers to the two colliding molecules
        orientations of the two colliding molecules
          both zero away from a surface
@@ -156,12 +164,10 @@ trigger_bimolecular:
          but not rescheduled.  Assume we have or will check separately that
          the moving molecule is not inert!
 *************************************************************************/
-int trigger_bimolecular(struct rxn **reaction_hash, int rx_hashsize,
-                        u_int hashA, u_int hashB,
+int trigger_bimolecular(struct rxn_pair_table const *rxn_pairs,
                         struct abstract_molecule *reacA,
                         struct abstract_molecule *reacB, short orientA,
                         short orientB, struct rxn **matching_rxns) {
-  u_int hash;                /* index in the reaction hash table */
   int test_wall;             /* flag */
   int num_matching_rxns = 0; /* number of matching reactions */
   short geomA, geomB;
@@ -173,8 +179,6 @@ int trigger_bimolecular(struct rxn **reaction_hash, int rx_hashsize,
                                    match the SURFACE_CLASS of the reaction
                                    (if needed) */
 
-  hash = (hashA + hashB) & (rx_hashsize - 1);
-
   /* Check if either reactant belongs to a complex */
   if ((reacA->flags | reacB->flags) & COMPLEX_MEMBER) {
     need_complex = 1;
@@ -184,7 +188,10 @@ int trigger_bimolecular(struct rxn **reaction_hash, int rx_hashsize,
       return 0;
   }
 
-  for (inter = reaction_hash[hash]; inter != NULL; inter = inter->next) {
+  int end;
+  for (int i = pair_rxns(rxn_pairs, reacA->properties, reacB->properties, &end);
+       i < end; i++) {
+    inter = rxn_pairs->rxns[i];
     right_walls_surf_classes = 0;
 
     /* Right number of reactants? */
@@ -354,7 +361,7 @@ int trigger_bimolecular(struct rxn **reaction_hash, int rx_hashsize,
       } /* if (right_walls_surf_classes) ... */
 
     } /* end if (test_wall && orientA != NULL) */
-  }   /* end for (inter = reaction_hash[hash]; ...) */
+  }   /* end for (i = pair_rxns(...); ...) */
 
   if (num_matching_rxns > MAX_MATCHING_RXNS) {
     mcell_warn("Number of matching reactions exceeds the maximum allowed "
@@ -599,7 +606,7 @@ int trigger_trimolecular(struct rxn **reaction_hash, int rx_hashsize,
 
 /*************************************************************************
 trigger_intersect:
-   In: hash value of molecule's species
+   In: table of reactions by pair of species
        pointer to a molecule
        orientation of that molecule
        pointer to a wall
@@ -613,9 +620,9 @@ trigger_intersect:
    Note: Moving molecule may be inert.
 
 *************************************************************************/
-int trigger_intersect(struct rxn **reaction_hash, int rx_hashsize,
+int trigger_intersect(struct rxn_pair_table const *rxn_pairs,
                       struct species *all_mols, struct species *all_volume_mols,
-                      struct species *all_surface_mols, u_int hashA,
+                      struct species *all_surface_mols,
                       struct abstract_molecule *reacA, short orientA,
                       struct wall *w, struct rxn **matching_rxns,
                       int allow_rx_transp, int allow_rx_reflec,
@@ -624,20 +631,19 @@ int trigger_intersect(struct rxn **reaction_hash, int rx_hashsize,
 
   if (w->surf_class_head != NULL) {
     num_matching_rxns = find_unimol_reactions_with_surf_classes(
-        reaction_hash, rx_hashsize, reacA, w, hashA, orientA, num_matching_rxns,
-        allow_rx_transp, allow_rx_reflec, allow_rx_absorb_reg_border,
-        matching_rxns);
+        rxn_pairs, reacA, w, orientA, num_matching_rxns, allow_rx_transp,
+        allow_rx_reflec, allow_rx_absorb_reg_border, matching_rxns);
   }
 
   for (struct surf_class_list *scl = w->surf_class_head; scl != NULL; scl = scl->next) {
     if ((reacA->properties->flags & NOT_FREE) == 0) {
       num_matching_rxns = find_volume_mol_reactions_with_surf_classes(
-          reaction_hash, rx_hashsize, all_mols, all_volume_mols, orientA,
+          rxn_pairs, all_mols, all_volume_mols, orientA,
           scl->surf_class, num_matching_rxns, allow_rx_transp, allow_rx_reflec,
           matching_rxns);
     } else if ((reacA->properties->flags & ON_GRID) != 0) {
       num_matching_rxns = find_surface_mol_reactions_with_surf_classes(
-          reaction_hash, rx_hashsize, all_mols, all_surface_mols, orientA,
+          rxn_pairs, all_mols, all_surface_mols, orientA,
           scl->surf_class, num_matching_rxns, allow_rx_transp, allow_rx_reflec,
           allow_rx_absorb_reg_border, matching_rxns);
     }
@@ -651,9 +657,9 @@ int trigger_intersect(struct rxn **reaction_hash, int rx_hashsize,
  * find all unimolecular reactions of reacA with surface classes on
  * wall w.
  *
- * in: molecule to check for reactions,
+ * in: table of reactions by pair of species
+ *     molecule to check for reactions,
  *     wall we want to test for reactions
- *     hash of molecule
  *     orientation of molecule
  *     number of matching reactions before the function call
  *     flag signalling the presence of transparent region border
@@ -666,30 +672,25 @@ int trigger_intersect(struct rxn **reaction_hash, int rx_hashsize,
  *
  *************************************************************************/
 int find_unimol_reactions_with_surf_classes(
-    struct rxn **reaction_hash, int rx_hashsize,
-    struct abstract_molecule *reacA, struct wall *w, u_int hashA, int orientA,
-    int num_matching_rxns, int allow_rx_transp, int allow_rx_reflec,
-    int allow_rx_absorb_reg_border, struct rxn **matching_rxns) {
+    struct rxn_pair_table const *rxn_pairs, struct abstract_molecule *reacA,
+    struct wall *w, int orientA, int num_matching_rxns, int allow_rx_transp,
+    int allow_rx_reflec, int allow_rx_absorb_reg_border,
+    struct rxn **matching_rxns) {
 
-  u_int hash, hashW;
   for (struct surf_class_list *scl = w->surf_class_head; scl != NULL; scl = scl->next) {
-    hashW = scl->surf_class->hashval;
-    hash = (hashA + hashW) & (rx_hashsize - 1);
-    struct rxn *inter = reaction_hash[hash];
-
-    while (inter != NULL) {
+    int end;
+    for (int i = pair_rxns(rxn_pairs, reacA->properties, scl->surf_class, &end);
+         i < end; i++) {
+      struct rxn *inter = rxn_pairs->rxns[i];
       if (inter->n_reactants == 2) {
         if ((inter->n_pathways == RX_TRANSP) && (!allow_rx_transp)) {
-          inter = inter->next;
           continue;
         }
         if ((inter->n_pathways == RX_REFLEC) && (!allow_rx_reflec)) {
-          inter = inter->next;
           continue;
         }
         if ((inter->n_pathways == RX_ABSORB_REGION_BORDER) &&
             (!allow_rx_absorb_reg_border)) {
-          inter = inter->next;
           continue;
         }
         if ((reacA->properties == inter->players[0] &&
@@ -719,7 +720,6 @@ int find_unimol_reactions_with_surf_classes(
           }
         }
       }
-      inter = inter->next;
     }
   }
   return num_matching_rxns;
@@ -731,7 +731,8 @@ int find_unimol_reactions_with_surf_classes(
  * orientA with a surface class triggered via the ALL_MOLECULES and
  * ALL_VOLUME_MOLECULE keywords
  *
- * in: orientation of surface molecule
+ * in: table of reactions by pair of species
+ *     orientation of surface molecule
  *     surface class species to test
  *     number of matching reactions before the function call
  *     flag signalling the presence of transparent region border
@@ -744,30 +745,23 @@ int find_unimol_reactions_with_surf_classes(
  *
  *************************************************************************/
 int find_volume_mol_reactions_with_surf_classes(
-    struct rxn **reaction_hash, int rx_hashsize, struct species *all_mols,
+    struct rxn_pair_table const *rxn_pairs, struct species *all_mols,
     struct species *all_volume_mols, int orientA, struct species *scl,
     int num_matching_rxns, int allow_rx_transp, int allow_rx_reflec,
     struct rxn **matching_rxns) {
   short geom1, geom2;
 
-  u_int hash_ALL_M = all_mols->hashval;
-  u_int hash_ALL_VOLUME_M = all_volume_mols->hashval;
+  int end, end2;
+  int first = pair_rxns(rxn_pairs, all_mols, scl, &end);
+  int first2 = pair_rxns(rxn_pairs, all_volume_mols, scl, &end2);
 
-  u_int hashW = scl->hashval;
-  u_int hash = (hashW + hash_ALL_M) & (rx_hashsize - 1);
-  u_int hash2 = (hashW + hash_ALL_VOLUME_M) & (rx_hashsize - 1);
-
-  struct rxn *inter = reaction_hash[hash];
-  struct rxn *inter2 = reaction_hash[hash2];
-
-  while (inter != NULL) {
+  for (int i = first; i < end; i++) {
+    struct rxn *inter = rxn_pairs->rxns[i];
     if (inter->n_reactants == 2) {
       if ((inter->n_pathways == RX_TRANSP) && (!allow_rx_transp)) {
-        inter = inter->next;
         continue;
       }
       if ((inter->n_pathways == RX_REFLEC) && (!allow_rx_reflec)) {
-        inter = inter->next;
         continue;
       }
 
@@ -786,17 +780,15 @@ int find_volume_mol_reactions_with_surf_classes(
         }
       }
     }
-    inter = inter->next;
   }
 
-  while (inter2 != NULL) {
+  for (int i = first2; i < end2; i++) {
+    struct rxn *inter2 = rxn_pairs->rxns[i];
     if (inter2->n_reactants == 2) {
       if ((inter2->n_pathways == RX_TRANSP) && (!allow_rx_transp)) {
-        inter2 = inter2->next;
         continue;
       }
       if ((inter2->n_pathways == RX_REFLEC) && (!allow_rx_reflec)) {
-        inter2 = inter2->next;
         continue;
       }
 
@@ -815,7 +807,6 @@ int find_volume_mol_reactions_with_surf_classes(
         }
       }
     }
-    inter2 = inter2->next;
   }
 
   return num_matching_rxns;
@@ -827,7 +818,8 @@ int find_volume_mol_reactions_with_surf_classes(
  * orientA on a surface class triggered via the ALL_MOLECULES and
  * ALL_SURFACE_MOLECULE keywords
  *
- * in: orientation of surface molecule
+ * in: table of reactions by pair of species
+ *     orientation of surface molecule
  *     surface class species to test
  *     number of matching reactions before the function call
  *     flag signalling the presence of transparent region border
@@ -840,29 +832,23 @@ int find_volume_mol_reactions_with_surf_classes(
  *
  *************************************************************************/
 int find_surface_mol_reactions_with_surf_classes(
-    struct rxn **reaction_hash, int rx_hashsize, struct species *all_mols,
+    struct rxn_pair_table const *rxn_pairs, struct species *all_mols,
     struct species *all_surface_mols, int orientA, struct species *scl,
     int num_matching_rxns, int allow_rx_transp, int allow_rx_reflec,
     int allow_rx_absorb_reg_border, struct rxn **matching_rxns) {
   short geom1, geom2;
 
-  u_int hash_ALL_M = all_mols->hashval;
-  u_int hash_ALL_SURFACE_M = all_surface_mols->hashval;
-  u_int hashW = scl->hashval;
-  u_int hash = (hashW + hash_ALL_M) & (rx_hashsize - 1);
-  u_int hash2 = (hashW + hash_ALL_SURFACE_M) & (rx_hashsize - 1);
+  int end, end2;
+  int first = pair_rxns(rxn_pairs, all_mols, scl, &end);
+  int first2 = pair_rxns(rxn_pairs, all_surface_mols, scl, &end2);
 
-  struct rxn *inter = reaction_hash[hash];
-  struct rxn *inter2 = reaction_hash[hash2];
-
-  while (inter != NULL) {
+  for (int i = first; i < end; i++) {
+    struct rxn *inter = rxn_pairs->rxns[i];
     if (inter->n_reactants == 2) {
       if ((inter->n_pathways == RX_TRANSP) && (!allow_rx_transp)) {
-        inter = inter->next;
         continue;
       }
       if ((inter->n_pathways == RX_REFLEC) && (!allow_rx_reflec)) {
-        inter = inter->next;
         continue;
       }
 
@@ -900,24 +886,21 @@ int find_surface_mol_reactions_with_surf_classes(
         }
       }
     }
-    inter = inter->next;
   }
 
-  while (inter2 != NULL) {
+  for (int i = first2; i < end2; i++) {
+    struct rxn *inter2 = rxn_pairs->rxns[i];
     if (inter2->n_reactants == 2) {
       if ((inter2->n_pathways == RX_TRANSP) && (!allow_rx_transp)) {
-        inter2 = inter2->next;
         continue;
       }
 
       if ((inter2->n_pathways == RX_REFLEC) && (!allow_rx_reflec)) {
-        inter2 = inter2->next;
         continue;
       }
 
       if ((inter2->n_pathways == RX_ABSORB_REGION_BORDER) &&
           (!allow_rx_absorb_reg_border)) {
-        inter2 = inter2->next;
         continue;
       }
 
@@ -936,7 +919,6 @@ int find_surface_mol_reactions_with_surf_classes(
         }
       }
     }
-    inter2 = inter2->next;
   }
 
   return num_matching_rxns;
@@ -1046,10 +1028,11 @@ struct rxn *pick_unimolecular_reaction(struct volume *state,
   int can_surf_react = ((am->properties->flags & CAN_SURFWALL) != 0);
   if (can_surf_react) {
     num_matching_rxns =
-        trigger_surface_unimol(
-            state->reaction_hash, state->rx_hashsize, state->all_mols,
-            state->all_volume_mols, state->all_surface_mols, am, NULL,
-            matching_rxns);
+        cached_surface_unimol(&state->surf_unimol, am, matching_rxns);
+    if (num_matching_rxns < 0)
+      num_matching_rxns = trigger_surface_unimol(
+          &state->rxn_pairs, state->all_mols, state->all_volume_mols,
+          state->all_surface_mols, am, NULL, matching_rxns);
     for (int jj = 0; jj < num_matching_rxns; jj++) {
       if ((matching_rxns[jj] != NULL) && (matching_rxns[jj]->prob_t != NULL)) {
         update_probs(
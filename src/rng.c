@@ -24,6 +24,7 @@
 #include "config.h"
 
 #include <math.h>
+#include <stdint.h>
 
 #include "rng.h"
 #include "mcell_structs.h"
@@ -217,3 +218,67 @@ double rng_gauss(struct rng_state *rng) {
 
   return sign * x;
 }
+
+/*************************************************************************
+rng_gauss_batch:
+  In:  rng: uniform RNG state
+       out: array for the variates
+       n: number of variates wanted
+  Out: No return value.  out[0] ... out[n - 1] hold Gaussian variates
+       (mean 0, variance 1), exactly those that n calls to rng_gauss would
+       have returned.
+  Note: Most variates need just one random integer and pass the quick
+        test against KTAB, so those are taken straight from the block of
+        integers ISAAC64 has already generated, without calling rng_gauss
+        for each one.  The first variate that fails the quick test is left
+        to rng_gauss, which sees the same integer and consumes the same
+        random numbers it always would, so the random stream is unchanged.
+ *************************************************************************/
+void rng_gauss_batch(struct rng_state *rng, double *out, int n) {
+#if defined(USE_MINIMAL_RNG)
+  for (int i = 0; i < n; i++)
+    out[i] = rng_gauss(rng);
+#else
+  int done = 0;
+  while (done < n) {
+    /* rng_uint hands out the block from the top down */
+    int avail = (int)rng->randcnt;
+    if (avail > n - done)
+      avail = n - done;
+    ub4 const *bits = (ub4 const *)rng->randrsl + rng->randcnt - 1;
+
+    int i;
+    for (i = 0; i < avail; i++) {
+      unsigned long b = *(bits - i);
+      unsigned long region = b & 0x0000007f;
+      unsigned long pos_within_region = b & 0xffffff00;
+      if (pos_within_region >= KTAB[region])
+        break;
+      double sign = (b & 0x80) ? -1.0 : 1.0;
+      out[done + i] = sign * (pos_within_region * WTAB[region]);
+    }
+    rng->randcnt -= i;
+    done += i;
+
+    /* Slow path, or the block is used up */
+    if (i < avail || avail == 0)
+      out[done++] = rng_gauss(rng);
+  }
+#endif
+}
+
+/*************************************************************************
+rng_stream_seed:
+  In:  seed: the user's random sequence number
+       stream: index of an independent stream (e.g. a storage)
+  Out: Returns a seed for the stream.  Nearby seeds and stream indices are
+       scrambled (SplitMix64 finalizer), so the streams are unrelated to
+       each other and to the main stream seeded with "seed" itself.
+ *************************************************************************/
+unsigned int rng_stream_seed(unsigned int seed, unsigned int stream) {
+  uint64_t z = ((uint64_t)seed << 32) + stream + 0x9E3779B97F4A7C15ULL;
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  z ^= z >> 31;
+  return (unsigned int)(z ^ (z >> 32));
+}
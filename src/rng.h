@@ -52,5 +52,8 @@
 #define rng_open_dbl(x) (rng_dbl(x) + ONE_OVER_2_TO_THE_33RD)
 
 double rng_gauss(struct rng_state *rng);
+void rng_gauss_batch(struct rng_state *rng, double *out, int n);
+
+unsigned int rng_stream_seed(unsigned int seed, unsigned int stream);
 
 #endif
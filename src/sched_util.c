@@ -152,6 +152,139 @@ struct abstract_element *ae_list_sort(struct abstract_element *ae) {
   return stack[0];
 }
 
+/*************************************************************************
+bucket_grow:
+  In: bucket to grow
+      number of entries it must be able to hold
+  Out: 0 on success, 1 on memory allocation failure.  The bucket's capacity
+       is doubled (repeatedly, if need be).
+  Note: The ring is grown in place with realloc, which for large buckets
+        need not copy it.  If the ring wraps around, the shorter of its two
+        runs is moved so that it stays in one piece.
+*************************************************************************/
+
+static int bucket_grow(struct sched_bucket *b, int needed) {
+  int old_capacity = b->capacity;
+  int capacity = old_capacity ? 2 * old_capacity : 8;
+  while (capacity < needed)
+    capacity *= 2;
+  struct sched_entry *items = (struct sched_entry *)realloc(
+      b->items, capacity * sizeof(struct sched_entry));
+  if (items == NULL)
+    return 1;
+
+  int wrapped = b->start + b->count - old_capacity;
+  if (wrapped > 0) {
+    int head = old_capacity - b->start;
+    if (wrapped <= head) {
+      memcpy(items + old_capacity, items,
+             wrapped * sizeof(struct sched_entry));
+    } else {
+      memmove(items + capacity - head, items + b->start,
+              head * sizeof(struct sched_entry));
+      b->start = capacity - head;
+    }
+  }
+  b->items = items;
+  b->capacity = capacity;
+  return 0;
+}
+
+/*************************************************************************
+bucket_push_back:
+  In: bucket to add to
+      item to add
+  Out: 0 on success, 1 on memory allocation failure.  The item is serviced
+       after those already in the bucket.
+*************************************************************************/
+
+static int bucket_push_back(struct sched_bucket *b,
+                            struct abstract_element *ae) {
+  if (b->count == b->capacity && bucket_grow(b, b->count + 1))
+    return 1;
+
+  int pos = b->start + b->count;
+  if (pos >= b->capacity)
+    pos -= b->capacity;
+  b->items[pos].t = ae->t;
+  b->items[pos].item = ae;
+  b->count++;
+  return 0;
+}
+
+/*************************************************************************
+bucket_push_front:
+  In: bucket to add to
+      item to add
+  Out: 0 on success, 1 on memory allocation failure.  The item is serviced
+       before those already in the bucket.
+*************************************************************************/
+
+static int bucket_push_front(struct sched_bucket *b,
+                             struct abstract_element *ae) {
+  if (b->count == b->capacity && bucket_grow(b, b->count + 1))
+    return 1;
+
+  if (--b->start < 0)
+    b->start += b->capacity;
+  b->items[b->start].t = ae->t;
+  b->items[b->start].item = ae;
+  b->count++;
+  return 0;
+}
+
+/*************************************************************************
+bucket_pop_front:
+  In: non-empty bucket
+  Out: the first item, which is removed from the bucket
+*************************************************************************/
+
+static struct abstract_element *bucket_pop_front(struct sched_bucket *b) {
+  struct abstract_element *ae = b->items[b->start].item;
+  if (--b->count == 0)
+    b->start = 0;
+  else if (++b->start == b->capacity)
+    b->start = 0;
+  return ae;
+}
+
+/*************************************************************************
+bucket_remove:
+  In: bucket to remove from
+      item to remove
+  Out: 0 on success, 1 if the item was not found.  The remaining items keep
+       their order.
+*************************************************************************/
+
+static int bucket_remove(struct sched_bucket *b, struct abstract_element *ae) {
+  int k;
+  for (k = 0; k < b->count; k++) {
+    if (sched_bucket_item(b, k) == ae)
+      break;
+  }
+  if (k == b->count)
+    return 1;
+
+  for (; k < b->count - 1; k++)
+    b->items[(b->start + k) % b->capacity] =
+        b->items[(b->start + k + 1) % b->capacity];
+  if (--b->count == 0)
+    b->start = 0;
+  return 0;
+}
+
+/*************************************************************************
+bucket_swap:
+  In: two buckets
+  Out: No return value.  The buckets' items (and storage) are exchanged.
+*************************************************************************/
+
+static void bucket_swap(struct sched_bucket *a, struct sched_bucket *b) {
+  struct sched_bucket temp = *a;
+  *a = *b;
+  *b = temp;
+}
+
 /*************************************************************************
 create_scheduler:
   In: timestep per slot in this scheduler
@@ -188,16 +321,11 @@ struct schedule_helper *create_scheduler(double dt_min, double dt_max,
   sh->now = start_iterations;
   sh->buf_len = len;
 
-  sh->circ_buf_count = (int *)calloc(len, sizeof(int));
-  if (sh->circ_buf_count == NULL)
+  sh->circ_buf =
+      (struct sched_bucket *)calloc(len, sizeof(struct sched_bucket));
+  if (sh->circ_buf == NULL)
     goto failure;
 
-  sh->circ_buf_head = (struct abstract_element **)calloc(
-      len * 2, sizeof(struct abstract_element*));
-  if (sh->circ_buf_head == NULL)
-    goto failure;
-  sh->circ_buf_tail = sh->circ_buf_head + len;
-
   if (sh->dt * sh->buf_len < dt_max) {
     sh->next_scale =
         create_scheduler(dt_min * len, dt_max, maxlen, sh->now + dt_min * len);
@@ -230,17 +358,7 @@ int schedule_insert(struct schedule_helper *sh, void *data,
 
   if (put_neg_in_current && ae->t < sh->now) {
     /* insert item into current list */
-
-    sh->current_count++;
-    if (sh->current_tail == NULL) {
-      sh->current = sh->current_tail = ae;
-      ae->next = NULL;
-    } else {
-      sh->current_tail->next = ae;
-      sh->current_tail = ae;
-      ae->next = NULL;
-    }
-    return 0;
+    return bucket_push_back(&sh->current, ae);
   }
 
   /* insert item into future lists */
@@ -258,26 +376,13 @@ int schedule_insert(struct schedule_helper *sh, void *data,
     if (i >= sh->buf_len)
       i -= sh->buf_len;
 
-    if (sh->circ_buf_tail[i] == NULL) {
-      sh->circ_buf_count[i] = 1;
-      sh->circ_buf_head[i] = sh->circ_buf_tail[i] = ae;
-      ae->next = NULL;
-    } else {
-      sh->circ_buf_count[i]++;
-
-      /* For schedulers other than the first tier, maintain a LIFO ordering */
-      if (sh->depth) {
-        ae->next = sh->circ_buf_head[i];
-        sh->circ_buf_head[i] = ae;
-      }
+    /* For schedulers other than the first tier, maintain a LIFO ordering */
+    if (sh->depth)
+      return bucket_push_front(&sh->circ_buf[i], ae);
 
-      /* For first-tier scheduler, maintain FIFO ordering */
-      else {
-        sh->circ_buf_tail[i]->next = ae;
-        ae->next = NULL;
-        sh->circ_buf_tail[i] = ae;
-      }
-    }
+    /* For first-tier scheduler, maintain FIFO ordering */
+    else
+      return bucket_push_back(&sh->circ_buf[i], ae);
   } else {
     /* item fits in array for coarser scale */
 
@@ -294,37 +399,6 @@ int schedule_insert(struct schedule_helper *sh, void *data,
      * "current" list */
     return schedule_insert(sh->next_scale, data, 0);
   }
-
-  return 0;
-}
-
-/*************************************************************************
-unlink_list_item:
-  Removes a specific item from the linked list.
-
-  In: struct abstract_element **hd - pointer to head of list
-      struct abstract_element **tl - pointer to tail of list
-      struct abstract_element *it - pointer to item to unlink
-  Out: 0 on success, 1 if the item was not found
-*************************************************************************/
-static int unlink_list_item(struct abstract_element **hd,
-                            struct abstract_element **tl,
-                            struct abstract_element *it) {
-  struct abstract_element *prev = NULL;
-
-  while (*hd != NULL) {
-    if (*hd == it) {
-      (*hd) = (*hd)->next;
-      if (*tl == it)
-        *tl = prev;
-      return 0;
-    }
-
-    prev = *hd;
-    hd = &prev->next;
-  }
-
-  return 1;
 }
 
 /*************************************************************************
@@ -341,13 +415,8 @@ int schedule_deschedule(struct schedule_helper *sh, void *data) {
   struct abstract_element *ae = (struct abstract_element *)data;
 
   /* If the item is in "current" */
-  if (sh->current && ae->t < sh->now) {
-    if (unlink_list_item(&sh->current, &sh->current_tail, ae))
-      return 1;
-
-    --sh->current_count;
-    return 0;
-  }
+  if (sh->current.count > 0 && ae->t < sh->now)
+    return bucket_remove(&sh->current, ae);
 
   double nsteps = (ae->t - sh->now) * sh->dt_1;
   if (nsteps < ((double)sh->buf_len)) {
@@ -359,8 +428,7 @@ int schedule_deschedule(struct schedule_helper *sh, void *data) {
     if (list_idx >= sh->buf_len)
       list_idx -= sh->buf_len;
 
-    if (unlink_list_item(&sh->circ_buf_head[list_idx],
-                         &sh->circ_buf_tail[list_idx], ae)) {
+    if (bucket_remove(&sh->circ_buf[list_idx], ae)) {
       /* If we fail to find it in this level, it may be in the next level.
        * Note that when we are descheduling, we may need to look in more than
        * one place, depending upon how long ago the item to be descheduled was
@@ -376,7 +444,6 @@ int schedule_deschedule(struct schedule_helper *sh, void *data) {
     }
 
     --sh->count;
-    --sh->circ_buf_count[list_idx];
     return 0;
   } else {
     if (!sh->next_scale)
@@ -410,28 +477,104 @@ int schedule_reschedule(struct schedule_helper *sh, void *data, double new_t) {
     return 1;
 }
 
+/*************************************************************************
+slot_index:
+  In: scheduler that we are using
+      time of an item
+  Out: the slot for the item, or -1 if it belongs to a coarser scale
+*************************************************************************/
+
+static int slot_index(struct schedule_helper *sh, double t) {
+  double nsteps = (t - sh->now) * sh->dt_1;
+  if (nsteps >= ((double)sh->buf_len))
+    return -1;
+
+  int i;
+  if (nsteps < 0.0)
+    i = sh->index;
+  else
+    i = (int)nsteps + sh->index;
+  if (i >= sh->buf_len)
+    i -= sh->buf_len;
+  return i;
+}
+
+/*************************************************************************
+distribute_refill:
+  In: scheduler that we are using, which has just wrapped around
+      1 to add items ahead of those already in a slot, 0 to add them after
+  Out: 0 on success, 1 on memory allocation failure.  The items moved down
+       from the coarser scale (sh->refill) are distributed to their slots.
+  Note: This is a stable counting sort on the slot index.  It works from the
+        times stored in the entries, so the items themselves are not touched,
+        and each slot is grown at most once.
+*************************************************************************/
+
+static int distribute_refill(struct schedule_helper *sh, int lifo) {
+  struct sched_bucket *refill = &sh->refill;
+  int n_in_slot[sh->buf_len];
+  memset(n_in_slot, 0, sizeof(n_in_slot));
+
+  int pos = refill->start;
+  for (int k = 0; k < refill->count; k++) {
+    int i = slot_index(sh, refill->items[pos].t);
+    if (i >= 0)
+      n_in_slot[i]++;
+    if (++pos == refill->capacity)
+      pos = 0;
+  }
+
+  for (int i = 0; i < sh->buf_len; i++) {
+    struct sched_bucket *b = &sh->circ_buf[i];
+    if (n_in_slot[i] > 0 && b->count + n_in_slot[i] > b->capacity &&
+        bucket_grow(b, b->count + n_in_slot[i]))
+      return 1;
+  }
+
+  while (refill->count > 0) {
+    struct sched_entry e = refill->items[refill->start];
+    bucket_pop_front(refill);
+
+    int i = slot_index(sh, e.t);
+    if (i < 0) {
+      /* Rounding can leave an item just past this scale's range */
+      if (schedule_insert(sh->next_scale, e.item, 0))
+        return 1;
+      continue;
+    }
+
+    struct sched_bucket *b = &sh->circ_buf[i];
+    if (lifo) {
+      if (--b->start < 0)
+        b->start += b->capacity;
+      b->items[b->start] = e;
+    } else {
+      int back = b->start + b->count;
+      if (back >= b->capacity)
+        back -= b->capacity;
+      b->items[back] = e;
+    }
+    b->count++;
+  }
+
+  return 0;
+}
+
 /*************************************************************************
 schedule_advance:
   In: scheduler that we are using
-      a pointer to the head-pointer for the list of the next time block
-      a pointer to the tail-pointer for the list of the next time block
-  Out: Number of items in the next block of time.  These items start
-      with *head, and end with *tail.  Returns -1 on memory error.
+      an empty bucket to receive the items of the next time block
+  Out: Number of items in the next block of time, which are now in "into"
+       (in the order they should be serviced).  Returns -1 on memory error.
+  Note: The storage of "into" is handed over to the emptied slot, so no
+        items are copied.
 *************************************************************************/
 
-int schedule_advance(struct schedule_helper *sh, struct abstract_element **head,
-                     struct abstract_element **tail) {
+int schedule_advance(struct schedule_helper *sh, struct sched_bucket *into) {
   int n;
-  struct abstract_element *p, *nextp;
 
-  if (head != NULL)
-    *head = sh->circ_buf_head[sh->index];
-  if (tail != NULL)
-    *tail = sh->circ_buf_tail[sh->index];
-
-  sh->circ_buf_head[sh->index] = sh->circ_buf_tail[sh->index] = NULL;
-  sh->count -= n = sh->circ_buf_count[sh->index];
-  sh->circ_buf_count[sh->index] = 0;
+  bucket_swap(into, &sh->circ_buf[sh->index]);
+  sh->count -= n = into->count;
 
   sh->index++;
   sh->now += sh->dt;
@@ -441,34 +584,12 @@ int schedule_advance(struct schedule_helper *sh, struct abstract_element **head,
 
     sh->index = 0;
     if (sh->next_scale != NULL) {
-      /* Save our depth */
-      int old_depth = sh->depth;
-      int conservecount = sh->count;
-
-      /* Hack: Toggle the non-zero-ness of our depth to toggle FIFO/LIFO
-       * behavior
-       */
-      sh->depth = old_depth ? 0 : -1;
-
-      if (schedule_advance(sh->next_scale, &p, NULL) == -1) {
-        sh->depth = old_depth;
+      /* Moved items were already counted when originally scheduled, so they
+       * don't change our count.  Items are added in the reverse of our usual
+       * FIFO/LIFO order. */
+      if (schedule_advance(sh->next_scale, &sh->refill) == -1 ||
+          distribute_refill(sh, sh->depth == 0))
         return -1;
-      }
-      while (p != NULL) {
-        nextp = p->next;
-        if (schedule_insert(sh, (void *)p, 0)) {
-          sh->depth = old_depth;
-          return -1;
-        }
-        p = nextp;
-      }
-
-      /* moved items were already counted when originally scheduled so don't
-       * count again */
-      sh->count = conservecount;
-
-      /* restore our depth */
-      sh->depth = old_depth;
     }
   }
 
@@ -485,21 +606,26 @@ schedule_next:
 *************************************************************************/
 
 void *schedule_next(struct schedule_helper *sh) {
-  void *data;
-
-  if (sh->current == NULL) {
-    sh->current_count = schedule_advance(sh, &sh->current, &sh->current_tail);
-    if (sh->current_count == -1)
+  if (sh->current.count == 0) {
+    if (schedule_advance(sh, &sh->current) == -1)
       sh->error = 1;
     return NULL;
-  } else {
-    sh->current_count--;
-    data = sh->current;
-    sh->current = sh->current->next;
-    if (sh->current == NULL)
-      sh->current_tail = NULL;
-    return data;
-  }
+  } else
+    return bucket_pop_front(&sh->current);
+}
+
+/*************************************************************************
+schedule_peek:
+  In: scheduler that we are using
+  Out: The item schedule_next would return next from the current
+       timestep, which is left in the scheduler, or NULL if no items are
+       left for the current timestep.
+*************************************************************************/
+
+void *schedule_peek(struct schedule_helper *sh) {
+  if (sh->current.count == 0)
+    return NULL;
+  return sh->current.items[sh->current.start].item;
 }
 
 /*************************************************************************
@@ -513,7 +639,7 @@ int schedule_anticipate(struct schedule_helper *sh, double *t) {
   int i, j;
   double earliest_t = DBL_MAX;
 
-  if (sh->current != NULL) {
+  if (sh->current.count > 0) {
     *t = sh->now;
     return 1;
   } else if (sh->count == 0)
@@ -530,7 +656,7 @@ int schedule_anticipate(struct schedule_helper *sh, double *t) {
       j = i + sh->index;
       if (j >= sh->buf_len)
         j -= sh->buf_len;
-      if (sh->circ_buf_count[j] > 0) {
+      if (sh->circ_buf[j].count > 0) {
         earliest_t = sh->now + sh->dt * i;
         break;
       }
@@ -559,7 +685,6 @@ schedule_cleanup(struct schedule_helper *sh,
                  int (*is_defunct)(struct abstract_element*)) {
   struct abstract_element *defunct_list;
   struct abstract_element *ae;
-  struct abstract_element *temp;
   struct schedule_helper *top;
   struct schedule_helper *shp;
   int i;
@@ -568,49 +693,70 @@ schedule_cleanup(struct schedule_helper *sh,
 
   top = sh;
   for (; sh != NULL; sh = sh->next_scale) {
-    sh->defunct_count = 0;
+    __atomic_store_n(&sh->defunct_count, 0, __ATOMIC_RELAXED);
 
     for (i = 0; i < sh->buf_len; i++) {
-      /* Remove defunct elements from beginning of list */
-      while (sh->circ_buf_head[i] != NULL &&
-             (*is_defunct)(sh->circ_buf_head[i])) {
-        temp = sh->circ_buf_head[i]->next;
-        sh->circ_buf_head[i]->next = defunct_list;
-        defunct_list = sh->circ_buf_head[i];
-        sh->circ_buf_head[i] = temp;
-        sh->circ_buf_count[i]--;
-        sh->count--;
-        for (shp = top; shp != sh; shp = shp->next_scale)
-          shp->count--;
-      }
-
-      if (sh->circ_buf_head[i] == NULL) {
-        sh->circ_buf_tail[i] = NULL;
-      } else {
-        /* Now remove defunct elements from later in list */
-        for (ae = sh->circ_buf_head[i]; ae != NULL; ae = ae->next) {
-          while (ae->next != NULL && (*is_defunct)(ae->next)) {
-            temp = ae->next->next;
-            ae->next->next = defunct_list;
-            defunct_list = ae->next;
-            ae->next = temp;
-            sh->circ_buf_count[i]--;
-            sh->count--;
-            for (shp = top; shp != sh; shp = shp->next_scale)
-              shp->count--;
-          }
-          if (ae->next == NULL) {
-            sh->circ_buf_tail[i] = ae;
-            break;
-          }
-        }
+      struct sched_bucket *b = &sh->circ_buf[i];
+
+      /* Keep the live items in order, compacted at the front of the ring */
+      int kept = 0;
+      for (int k = 0; k < b->count; k++) {
+        struct sched_entry *e = &b->items[(b->start + k) % b->capacity];
+        ae = e->item;
+        if ((*is_defunct)(ae)) {
+          ae->next = defunct_list;
+          defunct_list = ae;
+          sh->count--;
+          for (shp = top; shp != sh; shp = shp->next_scale)
+            shp->count--;
+        } else
+          b->items[(b->start + kept++) % b->capacity] = *e;
       }
+      b->count = kept;
+      if (kept == 0)
+        b->start = 0;
     }
   }
 
   return defunct_list;
 }
 
+/*************************************************************************
+schedule_drop_defunct:
+  In: scheduler that we are using
+  Out: the defunct tally is decremented, unless it is already zero (a
+       cleanup may have reset it since the item was counted)
+*************************************************************************/
+
+void schedule_drop_defunct(struct schedule_helper *sh) {
+  int n = __atomic_load_n(&sh->defunct_count, __ATOMIC_RELAXED);
+  while (n > 0 &&
+         !__atomic_compare_exchange_n(&sh->defunct_count, &n, n - 1, 1,
+                                      __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    ;
+}
+
+/*************************************************************************
+schedule_relocate:
+  In: scheduler that we are using
+      pointer to a function that returns the new address of an item, or
+        the item itself if it has not moved
+  Out: No return value.  Every scheduled item is replaced by its new
+       address.  The order of the items is unchanged.
+*************************************************************************/
+
+void schedule_relocate(
+    struct schedule_helper *sh,
+    struct abstract_element *(*relocate)(struct abstract_element *e)) {
+  for (; sh != NULL; sh = sh->next_scale) {
+    for (int i = -1; i < sh->buf_len; i++) {
+      struct sched_bucket *b = schedule_slot(sh, i);
+      for (int k = 0; k < b->count; k++)
+        sched_bucket_item(b, k) = (*relocate)(sched_bucket_item(b, k));
+    }
+  }
+}
+
 /*************************************************************************
 delete_scheduler:
   In: scheduler that we are using
@@ -621,10 +767,13 @@ void delete_scheduler(struct schedule_helper *sh) {
   if (sh) {
     if (sh->next_scale != NULL)
       delete_scheduler(sh->next_scale);
-    if (sh->circ_buf_head)
-      free(sh->circ_buf_head);
-    if (sh->circ_buf_count)
-      free(sh->circ_buf_count);
+    if (sh->circ_buf) {
+      for (int i = 0; i < sh->buf_len; i++)
+        free(sh->circ_buf[i].items);
+      free(sh->circ_buf);
+    }
+    free(sh->current.items);
+    free(sh->refill.items);
     free(sh);
   }
 }
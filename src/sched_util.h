@@ -31,6 +31,26 @@ struct abstract_element {
   double t; /* Time at which the element is scheduled */
 };
 
+/* An item in a scheduler slot, with a copy of its scheduled time.  Items must
+ * be descheduled before their time is changed. */
+struct sched_entry {
+  double t;
+  struct abstract_element *item;
+};
+
+/* Items of one scheduler slot, kept in the order they will be serviced.  The
+ * entries form a ring so items can be added at either end. */
+struct sched_bucket {
+  struct sched_entry *items; /* Ring of "capacity" entries */
+  int start;                 /* Position of the first item in the ring */
+  int count;                 /* Number of items */
+  int capacity;              /* Allocated entries */
+};
+
+/* The k-th item (0 <= k < count) of a bucket, in service order */
+#define sched_bucket_item(b, k)                                                \
+  ((b)->items[((b)->start + (k)) % (b)->capacity].item)
+
 /* Implements a multi-scale, discretized event scheduler */
 struct schedule_helper {
   struct schedule_helper *next_scale; /* Next coarser time scale */
@@ -43,23 +63,33 @@ struct schedule_helper {
   int count;           /* Total number of items scheduled now or after */
   int buf_len;         /* Number of slots in the scheduler */
   int index;           /* Index of the next time block */
-  int *circ_buf_count; /* How many items are scheduled in each slot */
-  // Array of linked lists of scheduled items for each slot
-  struct abstract_element **circ_buf_head; 
-  // Array of tails of the linked lists
-  struct abstract_element **circ_buf_tail; 
+  struct sched_bucket *circ_buf; /* Items scheduled in each slot */
 
   /* Items scheduled before now */
   /* These events must be serviced before simulation can advance to now */
-  int current_count;                     /* Number of current items */
-  struct abstract_element *current;      /* List of items scheduled now */
-  struct abstract_element *current_tail; /* Tail of list of items */
+  struct sched_bucket current;
+
+  struct sched_bucket refill; /* Scratch for items moved down from next_scale */
 
-  int defunct_count; /* Number of defunct items (set by user)*/
+  int defunct_count; /* Number of defunct items (set by user, atomically) */
   int error;         /* Error code (1 - on error, 0 - no errors) */
   int depth;         /* "Tier" of scheduler in timescale hierarchy, 0-based */
 };
 
+/* Nonzero if items scheduled before now are waiting to be serviced */
+#define schedule_has_current(sh) ((sh)->current.count > 0)
+
+/* Reactions on one worker thread may tally defunct items in schedulers that
+   another worker is stepping, so defunct_count is only ever touched through
+   these */
+#define schedule_add_defunct(sh)                                               \
+  ((void)__atomic_fetch_add(&(sh)->defunct_count, 1, __ATOMIC_RELAXED))
+#define schedule_defunct_count(sh)                                             \
+  __atomic_load_n(&(sh)->defunct_count, __ATOMIC_RELAXED)
+
+/* The items of a slot, or of the "current" list if i is -1 */
+#define schedule_slot(sh, i) ((i) < 0 ? &(sh)->current : &(sh)->circ_buf[(i)])
+
 struct abstract_element *ae_list_sort(struct abstract_element *ae);
 
 struct schedule_helper *create_scheduler(double dt_min, double dt_max,
@@ -71,10 +101,10 @@ int schedule_deschedule(struct schedule_helper *sh, void *data);
 int schedule_reschedule(struct schedule_helper *sh, void *data, double new_t);
 /*void schedule_excert(struct schedule_helper *sh,void *data,void *blank,int
  * size);*/
-int schedule_advance(struct schedule_helper *sh, struct abstract_element **head,
-                     struct abstract_element **tail);
+int schedule_advance(struct schedule_helper *sh, struct sched_bucket *into);
 
 void *schedule_next(struct schedule_helper *sh);
+void *schedule_peek(struct schedule_helper *sh);
 #define schedule_add(x, y) schedule_insert((x), (y), 1)
 
 int schedule_anticipate(struct schedule_helper *sh, double *t);
@@ -82,6 +112,12 @@ struct abstract_element *
 schedule_cleanup(struct schedule_helper *sh,
                  int (*is_defunct)(struct abstract_element *e));
 
+void schedule_drop_defunct(struct schedule_helper *sh);
+
+void schedule_relocate(
+    struct schedule_helper *sh,
+    struct abstract_element *(*relocate)(struct abstract_element *e));
+
 void delete_scheduler(struct schedule_helper *sh);
 
 #endif
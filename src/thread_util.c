@@ -0,0 +1,757 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2006-2015 by
+ * The Salk Institute for Biological Studies and
+ * Pittsburgh Supercomputing Center, Carnegie Mellon University
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ *
+******************************************************************************/
+
+/**************************************************************************\
+ ** File: thread_util.c                                                  **
+ **                                                                      **
+ ** Purpose: Runs the timesteps of the memory partitions ("storages") on **
+ **          a pool of worker threads.                                   **
+ **                                                                      **
+ ** Storages are colored by their grid position modulo 3 along each     **
+ ** axis, so two storages of the same color are never neighbors.  All   **
+ ** storages of one color run concurrently; everything a storage        **
+ ** touches while running lies within its neighbors (see the checks in  **
+ ** threads_supported).  Each surface grid lies inside the storage that **
+ ** owns it, so at most one running storage can reach it.  Molecule ids **
+ ** and dissociation indices are interleaved between storages           **
+ ** (new_mol_id), so each storage hands out its own.  Updates of counts **
+ ** shared by all storages -- counters, triggers, reaction and species  **
+ ** statistics -- are held in a list per storage (count_add in          **
+ ** count_util.c) and made at the end of the iteration, storage by      **
+ ** storage.                                                             **
+ **                                                                      **
+ ** A volume molecule that diffuses into a storage run by another       **
+ ** worker is not moved there directly.  Its remaining step is pushed   **
+ ** onto the new storage's lock-free inbound queue (queue_pending_step) **
+ ** and the molecule stays where it is until the new storage adopts it  **
+ ** at the start of its next run (finish_pending_steps in diffuse.c).   **
+ **                                                                      **
+ ** Each worker runs on a private copy of the world with its own        **
+ ** diffusion statistics, which are added back into the real world at   **
+ ** the end of every timestep.  Random numbers come from a stream owned **
+ ** by the storage being run, and storages always run in the same color **
+ ** order, so a seeded run gives the same results on any number of      **
+ ** threads.                                                             **
+\**************************************************************************/
+
+#include "config.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "logging.h"
+#include "mem_util.h"
+#include "rng.h"
+#include "grid_util.h"
+#include "vol_util.h"
+#include "wall_util.h"
+#include "diffuse.h"
+#include "count_util.h"
+#include "thread_util.h"
+
+/* Number of storage colors: 3 along each axis */
+#define NUM_STORAGE_COLORS 27
+
+/* Surface molecule displacements are Gaussian; steps longer than this many
+ * space steps are considered impossible when checking storage sizes */
+#define MAX_SURFACE_STEPS 8.0
+
+struct thread_pool;
+
+struct worker {
+  struct thread_pool *pool;
+  pthread_t thread;
+  struct volume world; /* Private copy of the world */
+
+  /* Scratch pools, lent to each storage the worker runs (see
+   * swap_scratch_pools) */
+  struct mem_helper *coll;
+  struct mem_helper *sp_coll;
+  struct mem_helper *tri_coll;
+  struct mem_helper *exdv;
+
+  struct wall_ray_scratch ray_scratch; /* Own scratch for walls_along_ray */
+  struct surf_rxn_scratch surf_rxn_scratch; /* Own scratch for
+                                               react_2D_all_neighbors */
+};
+
+struct thread_pool {
+  int n_workers;           /* Worker 0 is the main thread */
+  struct worker *workers;
+  int n_storages;
+
+  pthread_mutex_t mutex;   /* Guards the batch fields below */
+  pthread_cond_t work_ready;
+  pthread_cond_t work_done;
+  unsigned long batch;     /* Incremented each time a batch is posted */
+  struct storage **jobs;   /* Storages to run in the current batch */
+  int n_jobs;
+  int next_job;
+  int n_running;           /* Workers still busy with the current batch */
+  double release_time;
+  double checkpt_time;
+
+  /* Storages grouped by color */
+  int color_count[NUM_STORAGE_COLORS];
+  struct storage **colors[NUM_STORAGE_COLORS];
+};
+
+/* Serializes updates of the missed-reaction statistics */
+static pthread_mutex_t missed_reactions_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/*************************************************************************
+clear_statistics:
+  In: world: a worker's copy of the world
+  Out: No return value.  The diffusion and collision statistics are zeroed.
+*************************************************************************/
+static void clear_statistics(struct volume *world) {
+  world->diffusion_number = 0;
+  world->diffusion_cumtime = 0.0;
+  world->ray_voxel_tests = 0;
+  world->ray_polygon_tests = 0;
+  world->ray_polygon_colls = 0;
+  world->vol_vol_colls = 0;
+  world->vol_surf_colls = 0;
+  world->surf_surf_colls = 0;
+  world->vol_wall_colls = 0;
+  world->vol_vol_vol_colls = 0;
+  world->vol_vol_surf_colls = 0;
+  world->vol_surf_surf_colls = 0;
+  world->surf_surf_surf_colls = 0;
+}
+
+/*************************************************************************
+add_statistics:
+  In: world: the shared world
+      copy: a worker's copy of the world
+  Out: No return value.  The statistics gathered by the worker are added
+       into the shared world and cleared in the copy.
+*************************************************************************/
+static void add_statistics(struct volume *world, struct volume *copy) {
+  world->diffusion_number += copy->diffusion_number;
+  world->diffusion_cumtime += copy->diffusion_cumtime;
+  world->ray_voxel_tests += copy->ray_voxel_tests;
+  world->ray_polygon_tests += copy->ray_polygon_tests;
+  world->ray_polygon_colls += copy->ray_polygon_colls;
+  world->vol_vol_colls += copy->vol_vol_colls;
+  world->vol_surf_colls += copy->vol_surf_colls;
+  world->surf_surf_colls += copy->surf_surf_colls;
+  world->vol_wall_colls += copy->vol_wall_colls;
+  world->vol_vol_vol_colls += copy->vol_vol_vol_colls;
+  world->vol_vol_surf_colls += copy->vol_vol_surf_colls;
+  world->vol_surf_surf_colls += copy->vol_surf_surf_colls;
+  world->surf_surf_surf_colls += copy->surf_surf_surf_colls;
+  world->reaction_prob_limit_flag |= copy->reaction_prob_limit_flag;
+  clear_statistics(copy);
+}
+
+/*************************************************************************
+refresh_worker:
+  In: world: the shared world
+      w: a worker
+  Out: No return value.  The worker's copy of the world is brought up to
+       date with the shared world.
+*************************************************************************/
+static void refresh_worker(struct volume *world, struct worker *w) {
+  memcpy(&w->world, world, sizeof(struct volume));
+  w->world.rng = NULL;
+  w->world.shared_world = world;
+  w->world.active_storage = NULL;
+  w->world.ray_scratch = w->ray_scratch;
+  w->world.surf_rxn_scratch = &w->surf_rxn_scratch;
+  clear_statistics(&w->world);
+}
+
+/*************************************************************************
+swap_scratch_pools:
+  In: w: a worker
+      local: a storage
+  Out: No return value.  The worker's collision and vertex pools are
+       exchanged with the storage's.  Calling this again swaps them back.
+  Note: Collision lists only live for one diffusion step, so any pool will
+        do.  Taking them from the worker keeps each thread allocating from
+        the same few blocks, however many storages it runs, and nothing
+        else can touch them.
+*************************************************************************/
+static void swap_scratch_pools(struct worker *w, struct storage *local) {
+  struct mem_helper *mh;
+
+  mh = local->coll;
+  local->coll = w->coll;
+  w->coll = mh;
+
+  mh = local->sp_coll;
+  local->sp_coll = w->sp_coll;
+  w->sp_coll = mh;
+
+  mh = local->tri_coll;
+  local->tri_coll = w->tri_coll;
+  w->tri_coll = mh;
+
+  mh = local->exdv;
+  local->exdv = w->exdv;
+  w->exdv = mh;
+}
+
+/*************************************************************************
+run_storage:
+  In: w: the worker
+      local: the storage to run
+  Out: No return value.  Every molecule due in the storage is updated.
+*************************************************************************/
+static void run_storage(struct worker *w, struct storage *local) {
+  w->world.active_storage = local;
+  w->world.rng = local->rng;
+  w->world.current_mol_id = local->next_mol_id;
+  w->world.dissociation_index = local->dissociation_index;
+  swap_scratch_pools(w, local);
+  run_timestep(&w->world, local, w->pool->release_time,
+               w->pool->checkpt_time);
+  swap_scratch_pools(w, local);
+  local->next_mol_id = w->world.current_mol_id;
+  local->dissociation_index = w->world.dissociation_index;
+  w->world.active_storage = NULL;
+  w->world.rng = NULL;
+}
+
+/*************************************************************************
+run_jobs:
+  In: w: the worker
+  Out: No return value.  Storages of the current batch are claimed and run
+       until none is left.
+  Note: Called and returns with the pool mutex held.
+*************************************************************************/
+static void run_jobs(struct worker *w) {
+  struct thread_pool *pool = w->pool;
+  pool->n_running++;
+  while (pool->next_job < pool->n_jobs) {
+    struct storage *local = pool->jobs[pool->next_job++];
+    pthread_mutex_unlock(&pool->mutex);
+    run_storage(w, local);
+    pthread_mutex_lock(&pool->mutex);
+  }
+  if (--pool->n_running == 0)
+    pthread_cond_signal(&pool->work_done);
+}
+
+static void *worker_main(void *arg) {
+  struct worker *w = (struct worker *)arg;
+  struct thread_pool *pool = w->pool;
+  unsigned long seen = 0;
+
+  /* Workers live until the process exits */
+  pthread_mutex_lock(&pool->mutex);
+  while (1) {
+    while (pool->batch == seen)
+      pthread_cond_wait(&pool->work_ready, &pool->mutex);
+    seen = pool->batch;
+    run_jobs(w);
+  }
+  return NULL;
+}
+
+/*************************************************************************
+run_batch:
+  In: pool: the thread pool
+      jobs: storages which may run concurrently
+      n_jobs: how many
+  Out: No return value.  All of the storages have been run.
+*************************************************************************/
+static void run_batch(struct thread_pool *pool, struct storage **jobs,
+                      int n_jobs) {
+  if (n_jobs == 1) {
+    run_storage(&pool->workers[0], jobs[0]);
+    return;
+  }
+
+  pthread_mutex_lock(&pool->mutex);
+  memcpy(pool->jobs, jobs, n_jobs * sizeof(struct storage *));
+  pool->n_jobs = n_jobs;
+  pool->next_job = 0;
+  pool->batch++;
+  pthread_cond_broadcast(&pool->work_ready);
+  run_jobs(&pool->workers[0]);
+  while (pool->n_running > 0)
+    pthread_cond_wait(&pool->work_done, &pool->mutex);
+  pthread_mutex_unlock(&pool->mutex);
+}
+
+/*************************************************************************
+run_storages_in_parallel:
+  In: world: simulation state
+      release_time: time of the next release event
+      checkpt_time: time of the next checkpoint
+  Out: No return value.  Every storage has run until nothing more is due
+       before the scheduler can advance.
+*************************************************************************/
+void run_storages_in_parallel(struct volume *world, double release_time,
+                              double checkpt_time) {
+  struct thread_pool *pool = world->thread_pool;
+  for (int i = 0; i < pool->n_workers; i++)
+    refresh_worker(world, &pool->workers[i]);
+  pool->release_time = release_time;
+  pool->checkpt_time = checkpt_time;
+
+  /* Storage i hands out ids i, i + n, i + 2n, ... past the shared counter */
+  for (struct storage_list *sl = world->storage_head; sl != NULL;
+       sl = sl->next)
+    sl->store->next_mol_id = world->current_mol_id + sl->store->index;
+
+  struct storage *jobs[pool->n_storages];
+  int busy = 1;
+  while (busy) {
+    busy = 0;
+    for (int c = 0; c < NUM_STORAGE_COLORS; c++) {
+      int n_jobs = 0;
+      for (int i = 0; i < pool->color_count[c]; i++) {
+        struct storage *local = pool->colors[c][i];
+        if (schedule_has_current(local->timer) || has_pending_steps(local))
+          jobs[n_jobs++] = local;
+      }
+      if (n_jobs == 0)
+        continue;
+      busy = 1;
+      run_batch(pool, jobs, n_jobs);
+    }
+  }
+
+  for (int i = 0; i < pool->n_workers; i++)
+    add_statistics(world, &pool->workers[i].world);
+  /* Shared counts are updated storage by storage, so the result doesn't
+   * depend on which worker ran what */
+  for (struct storage_list *sl = world->storage_head; sl != NULL;
+       sl = sl->next) {
+    apply_count_updates(world, sl->store);
+    if (sl->store->next_mol_id > world->current_mol_id)
+      world->current_mol_id = sl->store->next_mol_id;
+  }
+}
+
+/*************************************************************************
+storage_rng_uses:
+  In: world: simulation state
+  Out: The number of random numbers drawn from the storages' streams.
+*************************************************************************/
+long long storage_rng_uses(struct volume *world) {
+  long long uses = 0;
+  if (world->thread_pool == NULL)
+    return 0;
+  for (struct storage_list *sl = world->storage_head; sl != NULL;
+       sl = sl->next)
+    uses += rng_uses(sl->store->rng);
+  return uses;
+}
+
+/*************************************************************************
+storage_stride:
+  In: world: simulation state, or a worker's copy of it
+  Out: The step between consecutive molecule ids and dissociation indices:
+       the number of storages on a worker, 1 otherwise.
+*************************************************************************/
+static int storage_stride(struct volume *world) {
+  if (world->shared_world == NULL)
+    return 1;
+  return world->thread_pool->n_storages;
+}
+
+/*************************************************************************
+new_mol_id:
+  In: world: simulation state, or a worker's copy of it
+  Out: A molecule id no other molecule has.  On a worker the id comes from
+       the running storage's own sequence, so it does not depend on which
+       thread runs the storage or when.
+*************************************************************************/
+u_long new_mol_id(struct volume *world) {
+  u_long id = world->current_mol_id;
+  world->current_mol_id += storage_stride(world);
+  return id;
+}
+
+/*************************************************************************
+return_mol_id:
+  In: world: simulation state, or a worker's copy of it
+  Out: No return value.  The id last handed out by new_mol_id is unused
+       and will be handed out again.
+*************************************************************************/
+void return_mol_id(struct volume *world) {
+  world->current_mol_id -= storage_stride(world);
+}
+
+/*************************************************************************
+advance_dissociation_index:
+  In: world: simulation state, or a worker's copy of it
+  Out: No return value.  The next pair of dissociation products gets a new
+       index.  On a worker the indices stay in the running storage's own
+       sequence when they wrap around.
+*************************************************************************/
+void advance_dissociation_index(struct volume *world) {
+  int stride = storage_stride(world);
+  world->dissociation_index -= stride;
+  if (world->dissociation_index < DISSOCIATION_MIN)
+    world->dissociation_index =
+        DISSOCIATION_MAX -
+        (DISSOCIATION_MAX - world->dissociation_index) % stride;
+}
+
+/*************************************************************************
+add_missed_reactions:
+  In: rx: a reaction
+      n_missed: how many reactions were missed because the reaction
+                probability exceeded 1
+  Out: No return value.  The reaction's statistics are updated.
+*************************************************************************/
+void add_missed_reactions(struct rxn *rx, double n_missed) {
+  pthread_mutex_lock(&missed_reactions_mutex);
+  rx->n_skipped += n_missed;
+  pthread_mutex_unlock(&missed_reactions_mutex);
+}
+
+/*************************************************************************
+queue_pending_step:
+  In: dest: storage the molecule is moving into
+      ps: the rest of the molecule's diffusion step
+  Out: No return value.  The step is added to the storage's inbound queue
+       without taking a lock; any number of workers may add at once.
+*************************************************************************/
+void queue_pending_step(struct storage *dest, struct pending_step *ps) {
+  struct pending_step *head = __atomic_load_n(&dest->inbound, __ATOMIC_RELAXED);
+  do
+    ps->next = head;
+  while (!__atomic_compare_exchange_n(&dest->inbound, &head, ps, 1,
+                                      __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+/*************************************************************************
+sort_pending_steps:
+  In: ps: a list of pending steps
+      n: how many
+  Out: The list, sorted by molecule id.
+*************************************************************************/
+static struct pending_step *sort_pending_steps(struct pending_step *ps,
+                                               int n) {
+  if (n < 2)
+    return ps;
+
+  struct pending_step *second = ps;
+  for (int i = 1; i < n / 2; i++)
+    second = second->next;
+  struct pending_step *rest = second->next;
+  second->next = NULL;
+
+  struct pending_step *a = sort_pending_steps(ps, n / 2);
+  struct pending_step *b = sort_pending_steps(rest, n - n / 2);
+  struct pending_step *head = NULL;
+  struct pending_step **tail = &head;
+  while (a != NULL && b != NULL) {
+    if (a->vm->id <= b->vm->id) {
+      *tail = a;
+      a = a->next;
+    } else {
+      *tail = b;
+      b = b->next;
+    }
+    tail = &(*tail)->next;
+  }
+  *tail = (a != NULL) ? a : b;
+  return head;
+}
+
+/*************************************************************************
+take_pending_steps:
+  In: local: storage run by the calling worker
+  Out: The steps queued on the storage, ordered by molecule id, or NULL if
+       there are none.  The queue is left empty.
+  Note: Workers queue steps in whatever order they happen to run, so the
+        steps are sorted to make the run independent of the thread count.
+*************************************************************************/
+struct pending_step *take_pending_steps(struct storage *local) {
+  struct pending_step *ps =
+      __atomic_exchange_n(&local->inbound, NULL, __ATOMIC_ACQUIRE);
+  int n = 0;
+  for (struct pending_step *p = ps; p != NULL; p = p->next)
+    n++;
+  return sort_pending_steps(ps, n);
+}
+
+/*************************************************************************
+has_pending_steps:
+  In: local: a storage
+  Out: 1 if steps are queued on the storage, 0 otherwise.
+*************************************************************************/
+int has_pending_steps(struct storage *local) {
+  return __atomic_load_n(&local->inbound, __ATOMIC_ACQUIRE) != NULL;
+}
+
+/*************************************************************************
+min_storage_width:
+  In: parts: partition boundaries along one axis
+      n_parts: number of partition boundaries
+      mem_part: number of subvolumes per storage along this axis
+  Out: The width of the narrowest storage along the axis.
+*************************************************************************/
+static double min_storage_width(double *parts, int n_parts, int mem_part) {
+  double width = GIGANTIC;
+  for (int start = 0; start < n_parts - 1; start += mem_part) {
+    int end = start + mem_part;
+    if (end > n_parts - 1)
+      end = n_parts - 1;
+    if (parts[end] - parts[start] < width)
+      width = parts[end] - parts[start];
+  }
+  return width;
+}
+
+/*************************************************************************
+storage_extent:
+  In: parts: partition boundaries along one axis
+      n_parts: number of partition boundaries
+      mem_part: number of subvolumes per storage along this axis
+      cell: position of a storage in the grid of storages along the axis
+      lo, hi: to hold the bounds of the storage along the axis
+  Out: No return value.
+*************************************************************************/
+static void storage_extent(double *parts, int n_parts, int mem_part, int cell,
+                           double *lo, double *hi) {
+  int start = cell * mem_part;
+  int end = start + mem_part;
+  if (end > n_parts - 1)
+    end = n_parts - 1;
+  *lo = parts[start];
+  *hi = parts[end];
+}
+
+/*************************************************************************
+wall_within_owner:
+  In: world: simulation state
+      w: a wall
+      guess: a subvolume the wall passes through
+  Out: 1 if the wall lies inside the storage holding its centroid, which
+       owns its surface grid (see create_grid), 0 if it reaches past it.
+  Note: Only the owner's worker and the workers of its neighbors may then
+        touch the grid, and no two of those run at once.  A wall reaching
+        into two storages could be touched by two storages of one color.
+*************************************************************************/
+static int wall_within_owner(struct volume *world, struct wall *w,
+                             struct subvolume *guess) {
+  struct vector3 center;
+  center.x = (w->vert[0]->x + w->vert[1]->x + w->vert[2]->x) / 3.0;
+  center.y = (w->vert[0]->y + w->vert[1]->y + w->vert[2]->y) / 3.0;
+  center.z = (w->vert[0]->z + w->vert[1]->z + w->vert[2]->z) / 3.0;
+  struct storage *owner = find_subvolume(world, &center, guess)->local_storage;
+
+  struct vector3 llf, urb;
+  storage_extent(world->x_partitions, world->nx_parts, world->mem_part_x,
+                 owner->grid_x, &llf.x, &urb.x);
+  storage_extent(world->y_partitions, world->ny_parts, world->mem_part_y,
+                 owner->grid_y, &llf.y, &urb.y);
+  storage_extent(world->z_partitions, world->nz_parts, world->mem_part_z,
+                 owner->grid_z, &llf.z, &urb.z);
+
+  for (int i = 0; i < 3; i++) {
+    struct vector3 *v = w->vert[i];
+    if (v->x < llf.x || v->x > urb.x || v->y < llf.y || v->y > urb.y ||
+        v->z < llf.z || v->z > urb.z)
+      return 0;
+  }
+  return 1;
+}
+
+/*************************************************************************
+has_surface_molecules:
+  In: world: simulation state
+  Out: 1 if the model has a surface molecule species, 0 otherwise.
+*************************************************************************/
+static int has_surface_molecules(struct volume *world) {
+  for (int i = 0; i < world->n_species; i++) {
+    if ((world->species_list[i]->flags & NOT_FREE) == ON_GRID)
+      return 1;
+  }
+  return 0;
+}
+
+/*************************************************************************
+threads_supported:
+  In: world: simulation state
+  Out: 1 if the model can run its storages in parallel, 0 (with a warning)
+       if it must run serially.
+*************************************************************************/
+static int threads_supported(struct volume *world) {
+  double reach = world->rx_radius_3d;
+  if (reach * reach < world->vacancy_search_dist2)
+    reach = sqrt(world->vacancy_search_dist2);
+
+  for (int i = 0; i < world->n_species; i++) {
+    struct species *sp = world->species_list[i];
+    if (sp->flags & IS_COMPLEX) {
+      mcell_warn("Macromolecular complexes can't run on multiple threads.");
+      return 0;
+    }
+    if (sp->flags & (CAN_VOLVOLVOL | CAN_VOLVOLSURF)) {
+      mcell_warn("Trimolecular volume reactions can't run on multiple "
+                 "threads.");
+      return 0;
+    }
+    if ((sp->flags & ON_GRID) && sp->space_step > 0.0) {
+      double step = MAX_SURFACE_STEPS * sp->space_step;
+      if ((sp->flags & SET_MAX_STEP_LENGTH) && sp->max_step_length < step)
+        step = sp->max_step_length;
+      if (step > reach)
+        reach = step;
+    }
+  }
+
+  for (int i = 0; i < world->rx_hashsize; i++) {
+    for (struct rxn *rx = world->reaction_hash[i]; rx != NULL; rx = rx->next) {
+      if (rx->prob_t != NULL) {
+        mcell_warn("Reactions with time-varying rates can't run on multiple "
+                   "threads.");
+        return 0;
+      }
+    }
+  }
+
+  double width =
+      min_storage_width(world->x_partitions, world->nx_parts, world->mem_part_x);
+  double w = min_storage_width(world->y_partitions, world->ny_parts,
+                               world->mem_part_y);
+  if (w < width)
+    width = w;
+  w = min_storage_width(world->z_partitions, world->nz_parts,
+                        world->mem_part_z);
+  if (w < width)
+    width = w;
+  if (width <= reach) {
+    mcell_warn("Memory partitions are too small to run on multiple threads "
+               "(narrowest is %g microns, interactions reach %g microns).",
+               width * world->length_unit, reach * world->length_unit);
+    return 0;
+  }
+
+  /* Surface grids belong to a single storage, so walls that carry them must
+   * not reach into another one */
+  for (int i = 0; has_surface_molecules(world) && i < world->n_subvols; i++) {
+    struct subvolume *sv = &world->subvol[i];
+    for (struct wall_list *wl = sv->wall_head; wl != NULL; wl = wl->next) {
+      if (!wall_within_owner(world, wl->this_wall, sv)) {
+        mcell_warn("Wall %d of object '%s' reaches across memory partitions, "
+                   "so its surface molecules can't run on multiple threads.",
+                   wl->this_wall->side, wl->this_wall->parent_object->sym->name);
+        return 0;
+      }
+    }
+  }
+
+  return 1;
+}
+
+/*************************************************************************
+init_thread_pool:
+  In: world: simulation state
+  Out: 0 on success, 1 on failure.  If threads were requested and the model
+       allows it, the worker threads are started.
+  Note: A pool of one thread runs the storages in the same order and with
+        the same random streams as a larger pool, so its results can be
+        compared against threaded runs.
+*************************************************************************/
+int init_thread_pool(struct volume *world) {
+  if (world->num_threads == 0)
+    return 0;
+
+  if (!threads_supported(world)) {
+    mcell_warn("Running memory partitions serially.");
+    world->num_threads = 0;
+    return 0;
+  }
+
+  struct thread_pool *pool =
+      CHECKED_MALLOC_STRUCT(struct thread_pool, "thread pool");
+  memset(pool, 0, sizeof(struct thread_pool));
+  pool->n_workers = world->num_threads;
+  pool->workers =
+      CHECKED_MALLOC_ARRAY(struct worker, pool->n_workers, "worker threads");
+  for (struct storage_list *sl = world->storage_head; sl != NULL;
+       sl = sl->next) {
+    sl->store->index = pool->n_storages++;
+    sl->store->dissociation_index = DISSOCIATION_MAX - sl->store->index;
+  }
+  pool->jobs = CHECKED_MALLOC_ARRAY(struct storage *, pool->n_storages,
+                                    "storage jobs");
+  pthread_mutex_init(&pool->mutex, NULL);
+  pthread_cond_init(&pool->work_ready, NULL);
+  pthread_cond_init(&pool->work_done, NULL);
+
+  /* Group the storages by color */
+  for (int c = 0; c < NUM_STORAGE_COLORS; c++)
+    pool->colors[c] = CHECKED_MALLOC_ARRAY(struct storage *, pool->n_storages,
+                                           "storage colors");
+  for (struct storage_list *sl = world->storage_head; sl != NULL;
+       sl = sl->next) {
+    struct storage *local = sl->store;
+    int c = local->grid_x % 3 + 3 * (local->grid_y % 3 + 3 * (local->grid_z % 3));
+    pool->colors[c][pool->color_count[c]++] = local;
+  }
+
+  /* Surface grids are otherwise created on demand, and a wall is listed in
+   * every subvolume it passes through */
+  for (int i = 0; has_surface_molecules(world) && i < world->n_subvols; i++) {
+    struct subvolume *sv = &world->subvol[i];
+    for (struct wall_list *wl = sv->wall_head; wl != NULL; wl = wl->next) {
+      if (wl->this_wall->grid == NULL && create_grid(world, wl->this_wall, sv))
+        mcell_allocfailed("Failed to create surface grid.");
+    }
+  }
+
+  world->thread_pool = pool;
+  for (int i = 0; i < pool->n_workers; i++) {
+    struct worker *w = &pool->workers[i];
+    w->pool = pool;
+    if (create_wall_ray_scratch(world, &w->ray_scratch))
+      mcell_allocfailed("Failed to create wall scratch space for worker "
+                        "thread %d.", i);
+    memset(&w->surf_rxn_scratch, 0, sizeof(struct surf_rxn_scratch));
+    refresh_worker(world, w);
+    if ((w->coll = create_mem_named(sizeof(struct collision), 128,
+                                    "collision")) == NULL ||
+        (w->sp_coll = create_mem_named(sizeof(struct sp_collision), 128,
+                                       "sp collision")) == NULL ||
+        (w->tri_coll = create_mem_named(sizeof(struct tri_collision), 128,
+                                        "tri collision")) == NULL ||
+        (w->exdv = create_mem_named(sizeof(struct exd_vertex), 64,
+                                    "exact disk vertex")) == NULL)
+      mcell_allocfailed("Failed to create scratch memory pools for worker "
+                        "thread %d.", i);
+  }
+  for (int i = 1; i < pool->n_workers; i++) {
+    if (pthread_create(&pool->workers[i].thread, NULL, worker_main,
+                       &pool->workers[i]) != 0)
+      mcell_error("Failed to start worker thread %d.", i);
+  }
+
+  if (world->notify->progress_report != NOTIFY_NONE)
+    mcell_log("Running memory partitions on %d thread%s.", pool->n_workers,
+              pool->n_workers == 1 ? "" : "s");
+
+  return 0;
+}
@@ -0,0 +1,46 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2006-2015 by
+ * The Salk Institute for Biological Studies and
+ * Pittsburgh Supercomputing Center, Carnegie Mellon University
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ *
+******************************************************************************/
+
+#ifndef THREAD_UTIL_H
+#define THREAD_UTIL_H
+
+#include "mcell_structs.h"
+
+int init_thread_pool(struct volume *world);
+
+void run_storages_in_parallel(struct volume *world, double release_time,
+                              double checkpt_time);
+
+long long storage_rng_uses(struct volume *world);
+
+u_long new_mol_id(struct volume *world);
+void return_mol_id(struct volume *world);
+void advance_dissociation_index(struct volume *world);
+
+void add_missed_reactions(struct rxn *rx, double n_missed);
+
+void queue_pending_step(struct storage *dest, struct pending_step *ps);
+struct pending_step *take_pending_steps(struct storage *local);
+int has_pending_steps(struct storage *local);
+
+#endif
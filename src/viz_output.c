@@ -171,11 +171,9 @@ static int sort_molecules_by_species(struct volume *world,
     for (shp = sp->timer; shp != NULL; shp = shp->next_scale) {
       for (sched_slot_index = -1; sched_slot_index < shp->buf_len;
            ++sched_slot_index) {
-        for (amp = (struct abstract_molecule *)((sched_slot_index < 0)
-                                                    ? shp->current
-                                                    : shp->circ_buf_head
-                                                          [sched_slot_index]);
-             amp != NULL; amp = amp->next) {
+        struct sched_bucket *slot = schedule_slot(shp, sched_slot_index);
+        for (int k = 0; k < slot->count; k++) {
+          amp = (struct abstract_molecule *)sched_bucket_item(slot, k);
           u_int spec_id;
           if (amp->properties == NULL)
             continue;
@@ -5584,7 +5582,6 @@ static int output_ascii_molecules(struct volume *world,
   char *cf_name;
   struct storage_list *slp;
   struct schedule_helper *shp;
-  struct abstract_element *aep;
   struct abstract_molecule *amp;
   struct volume_molecule *mp;
   struct surface_molecule *gmp;
@@ -5625,9 +5622,9 @@ static int output_ascii_molecules(struct volume *world,
     for (slp = world->storage_head; slp != NULL; slp = slp->next) {
       for (shp = slp->store->timer; shp != NULL; shp = shp->next_scale) {
         for (i = -1; i < shp->buf_len; i++) {
-          for (aep = (i < 0) ? shp->current : shp->circ_buf_head[i];
-               aep != NULL; aep = aep->next) {
-            amp = (struct abstract_molecule *)aep;
+          struct sched_bucket *slot = schedule_slot(shp, i);
+          for (int k = 0; k < slot->count; k++) {
+            amp = (struct abstract_molecule *)sched_bucket_item(slot, k);
             if (amp->properties == NULL)
               continue;
 
@@ -47,8 +47,35 @@
 #include "grid_util.h"
 #include "macromolecule.h"
 
+/* Share of the adaptive partitions placed by vertex density rather than by
+ * length, so that empty space is still partitioned */
+#define ADAPTIVE_PARTITION_WEIGHT 0.5
+
+/* set_fineparts places the coarse partitions spanning the bounding box on
+ * fine partitions FINE_PARTITION_OFFSET through FINE_PARTITION_OFFSET +
+ * FINE_PARTITION_SPAN */
+#define FINE_PARTITION_OFFSET 4096
+#define FINE_PARTITION_SPAN 16384
+
+/* Fine partitions along each axis: the span over the bounding box, with
+ * FINE_PARTITION_OFFSET growing exponentially towards infinity on either
+ * side */
+#define N_FINE_PARTITIONS                                                      \
+  (FINE_PARTITION_OFFSET + FINE_PARTITION_SPAN + FINE_PARTITION_OFFSET)
+
 static int test_max_release(double num_to_release, char *name);
 
+static double *refine_partitions(double const *samples, int n_samples,
+                                 double min, double max, double *fineparts,
+                                 double *partitions, int *n_parts, int in,
+                                 int start, double spacing);
+
+static void adapt_partitions(double const *samples, int n_samples,
+                             double const *fineparts, double *partitions,
+                             int in, int start, double spacing);
+
+static int count_below(double const *values, int n, double x);
+
 static int check_release_probability(double release_prob, struct volume *state,
                                      struct release_event_queue *req,
                                      struct release_pattern *rpat);
@@ -382,6 +409,28 @@ int is_defunct_molecule(struct abstract_element *e) {
   return ((struct abstract_molecule *)e)->properties == NULL;
 }
 
+/*************************************************************************
+remove_defunct_molecules
+  In: timer: a storage's scheduler
+  Out: No return value.  Defunct molecules are taken out of the scheduler,
+       and freed unless something else still holds them.
+*************************************************************************/
+void remove_defunct_molecules(struct schedule_helper *timer) {
+  struct abstract_molecule *am;
+  am = (struct abstract_molecule *)schedule_cleanup(timer,
+                                                    *is_defunct_molecule);
+  while (am != NULL) {
+    struct abstract_molecule *temp = am;
+    am = am->next;
+    if ((temp->flags & IN_MASK) == IN_SCHEDULE) {
+      temp->next = NULL;
+      mem_put(temp->birthplace, temp);
+    } else {
+      temp->flags &= ~IN_SCHEDULE;
+    }
+  }
+}
+
 /*************************************************************************
 place_surface_molecule
   In: species for the new molecule
@@ -686,7 +735,106 @@ struct volume_molecule *insert_volume_molecule(struct volume *state,
   return new_vm;
 }
 
+/*************************************************************************
+add_packed_position:
+  In: psl: the per-species list the molecule has just been linked into
+      vm: the molecule
+  Out: No return value.  The molecule's position is appended to the list's
+       packed arrays and the molecule remembers its slot.
+*************************************************************************/
+static void add_packed_position(struct per_species_list *psl,
+                                struct volume_molecule *vm) {
+  if (psl->n_mols == psl->max_mols) {
+    int max_mols = (psl->max_mols == 0) ? 8 : 2 * psl->max_mols;
+    double *x = realloc(psl->x, max_mols * sizeof(double));
+    double *y = realloc(psl->y, max_mols * sizeof(double));
+    double *z = realloc(psl->z, max_mols * sizeof(double));
+    struct volume_molecule **mols =
+        realloc(psl->mols, max_mols * sizeof(struct volume_molecule *));
+    if (x == NULL || y == NULL || z == NULL || mols == NULL)
+      mcell_allocfailed("Failed to grow per-species molecule positions.");
+    psl->x = x;
+    psl->y = y;
+    psl->z = z;
+    psl->mols = mols;
+    psl->max_mols = max_mols;
+  }
+
+  int slot = psl->n_mols++;
+  psl->x[slot] = vm->pos.x;
+  psl->y[slot] = vm->pos.y;
+  psl->z[slot] = vm->pos.z;
+  psl->mols[slot] = vm;
+  vm->psl = psl;
+  vm->psl_slot = slot;
+}
+
+/*************************************************************************
+remove_packed_position:
+  In: vm: a molecule that has just been unlinked from its list
+  Out: No return value.  The last entry of the list's packed arrays is
+       moved into the molecule's slot.
+*************************************************************************/
+static void remove_packed_position(struct volume_molecule *vm) {
+  struct per_species_list *psl = vm->psl;
+  if (psl == NULL)
+    return;
+
+  int last = --psl->n_mols;
+  int slot = vm->psl_slot;
+  if (slot != last) {
+    struct volume_molecule *moved = psl->mols[last];
+    psl->x[slot] = psl->x[last];
+    psl->y[slot] = psl->y[last];
+    psl->z[slot] = psl->z[last];
+    psl->mols[slot] = moved;
+    moved->psl_slot = slot;
+  }
+  vm->psl = NULL;
+}
+
+/*************************************************************************
+molecules_in_box:
+  In: psl: a per-species list
+      first: index of the first packed entry to look at
+      llf, urb: corners of the box of interest
+      hits: array of at least MOLECULE_SCAN_CHUNK entries
+  Out: The number of molecules found.  The packed indices of the molecules
+       among entries first to first + MOLECULE_SCAN_CHUNK - 1 lying inside
+       the box are written to hits.
+  Note: Only coordinates are read, and without branches, so the compiler is
+        free to vectorize the scan.  Defunct molecules are not filtered out.
+*************************************************************************/
+int molecules_in_box(struct per_species_list const *psl, int first,
+                     struct vector3 const *llf, struct vector3 const *urb,
+                     int *hits) {
+  int end = min2i(psl->n_mols, first + MOLECULE_SCAN_CHUNK);
+  double const *x = psl->x, *y = psl->y, *z = psl->z;
+  int n_hits = 0;
+  for (int i = first; i < end; i++) {
+    hits[n_hits] = i;
+    n_hits += (x[i] >= llf->x) & (x[i] <= urb->x) & (y[i] >= llf->y) &
+              (y[i] <= urb->y) & (z[i] >= llf->z) & (z[i] <= urb->z);
+  }
+  return n_hits;
+}
+
+/*************************************************************************
+collect_species_list:
+  In: local: the storage the list was allocated from
+      psl: an empty per-species list, already unlinked from its subvolume
+  Out: No return value.  The list and its packed arrays are freed.
+*************************************************************************/
+void collect_species_list(struct storage *local, struct per_species_list *psl) {
+  free(psl->x);
+  free(psl->y);
+  free(psl->z);
+  free(psl->mols);
+  mem_put(local->pslv, psl);
+}
+
 static int remove_from_list(struct volume_molecule *it) {
+  it->subvol->mol_epoch++;
   if (it->prev_v) {
 #ifdef DEBUG_LIST_CHECKS
     if (*it->prev_v != it) {
@@ -709,6 +857,7 @@ static int remove_from_list(struct volume_molecule *it) {
   }
   it->prev_v = NULL;
   it->next_v = NULL;
+  remove_packed_position(it);
   return 1;
 }
 
@@ -749,6 +898,109 @@ struct volume_molecule *migrate_volume_molecule(struct volume_molecule *vm,
   return new_vm;
 }
 
+/*************************************************************************
+relocated_molecule:
+  In: e: a scheduled molecule
+  Out: The molecule's new address if compact_storage moved it, or the
+       molecule itself.
+*************************************************************************/
+static struct abstract_element *relocated_molecule(struct abstract_element *e) {
+  struct abstract_molecule *am = (struct abstract_molecule *)e;
+  if (am->birthplace == NULL)
+    return (struct abstract_element *)am->next;
+  return e;
+}
+
+/*************************************************************************
+compact_storage:
+  In: world: simulation state
+      local: a storage
+  Out: No return value.  The storage's volume molecules are copied into
+       fresh blocks in subvolume and species order, so molecules that are
+       scanned together lie together, and the old blocks are freed.
+  Note: Only safe between iterations: the molecules must be reachable
+        from the subvolume lists or the storage's scheduler, and nothing
+        else may hold on to them.
+*************************************************************************/
+static void compact_storage(struct volume *world, struct storage *local) {
+  /* Whatever is left in the pool after this is in a subvolume list */
+  remove_defunct_molecules(local->timer);
+
+  struct mem_helper *fresh = create_mem_named(
+      sizeof(struct volume_molecule), local->mol->buf_len, local->mol->name);
+  if (fresh == NULL)
+    mcell_allocfailed("Failed to create memory pool for compacting volume "
+                      "molecules.");
+
+  int x_min = local->grid_x * world->mem_part_x;
+  int y_min = local->grid_y * world->mem_part_y;
+  int z_min = local->grid_z * world->mem_part_z;
+  int x_max = min2i(x_min + world->mem_part_x, world->nx_parts - 1);
+  int y_max = min2i(y_min + world->mem_part_y, world->ny_parts - 1);
+  int z_max = min2i(z_min + world->mem_part_z, world->nz_parts - 1);
+  for (int i = x_min; i < x_max; i++)
+    for (int j = y_min; j < y_max; j++)
+      for (int k = z_min; k < z_max; k++) {
+        int h = k + (world->nz_parts - 1) * (j + (world->ny_parts - 1) * i);
+        struct subvolume *sv = &world->subvol[h];
+        sv->mol_epoch++; /* molecules move to new addresses */
+        for (struct per_species_list *psl = sv->species_head; psl != NULL;
+             psl = psl->next) {
+          struct volume_molecule **tail = &psl->head;
+          struct volume_molecule *vm = psl->head;
+          while (vm != NULL) {
+            struct volume_molecule *next = vm->next_v;
+            if (vm->birthplace == local->mol) {
+              struct volume_molecule *moved = (struct volume_molecule *)
+                  CHECKED_MEM_GET(fresh, "volume molecule");
+              memcpy(moved, vm, sizeof(struct volume_molecule));
+              moved->next = NULL;
+
+              vm->psl->mols[vm->psl_slot] = moved;
+
+              /* Leave the new address for relocated_molecule */
+              vm->next = (struct abstract_molecule *)moved;
+              vm->birthplace = NULL;
+              vm = moved;
+            }
+            *tail = vm;
+            vm->prev_v = tail;
+            tail = &vm->next_v;
+            vm = next;
+          }
+          *tail = NULL;
+        }
+      }
+
+  schedule_relocate(local->timer, relocated_molecule);
+  mem_exchange_blocks(local->mol, fresh);
+  delete_mem(fresh);
+}
+
+/*************************************************************************
+compact_volume_molecules:
+  In: world: simulation state
+  Out: No return value.  The volume molecules of every storage are packed
+       into contiguous memory in subvolume and species order.  Nothing is
+       done if the model has macromolecular complexes, whose subunits
+       point at each other.
+*************************************************************************/
+void compact_volume_molecules(struct volume *world) {
+  for (int i = 0; i < world->n_species; i++) {
+    if (world->species_list[i]->flags & IS_COMPLEX) {
+      mcell_warn("Volume molecules can't be compacted in models with "
+                 "macromolecular complexes.  Ignoring "
+                 "MEMORY_COMPACTION_INTERVAL.");
+      world->mem_compact_interval = 0;
+      return;
+    }
+  }
+
+  for (struct storage_list *sl = world->storage_head; sl != NULL;
+       sl = sl->next)
+    compact_storage(world, sl->store);
+}
+
 /*************************************************************************
 eval_rel_region_3d:
   In: an expression tree containing regions to release on
@@ -963,8 +1215,8 @@ static int vacuum_inside_regions(struct volume *state,
         count_region_from_scratch(state, (struct abstract_molecule *)mp, NULL,
                                   -1, &(mp->pos), NULL, mp->t);
       if (mp->flags & IN_SCHEDULE) {
-        mp->subvol->local_storage->timer
-            ->defunct_count++; /* Tally for garbage collection */
+        /* Tally for garbage collection */
+        schedule_add_defunct(mp->subvol->local_storage->timer);
       }
       collect_molecule(mp);
 
@@ -1632,9 +1884,9 @@ int set_partitions(struct volume *state) {
     smallest_spacing = 2 * state->rx_radius_3d;
 
   /* We have 2^15 possible fine partitions; we'll use 24k of them */
-  if (state->n_fineparts != 4096 + 16384 + 4096) {
+  if (state->n_fineparts != N_FINE_PARTITIONS) {
 
-    state->n_fineparts = 4096 + 16384 + 4096;
+    state->n_fineparts = N_FINE_PARTITIONS;
     state->x_fineparts =
         CHECKED_MALLOC_ARRAY(double, state->n_fineparts, "x fine partitions");
     state->y_fineparts =
@@ -1718,8 +1970,14 @@ int set_partitions(struct volume *state) {
     set_auto_partitions(state, steps_min, steps_max, &part_min, &part_max,
                         f_max, smallest_spacing);
   } else {
+    if (state->adaptive_partitions)
+      mcell_warn("ADAPTIVE_PARTITIONS is ignored, since partitions are "
+                 "given explicitly.");
     set_user_partitions(state, dfx, dfy, dfz);
   }
+  free(state->partition_samples);
+  state->partition_samples = NULL;
+  state->n_partition_samples = state->max_partition_samples = 0;
 
   /* And finally we tell the user what happened */
   if (state->notify->partition_location == NOTIFY_FULL) {
@@ -1764,22 +2022,25 @@ double increase_fine_partition_size(struct volume *state, double *fineparts,
                     (*f_max) * state->length_unit);
   }
   // Set bounds over which to do linear subdivision (state bounding box)
-  double df = (*f_max - *f_min) / 16383.0;
+  double df = (*f_max - *f_min) / (double)(FINE_PARTITION_SPAN - 1);
   // Subdivide state bounding box
-  for (int i = 0; i < 16384; i++) {
-    fineparts[4096 + i] = *f_min + df * ((double)i);
+  for (int i = 0; i < FINE_PARTITION_SPAN; i++) {
+    fineparts[FINE_PARTITION_OFFSET + i] = *f_min + df * ((double)i);
   }
 
   /* Create an exponentially increasing fine partition size as we go to
    * -infinity */
   double A, B, k;
-  find_exponential_params(-*f_min, 1e12, df, 4096, &A, &B, &k);
-  for (int i = 1; i <= 4096; i++)
-    fineparts[4096 - i] = -(A * exp(i * k) + B);
+  find_exponential_params(-*f_min, 1e12, df, FINE_PARTITION_OFFSET, &A, &B,
+                          &k);
+  for (int i = 1; i <= FINE_PARTITION_OFFSET; i++)
+    fineparts[FINE_PARTITION_OFFSET - i] = -(A * exp(i * k) + B);
   /* And again as we go to +infinity */
-  find_exponential_params(*f_max, 1e12, df, 4096, &A, &B, &k);
-  for (int i = 1; i <= 4096; i++)
-    fineparts[4096 + 16383 + i] = A * exp(i * k) + B;
+  find_exponential_params(*f_max, 1e12, df, FINE_PARTITION_OFFSET, &A, &B,
+                          &k);
+  for (int i = 1; i <= FINE_PARTITION_OFFSET; i++)
+    fineparts[FINE_PARTITION_OFFSET + FINE_PARTITION_SPAN - 1 + i] =
+        A * exp(i * k) + B;
   return df;
 }
 
@@ -1864,6 +2125,189 @@ void set_auto_partitions(struct volume *state, double steps_min,
                 state->y_fineparts, state->ny_parts, y_in, y_start);
   set_fineparts(part_min->z, part_max->z, state->z_partitions,
                 state->z_fineparts, state->nz_parts, z_in, z_start);
+
+  if (state->adaptive_partitions && state->n_partition_samples > 0) {
+    int n = state->n_partition_samples;
+    double *samples = CHECKED_MALLOC_ARRAY(double, n, "partition samples");
+
+    for (int i = 0; i < n; i++)
+      samples[i] = state->partition_samples[i].x;
+    qsort(samples, n, sizeof(double), &double_cmp);
+    state->x_partitions = refine_partitions(
+        samples, n, part_min->x, part_max->x, state->x_fineparts,
+        state->x_partitions, &state->nx_parts, x_in, x_start, smallest_spacing);
+
+    for (int i = 0; i < n; i++)
+      samples[i] = state->partition_samples[i].y;
+    qsort(samples, n, sizeof(double), &double_cmp);
+    state->y_partitions = refine_partitions(
+        samples, n, part_min->y, part_max->y, state->y_fineparts,
+        state->y_partitions, &state->ny_parts, y_in, y_start, smallest_spacing);
+
+    for (int i = 0; i < n; i++)
+      samples[i] = state->partition_samples[i].z;
+    qsort(samples, n, sizeof(double), &double_cmp);
+    state->z_partitions = refine_partitions(
+        samples, n, part_min->z, part_max->z, state->z_fineparts,
+        state->z_partitions, &state->nz_parts, z_in, z_start, smallest_spacing);
+
+    free(samples);
+  }
+}
+
+/*************************************************************************
+refine_partitions:
+  In: samples: sorted coordinates of the geometry's vertices along an axis
+      n_samples: number of samples
+      min, max: the world's bounding box along the axis
+      fineparts: fine partitions along the axis
+      partitions: coarse partitions along the axis, as placed by
+                  set_fineparts
+      n_parts: number of coarse partitions
+      in: number of partitions spanning the bounding box
+      start: index of the first of them
+      spacing: smallest distance allowed between partitions
+  Out: The coarse partitions, reallocated if more are needed, with n_parts
+       updated.  The bounding box is cut into in - 1 slabs of equal length;
+       a slab holding more than its share of vertices is given as many
+       slabs as the nearest multiple of that share it holds.  Uniform geometry
+       keeps its partitions, while geometry crowded into a small region
+       gets up to about twice as many.  The partitions are then placed by
+       adapt_partitions.
+*************************************************************************/
+static double *refine_partitions(double const *samples, int n_samples,
+                                 double min, double max, double *fineparts,
+                                 double *partitions, int *n_parts, int in,
+                                 int start, double spacing) {
+  int lo = FINE_PARTITION_OFFSET;
+  int hi = FINE_PARTITION_OFFSET + FINE_PARTITION_SPAN;
+
+  /* adapt_partitions needs "gap" fine partitions between coarse ones */
+  double df = fineparts[lo + 1] - fineparts[lo];
+  double min_gap = ceil(spacing / df);
+  int gap = (min_gap < 1.0) ? 1 : (min_gap > hi - lo) ? hi - lo : (int)min_gap;
+  int max_in = 1 + (hi - lo) / gap;
+
+  int slabs = 0;
+  int below = 0;
+  double share = (double)n_samples / (in - 1);
+  for (int k = 0; k < in - 1; k++) {
+    int next = (k == in - 2) ? n_samples
+                             : count_below(samples, n_samples,
+                                           min + (max - min) * (k + 1) /
+                                                     (in - 1));
+    int want = (int)floor((next - below) / share + 0.5);
+    slabs += (want > 1) ? want : 1;
+    below = next;
+  }
+
+  int new_in = (slabs + 1 < max_in) ? slabs + 1 : max_in;
+  if (new_in > in) {
+    double *grown = CHECKED_MALLOC_ARRAY(double, *n_parts + new_in - in,
+                                         "refined partitions");
+    free(partitions);
+    partitions = grown;
+    *n_parts += new_in - in;
+    in = new_in;
+    set_fineparts(min, max, partitions, fineparts, *n_parts, in, start);
+  }
+
+  adapt_partitions(samples, n_samples, fineparts, partitions, in, start,
+                   spacing);
+  return partitions;
+}
+
+/*************************************************************************
+adapt_partitions:
+  In: samples: sorted coordinates of the geometry's vertices along an axis
+      n_samples: number of samples
+      fineparts: fine partitions along the axis
+      partitions: coarse partitions along the axis, as placed by
+                  set_fineparts
+      in: number of partitions spanning the world's bounding box
+      start: index of the first of them
+      spacing: smallest distance allowed between partitions
+  Out: No return value.  The partitions strictly inside the bounding box
+       are moved onto fine partitions so that they split the box into
+       slabs holding equal shares of a blend of length and vertices.  Dense
+       geometry gets narrow slabs and empty space wide ones.  If the
+       partitions cannot be kept "spacing" apart, they are left uniform.
+*************************************************************************/
+static void adapt_partitions(double const *samples, int n_samples,
+                             double const *fineparts, double *partitions,
+                             int in, int start, double spacing) {
+  /* The fine partitions set_fineparts picks from */
+  int lo = FINE_PARTITION_OFFSET;
+  int hi = FINE_PARTITION_OFFSET + FINE_PARTITION_SPAN;
+
+  if (in < 3)
+    return;
+
+  double df = fineparts[lo + 1] - fineparts[lo];
+  double min_gap = ceil(spacing / df);
+  int gap = (min_gap < 1.0) ? 1 : (min_gap > hi - lo) ? hi - lo : (int)min_gap;
+
+  int *fine_idx = CHECKED_MALLOC_ARRAY(int, in, "adaptive partitions");
+  fine_idx[0] = lo;
+  fine_idx[in - 1] = hi;
+  for (int k = 1; k < in - 1; k++) {
+    /* First fine partition with at least k / (in - 1) of the blend below */
+    double share = (double)k / (in - 1);
+    int a = lo, b = hi;
+    while (a < b) {
+      int m = a + (b - a) / 2;
+      double below =
+          (1.0 - ADAPTIVE_PARTITION_WEIGHT) * (m - lo) / (double)(hi - lo) +
+          ADAPTIVE_PARTITION_WEIGHT *
+              count_below(samples, n_samples, fineparts[m]) / n_samples;
+      if (below >= share)
+        b = m;
+      else
+        a = m + 1;
+    }
+    fine_idx[k] = a;
+  }
+
+  /* Push crowded partitions apart, first upwards and then back down */
+  for (int k = 1; k < in - 1; k++) {
+    if (fine_idx[k] < fine_idx[k - 1] + gap)
+      fine_idx[k] = fine_idx[k - 1] + gap;
+  }
+  for (int k = in - 2; k > 0; k--) {
+    if (fine_idx[k] > fine_idx[k + 1] - gap)
+      fine_idx[k] = fine_idx[k + 1] - gap;
+  }
+
+  int fits = 1;
+  for (int k = 1; k < in; k++) {
+    if (fine_idx[k] - fine_idx[k - 1] < gap)
+      fits = 0;
+  }
+  if (fits) {
+    for (int k = 1; k < in - 1; k++)
+      partitions[start + k] = fineparts[fine_idx[k]];
+  }
+
+  free(fine_idx);
+}
+
+/*************************************************************************
+count_below:
+  In: values: sorted array
+      n: number of values
+      x: a value
+  Out: The number of values less than x.
+*************************************************************************/
+static int count_below(double const *values, int n, double x) {
+  int a = 0, b = n;
+  while (a < b) {
+    int m = a + (b - a) / 2;
+    if (values[m] < x)
+      a = m + 1;
+    else
+      b = m;
+  }
+  return a;
 }
 
 void set_fineparts(double min, double max, double *partitions,
@@ -1875,19 +2319,25 @@ void set_fineparts(double min, double max, double *partitions,
   partitions[0] = fineparts[1];
   /* Dunno how this actually works! */
   for (int i = start; i < start + in; i++) {
-    partitions[i] = fineparts[4096 + (i - start) * 16384 / (in - 1)];
+    partitions[i] = fineparts[FINE_PARTITION_OFFSET +
+                              (i - start) * FINE_PARTITION_SPAN / (in - 1)];
   }
   for (int i = start - 1; i > 0; i--) {
-    for (j = 0; partitions[i + 1] - fineparts[4095 - j] < f; j++) {
+    for (j = 0;
+         partitions[i + 1] - fineparts[FINE_PARTITION_OFFSET - 1 - j] < f;
+         j++) {
     }
-    partitions[i] = fineparts[4095 - j];
+    partitions[i] = fineparts[FINE_PARTITION_OFFSET - 1 - j];
   }
   for (int i = start + in; i < n_parts - 1; i++) {
-    for (j = 0; fineparts[4096 + 16384 + j] - partitions[i - 1] < f; j++) {
+    for (j = 0; fineparts[FINE_PARTITION_OFFSET + FINE_PARTITION_SPAN + j] -
+                        partitions[i - 1] <
+                    f;
+         j++) {
     }
-    partitions[i] = fineparts[4096 + 16384 + j];
+    partitions[i] = fineparts[FINE_PARTITION_OFFSET + FINE_PARTITION_SPAN + j];
   }
-  partitions[n_parts - 1] = fineparts[4096 + 16384 + 4096 - 2];
+  partitions[n_parts - 1] = fineparts[N_FINE_PARTITIONS - 2];
 }
 
 void set_user_partitions(struct volume *state, double dfx, double dfy,
@@ -1928,7 +2378,7 @@ void find_closest_fine_part(double *partitions, double *fineparts,
     partitions[i] =
         fineparts[bisect_near(fineparts, n_fineparts, partitions[i])];
   }
-  partitions[n_parts - 1] = fineparts[4096 + 16384 + 4096 - 2];
+  partitions[n_parts - 1] = fineparts[N_FINE_PARTITIONS - 2];
 }
 
 double *add_extra_outer_partitions(double *partitions, double bb_llf_val,
@@ -2030,6 +2480,8 @@ void path_bounding_box(struct vector3 *loc, struct vector3 *displacement,
       possibly returned to its birthplace.
 ***************************************************************************/
 void collect_molecule(struct volume_molecule *vm) {
+  vm->subvol->mol_epoch++;
+
   /* Unlink from the previous item */
   if (vm->prev_v != NULL) {
 #ifdef DEBUG_LIST_CHECKS
@@ -2053,6 +2505,7 @@ void collect_molecule(struct volume_molecule *vm) {
   /* Clear our next/prev pointers */
   vm->prev_v = NULL;
   vm->next_v = NULL;
+  remove_packed_position(vm);
 
   /* Dispose of the molecule */
   vm->properties = NULL;
@@ -2092,6 +2545,9 @@ void ht_add_molecule_to_list(struct pointer_hash *h,
         vm->subvol->local_storage->pslv, "per-species molecule list");
     list->properties = vm->properties;
     list->head = NULL;
+    list->n_mols = list->max_mols = 0;
+    list->x = list->y = list->z = NULL;
+    list->mols = NULL;
     if (pointer_hash_add(h, vm->properties, vm->properties->hashval, list))
       mcell_allocfailed("Failed to add species to subvolume species table.");
 
@@ -2100,11 +2556,13 @@ void ht_add_molecule_to_list(struct pointer_hash *h,
   }
 
   /* Link the molecule into the list */
+  vm->subvol->mol_epoch++;
   vm->next_v = list->head;
   if (list->head)
     list->head->prev_v = &vm->next_v;
   vm->prev_v = &list->head;
   list->head = vm;
+  add_packed_position(list, vm);
 }
 
 /***************************************************************************
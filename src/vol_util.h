@@ -48,6 +48,7 @@ double collide_sv_time(struct vector3 *point, struct vector3 *move,
                        double *y_fineparts, double *z_fineparts);
 
 int is_defunct_molecule(struct abstract_element *e);
+void remove_defunct_molecules(struct schedule_helper *timer);
 
 struct surface_molecule *
 place_surface_molecule(struct volume *world, struct species *s,
@@ -64,6 +65,8 @@ struct volume_molecule *insert_volume_molecule(struct volume *world,
                                                struct volume_molecule *vm,
                                                struct volume_molecule *guess);
 
+void compact_volume_molecules(struct volume *world);
+
 struct volume_molecule *migrate_volume_molecule(struct volume_molecule *vm,
                                                 struct subvolume *new_sv);
 
@@ -113,4 +116,23 @@ void ht_remove(struct pointer_hash *h, struct per_species_list *psl);
 
 void collect_molecule(struct volume_molecule *vm);
 
+void collect_species_list(struct storage *local, struct per_species_list *psl);
+
+/* Number of packed entries molecules_in_box looks at per call */
+#define MOLECULE_SCAN_CHUNK 64
+
+int molecules_in_box(struct per_species_list const *psl, int first,
+                     struct vector3 const *llf, struct vector3 const *urb,
+                     int *hits);
+
+/* Copy a molecule's position into its list's packed arrays after a move */
+static inline void update_packed_position(struct volume_molecule *vm) {
+  struct per_species_list *psl = vm->psl;
+  if (psl != NULL) {
+    psl->x[vm->psl_slot] = vm->pos.x;
+    psl->y[vm->psl_slot] = vm->pos.y;
+    psl->z[vm->psl_slot] = vm->pos.z;
+  }
+}
+
 #endif
@@ -69,6 +69,10 @@ static struct poly_edge* create_new_poly_edge(struct poly_edge* list);
 // are part of a common region or not
 static bool have_common_region(struct object *obj, int wall1, int wall2);
 
+// wall_bounding_box finds the smallest box containing a wall
+static void wall_bounding_box(struct wall *w, struct vector3 *llf,
+                              struct vector3 *urb);
+
 
 /**************************************************************************\
  ** Edge hash table section--finds common edges in polygons              **
@@ -960,6 +964,124 @@ void jump_away_line(struct vector3 *p, struct vector3 *v, double k,
   v->z -= tiny * f.z;
 }
 
+/* Relative tolerance by which a wall's bounds are grown, well above the
+ * rounding error of collide_wall's edge tests */
+#define WALL_EDGE_BAND (1000.0 * EPS_C)
+
+/***************************************************************************
+padded_wall_bounds:
+  In: w: a wall
+      llf: vector to hold the lower left front corner of the bounds
+      urb: vector to hold the upper right back corner
+  Out: No return value.  The bounding box of the wall is computed and grown
+       by WALL_EDGE_BAND relative to the wall's size and position, so that
+       any point collide_wall finds on the wall or on one of its edges lies
+       inside it.
+***************************************************************************/
+static void padded_wall_bounds(struct wall *w, struct vector3 *llf,
+                               struct vector3 *urb) {
+  double max_abs = 0.0, min_edge = GIGANTIC, max_edge = 0.0;
+
+  wall_bounding_box(w, llf, urb);
+  for (int i = 0; i < 3; i++) {
+    struct vector3 *a = w->vert[i];
+    struct vector3 *b = w->vert[(i + 1) % 3];
+    double edge = distance_vec3(a, b);
+    min_edge = min2d(min_edge, edge);
+    max_edge = max2d(max_edge, edge);
+    max_abs = max2d(max_abs, max3d(fabs(a->x), fabs(a->y), fabs(a->z)));
+  }
+
+  /* The edge tests in collide_wall are relative to products of lengths
+   * within the wall, and the hit point carries the rounding error of the
+   * absolute coordinates */
+  double inv_edge = (min_edge > 0.0) ? 1.0 / min_edge : GIGANTIC;
+  double pad = WALL_EDGE_BAND * (1.0 + max_abs + max_edge + inv_edge);
+  llf->x -= pad;
+  llf->y -= pad;
+  llf->z -= pad;
+  urb->x += pad;
+  urb->y += pad;
+  urb->z += pad;
+}
+
+/***************************************************************************
+line_hits_box:
+  In: pos: a point on the line
+      move: direction of the line
+      inv_move: reciprocals of the nonzero components of move
+      llf, urb: corners of a box
+  Out: 1 if the line through pos along move meets the box, 0 if not.
+***************************************************************************/
+static int line_hits_box(struct vector3 const *pos, struct vector3 const *move,
+                         struct vector3 const *inv_move,
+                         struct vector3 const *llf, struct vector3 const *urb) {
+  double t_min = -HUGE_VAL, t_max = HUGE_VAL, t1, t2;
+
+  if (move->x == 0.0) {
+    if (pos->x < llf->x || pos->x > urb->x)
+      return 0;
+  } else {
+    t1 = (llf->x - pos->x) * inv_move->x;
+    t2 = (urb->x - pos->x) * inv_move->x;
+    t_min = max2d(t_min, min2d(t1, t2));
+    t_max = min2d(t_max, max2d(t1, t2));
+  }
+
+  if (move->y == 0.0) {
+    if (pos->y < llf->y || pos->y > urb->y)
+      return 0;
+  } else {
+    t1 = (llf->y - pos->y) * inv_move->y;
+    t2 = (urb->y - pos->y) * inv_move->y;
+    t_min = max2d(t_min, min2d(t1, t2));
+    t_max = min2d(t_max, max2d(t1, t2));
+  }
+
+  if (move->z == 0.0) {
+    if (pos->z < llf->z || pos->z > urb->z)
+      return 0;
+  } else {
+    t1 = (llf->z - pos->z) * inv_move->z;
+    t2 = (urb->z - pos->z) * inv_move->z;
+    t_min = max2d(t_min, min2d(t1, t2));
+    t_max = min2d(t_max, max2d(t1, t2));
+  }
+
+  return t_min <= t_max;
+}
+
+/***************************************************************************
+inverse_move:
+  In: move: direction of a line
+      inv_move: vector to hold the reciprocals of move's components
+  Out: No return value.  Zero components are left zero.
+***************************************************************************/
+static void inverse_move(struct vector3 const *move,
+                         struct vector3 *inv_move) {
+  inv_move->x = (move->x != 0.0) ? 1.0 / move->x : 0.0;
+  inv_move->y = (move->y != 0.0) ? 1.0 / move->y : 0.0;
+  inv_move->z = (move->z != 0.0) ? 1.0 / move->z : 0.0;
+}
+
+/***************************************************************************
+line_near_wall:
+  In: w: a wall
+      pos: a point on the line
+      move: direction of the line
+  Out: 1 if the line meets the wall's padded bounds, 0 if not.
+  Note: collide_wall only redoes a move for a wall the line passes near, so
+        that the walls a wall_tree rules out are exactly the ones it would
+        miss.
+***************************************************************************/
+static int line_near_wall(struct wall *w, struct vector3 const *pos,
+                          struct vector3 const *move) {
+  struct vector3 llf, urb, inv_move;
+  padded_wall_bounds(w, &llf, &urb);
+  inverse_move(move, &inv_move);
+  return line_hits_box(pos, move, &inv_move, &llf, &urb);
+}
+
 /***************************************************************************
 collide_wall:
   In: starting coordinate
@@ -969,7 +1091,9 @@ collide_wall:
       vector to store the location of the collision
       flag to signal whether we should modify the movement vector in an
         ambiguous case (i.e. if we hit an edge or corner); if not, any
-        ambiguous cases are treated as a miss.
+        ambiguous cases are treated as a miss.  So are ambiguous cases
+        where the line of the move passes clear of the wall itself, near
+        the far extension of an edge (see line_near_wall).
   Out: Integer value indicating what happened
          COLLIDE_MISS  missed
          COLLIDE_FRONT hit the front face (face normal points out of)
@@ -1028,7 +1152,7 @@ int collide_wall(struct vector3 *point, struct vector3 *move, struct wall *face,
     if (dv != 0.0)
       return COLLIDE_MISS;
 
-    if (update_move) {
+    if (update_move && line_near_wall(face, point, move)) {
       a = (abs_max_2vec(point, move) + 1.0) * EPS_C;
       if ((rng_uint(rng) & 1) == 0)
         a = -a;
@@ -1082,7 +1206,7 @@ int collide_wall(struct vector3 *point, struct vector3 *move, struct wall *face,
           c * face->uv_vert1_u + g,
           h + face->uv_vert1_u * face->uv_vert2.v,
           EPS_C))) {
-        if (update_move) {
+        if (update_move && line_near_wall(face, point, move)) {
           jump_away_line(point, move, a, face->vert[1], face->vert[2],
                          &(face->normal), rng);
           return COLLIDE_REDO;
@@ -1091,7 +1215,7 @@ int collide_wall(struct vector3 *point, struct vector3 *move, struct wall *face,
       } else
         return COLLIDE_MISS;
     } else if (!distinguishable(g, h, EPS_C)) {
-      if (update_move) {
+      if (update_move && line_near_wall(face, point, move)) {
         jump_away_line(point, move, a, face->vert[2], face->vert[0],
                        &(face->normal), rng);
         return COLLIDE_REDO;
@@ -1101,7 +1225,7 @@ int collide_wall(struct vector3 *point, struct vector3 *move, struct wall *face,
       return COLLIDE_MISS;
   } else if (!distinguishable(c, 0, EPS_C)) /* Hit first edge! */
   {
-    if (update_move) {
+    if (update_move && line_near_wall(face, point, move)) {
       jump_away_line(point, move, a, face->vert[0], face->vert[1],
                      &(face->normal), rng);
       return COLLIDE_REDO;
@@ -1381,6 +1505,7 @@ void init_tri_wall(struct object *objp, int side, struct vector3 *v0,
   w->next = NULL;
   w->surf_class_head = NULL;
   w->num_surf_classes = 0;
+  w->surf_class_set = 0;
 
   w->side = side;
 
@@ -1743,6 +1868,498 @@ int distribute_world(struct volume *world) {
   return 0;
 }
 
+/* Subvolumes with fewer walls than this just use their wall list */
+#define WALL_PACK_MIN_WALLS 4
+
+/* Subvolumes with fewer walls than this test all their packed walls */
+#define WALL_TREE_MIN_WALLS 16
+
+/* Relative slack of walls_off_plane's test, well above rounding error */
+#define WALL_PLANE_ROUNDING 1e-13
+
+/* Most walls in a leaf of a wall_tree */
+#define WALL_TREE_LEAF_WALLS 4
+
+/* Deepest possible wall_tree; the median splits halve each level */
+#define WALL_TREE_MAX_DEPTH 64
+
+/***************************************************************************
+split_walls_at_median:
+  In: key: position of each wall along the splitting axis
+      idx: indices of the walls to split
+      n: number of indices
+  Out: No return value.  idx is reordered so that the first n / 2 walls
+       have no larger keys than the rest.
+***************************************************************************/
+static void split_walls_at_median(double const *key, int *idx, int n) {
+  int lo = 0, hi = n - 1, mid = n / 2;
+  while (lo < hi) {
+    double pivot = key[idx[(lo + hi) / 2]];
+    int i = lo, j = hi;
+    while (i <= j) {
+      while (key[idx[i]] < pivot)
+        i++;
+      while (key[idx[j]] > pivot)
+        j--;
+      if (i <= j) {
+        int tmp = idx[i];
+        idx[i++] = idx[j];
+        idx[j--] = tmp;
+      }
+    }
+    if (mid <= j)
+      hi = j;
+    else if (mid >= i)
+      lo = i;
+    else
+      break;
+  }
+}
+
+/***************************************************************************
+build_wall_node:
+  In: tree: the tree being built, with room for its nodes
+      n_nodes: number of nodes created so far
+      llf, urb: padded bounds of each wall
+      key: scratch array with one entry per wall
+      first: first entry of tree->leaf_walls to put below the node
+      count: number of walls to put below the node
+  Out: Index of the new node.  The node and the nodes below it are filled
+       in, and n_nodes is advanced past them.
+***************************************************************************/
+static int build_wall_node(struct wall_tree *tree, int *n_nodes,
+                           struct vector3 const *llf, struct vector3 const *urb,
+                           double *key, int first, int count) {
+  int *idx = tree->leaf_walls + first;
+  int node_idx = (*n_nodes)++;
+  struct wall_tree_node *node = &tree->nodes[node_idx];
+
+  node->llf = llf[idx[0]];
+  node->urb = urb[idx[0]];
+  for (int i = 1; i < count; i++) {
+    node->llf.x = min2d(node->llf.x, llf[idx[i]].x);
+    node->llf.y = min2d(node->llf.y, llf[idx[i]].y);
+    node->llf.z = min2d(node->llf.z, llf[idx[i]].z);
+    node->urb.x = max2d(node->urb.x, urb[idx[i]].x);
+    node->urb.y = max2d(node->urb.y, urb[idx[i]].y);
+    node->urb.z = max2d(node->urb.z, urb[idx[i]].z);
+  }
+
+  if (count <= WALL_TREE_LEAF_WALLS) {
+    node->first = first;
+    node->count = count;
+    return node_idx;
+  }
+
+  /* Split at the median wall along the longest side */
+  double dx = node->urb.x - node->llf.x;
+  double dy = node->urb.y - node->llf.y;
+  double dz = node->urb.z - node->llf.z;
+  for (int i = 0; i < count; i++) {
+    int w = idx[i];
+    if (dx >= dy && dx >= dz)
+      key[w] = llf[w].x + urb[w].x;
+    else if (dy >= dz)
+      key[w] = llf[w].y + urb[w].y;
+    else
+      key[w] = llf[w].z + urb[w].z;
+  }
+  split_walls_at_median(key, idx, count);
+
+  node->count = 0;
+  build_wall_node(tree, n_nodes, llf, urb, key, first, count / 2);
+  int right = build_wall_node(tree, n_nodes, llf, urb, key, first + count / 2,
+                              count - count / 2);
+  tree->nodes[node_idx].first = right;
+  return node_idx;
+}
+
+/***************************************************************************
+create_wall_pack:
+  In: sv: a subvolume
+      n_walls: number of walls in its wall list
+  Out: The subvolume's packed walls, or NULL on memory allocation failure.
+***************************************************************************/
+static struct wall_pack *create_wall_pack(struct subvolume *sv, int n_walls) {
+  struct wall_pack *pack = CHECKED_MALLOC_STRUCT_NODIE(struct wall_pack,
+                                                       "packed walls");
+  if (pack == NULL)
+    return NULL;
+
+  pack->n_walls = n_walls;
+  pack->walls = CHECKED_MALLOC_ARRAY_NODIE(struct wall *, n_walls,
+                                           "packed walls");
+  pack->nx = CHECKED_MALLOC_ARRAY_NODIE(double, n_walls, "packed walls");
+  pack->ny = CHECKED_MALLOC_ARRAY_NODIE(double, n_walls, "packed walls");
+  pack->nz = CHECKED_MALLOC_ARRAY_NODIE(double, n_walls, "packed walls");
+  pack->d = CHECKED_MALLOC_ARRAY_NODIE(double, n_walls, "packed walls");
+  if (pack->walls == NULL || pack->nx == NULL || pack->ny == NULL ||
+      pack->nz == NULL || pack->d == NULL)
+    return NULL;
+
+  int i = 0;
+  for (struct wall_list *wl = sv->wall_head; wl != NULL; wl = wl->next, i++) {
+    struct wall *w = wl->this_wall;
+    pack->walls[i] = w;
+    pack->nx[i] = w->normal.x;
+    pack->ny[i] = w->normal.y;
+    pack->nz[i] = w->normal.z;
+    pack->d[i] = w->d;
+  }
+
+  return pack;
+}
+
+/***************************************************************************
+create_wall_tree:
+  In: pack: the packed walls of a subvolume
+  Out: A tree over the walls, or NULL on memory allocation failure.
+***************************************************************************/
+static struct wall_tree *create_wall_tree(struct wall_pack *pack) {
+  int n_walls = pack->n_walls;
+  struct wall_tree *tree = CHECKED_MALLOC_STRUCT_NODIE(struct wall_tree,
+                                                       "wall tree");
+  struct vector3 *llf = CHECKED_MALLOC_ARRAY_NODIE(struct vector3, n_walls,
+                                                   "wall tree bounds");
+  struct vector3 *urb = CHECKED_MALLOC_ARRAY_NODIE(struct vector3, n_walls,
+                                                   "wall tree bounds");
+  double *key = CHECKED_MALLOC_ARRAY_NODIE(double, n_walls, "wall tree keys");
+  if (tree == NULL || llf == NULL || urb == NULL || key == NULL)
+    return NULL;
+
+  tree->leaf_walls = CHECKED_MALLOC_ARRAY_NODIE(int, n_walls,
+                                                "wall tree leaves");
+  tree->nodes = CHECKED_MALLOC_ARRAY_NODIE(struct wall_tree_node, 2 * n_walls,
+                                           "wall tree nodes");
+  if (tree->leaf_walls == NULL || tree->nodes == NULL)
+    return NULL;
+
+  for (int i = 0; i < n_walls; i++) {
+    tree->leaf_walls[i] = i;
+    padded_wall_bounds(pack->walls[i], &llf[i], &urb[i]);
+  }
+
+  int n_nodes = 0;
+  build_wall_node(tree, &n_nodes, llf, urb, key, 0, n_walls);
+
+  free(llf);
+  free(urb);
+  free(key);
+  return tree;
+}
+
+/***************************************************************************
+create_wall_field:
+  In: world: simulation state
+      sv: subvolume with at least one wall
+  Out: The new wall_field, or NULL on memory allocation failure.
+  Note: The bound on the distance from a cell to a wall is the larger of
+        the gap between the cell and the wall's bounding box and the gap
+        between the cell and the wall's plane.
+***************************************************************************/
+static struct wall_field *create_wall_field(struct volume *world,
+                                            struct subvolume *sv) {
+  struct wall_field *field =
+      CHECKED_MALLOC_STRUCT_NODIE(struct wall_field, "wall distance field");
+  if (field == NULL)
+    return NULL;
+
+  struct vector3 urb;
+  field->llf.x = world->x_fineparts[sv->llf.x];
+  field->llf.y = world->y_fineparts[sv->llf.y];
+  field->llf.z = world->z_fineparts[sv->llf.z];
+  urb.x = world->x_fineparts[sv->urb.x];
+  urb.y = world->y_fineparts[sv->urb.y];
+  urb.z = world->z_fineparts[sv->urb.z];
+
+  /* Cell size and half size along each axis */
+  struct vector3 size, half;
+  size.x = (urb.x - field->llf.x) / WALL_FIELD_CELLS;
+  size.y = (urb.y - field->llf.y) / WALL_FIELD_CELLS;
+  size.z = (urb.z - field->llf.z) / WALL_FIELD_CELLS;
+  field->scale.x = 1.0 / size.x;
+  field->scale.y = 1.0 / size.y;
+  field->scale.z = 1.0 / size.z;
+  half.x = 0.5 * size.x;
+  half.y = 0.5 * size.y;
+  half.z = 0.5 * size.z;
+
+  int cell = 0;
+  for (int i = 0; i < WALL_FIELD_CELLS; i++) {
+    for (int j = 0; j < WALL_FIELD_CELLS; j++) {
+      for (int k = 0; k < WALL_FIELD_CELLS; k++, cell++) {
+        struct vector3 lo, hi, center;
+        lo.x = field->llf.x + i * size.x;
+        lo.y = field->llf.y + j * size.y;
+        lo.z = field->llf.z + k * size.z;
+        hi.x = lo.x + size.x;
+        hi.y = lo.y + size.y;
+        hi.z = lo.z + size.z;
+        center.x = lo.x + half.x;
+        center.y = lo.y + half.y;
+        center.z = lo.z + half.z;
+
+        struct wall_field_cell *fc = &field->cells[cell];
+        fc->nearest = NULL;
+        fc->nearest_d2 = GIGANTIC;
+        fc->others_d2 = GIGANTIC;
+        for (struct wall_list *wl = sv->wall_head; wl != NULL; wl = wl->next) {
+          struct wall *w = wl->this_wall;
+          struct vector3 w_llf, w_urb;
+          wall_bounding_box(w, &w_llf, &w_urb);
+
+          double gx = max3d(0.0, w_llf.x - hi.x, lo.x - w_urb.x);
+          double gy = max3d(0.0, w_llf.y - hi.y, lo.y - w_urb.y);
+          double gz = max3d(0.0, w_llf.z - hi.z, lo.z - w_urb.z);
+          double box_d2 = gx * gx + gy * gy + gz * gz;
+
+          double plane_d = fabs(dot_prod(&w->normal, &center) - w->d) -
+                           (fabs(w->normal.x) * half.x +
+                            fabs(w->normal.y) * half.y +
+                            fabs(w->normal.z) * half.z);
+          double plane_d2 = (plane_d > 0.0) ? plane_d * plane_d : 0.0;
+
+          /* Leave room for rounding in the bounds above */
+          double d2 = max2d(box_d2, plane_d2) * (1.0 - WALL_PLANE_ROUNDING);
+          if (d2 < fc->nearest_d2) {
+            fc->others_d2 = fc->nearest_d2;
+            fc->nearest_d2 = d2;
+            fc->nearest = w;
+          } else if (d2 < fc->others_d2)
+            fc->others_d2 = d2;
+        }
+      }
+    }
+  }
+
+  return field;
+}
+
+/***************************************************************************
+wall_field_distance2:
+  In: field: wall_field of a subvolume
+      pos: a point in that subvolume
+  Out: A lower bound on the squared distance from the point to the nearest
+       wall of the subvolume.
+***************************************************************************/
+double wall_field_distance2(struct wall_field const *field,
+                            struct vector3 const *pos) {
+  int i = (int)((pos->x - field->llf.x) * field->scale.x);
+  int j = (int)((pos->y - field->llf.y) * field->scale.y);
+  int k = (int)((pos->z - field->llf.z) * field->scale.z);
+
+  /* Points on the faces of the subvolume may round just outside it */
+  i = (i < 0) ? 0 : (i >= WALL_FIELD_CELLS) ? WALL_FIELD_CELLS - 1 : i;
+  j = (j < 0) ? 0 : (j >= WALL_FIELD_CELLS) ? WALL_FIELD_CELLS - 1 : j;
+  k = (k < 0) ? 0 : (k >= WALL_FIELD_CELLS) ? WALL_FIELD_CELLS - 1 : k;
+
+  struct wall_field_cell const *fc =
+      &field->cells[k + WALL_FIELD_CELLS * (j + WALL_FIELD_CELLS * i)];
+  if (fc->nearest == NULL)
+    return fc->others_d2;
+
+  struct wall const *w = fc->nearest;
+  double d = w->normal.x * pos->x + w->normal.y * pos->y +
+             w->normal.z * pos->z - w->d;
+  double d2 = max2d(fc->nearest_d2, d * d * (1.0 - WALL_PLANE_ROUNDING));
+  return min2d(d2, fc->others_d2);
+}
+
+/***************************************************************************
+build_wall_trees:
+  In: world: simulation state, with the walls distributed to subvolumes
+  Out: 0 on success, 1 on memory allocation failure.  The walls of every
+       subvolume with more than a few are packed, those with many also get
+       a wall tree, every subvolume with walls gets a wall_field, and the
+       world gets the scratch space walls_along_ray needs.
+***************************************************************************/
+int build_wall_trees(struct volume *world) {
+  world->max_packed_walls = 0;
+  for (int i = 0; i < world->n_subvols; i++) {
+    struct subvolume *sv = &world->subvol[i];
+    int n_walls = 0;
+    for (struct wall_list *wl = sv->wall_head; wl != NULL; wl = wl->next)
+      n_walls++;
+    if (n_walls > 0 && (sv->wall_field = create_wall_field(world, sv)) == NULL)
+      return 1;
+    if (n_walls < WALL_PACK_MIN_WALLS)
+      continue;
+
+    if ((sv->wall_pack = create_wall_pack(sv, n_walls)) == NULL)
+      return 1;
+    if (n_walls >= WALL_TREE_MIN_WALLS &&
+        (sv->wall_tree = create_wall_tree(sv->wall_pack)) == NULL)
+      return 1;
+    world->max_packed_walls = max2i(world->max_packed_walls, n_walls);
+  }
+
+  return create_wall_ray_scratch(world, &world->ray_scratch);
+}
+
+/***************************************************************************
+create_wall_ray_scratch:
+  In: world: simulation state, after build_wall_trees
+      scratch: scratch space to fill in
+  Out: 0 on success, 1 on memory allocation failure.  Each thread calling
+       walls_along_ray needs its own.
+***************************************************************************/
+int create_wall_ray_scratch(struct volume *world,
+                            struct wall_ray_scratch *scratch) {
+  int n = world->max_packed_walls;
+  memset(scratch, 0, sizeof(struct wall_ray_scratch));
+  if (n == 0)
+    return 0;
+
+  scratch->idx = CHECKED_MALLOC_ARRAY_NODIE(int, n, "candidate walls");
+  scratch->marks = (unsigned long long *)calloc((n + 63) / 64,
+                                                sizeof(unsigned long long));
+  scratch->walls = CHECKED_MALLOC_ARRAY_NODIE(struct wall_list, n,
+                                              "candidate walls");
+  if (scratch->idx == NULL || scratch->marks == NULL || scratch->walls == NULL)
+    return 1;
+  return 0;
+}
+
+/***************************************************************************
+mark_walls_in_tree_along_line:
+  In: tree: a subvolume's wall tree
+      pos: a point on a line
+      move: direction of the line
+      marks: bit set with one bit per wall of the subvolume
+  Out: No return value.  The bits of the walls in every leaf whose bounds
+       the line passes through are set.
+***************************************************************************/
+static void mark_walls_in_tree_along_line(struct wall_tree const *tree,
+                                          struct vector3 const *pos,
+                                          struct vector3 const *move,
+                                          unsigned long long *marks) {
+  struct vector3 inv_move;
+  inverse_move(move, &inv_move);
+
+  int stack[WALL_TREE_MAX_DEPTH];
+  int depth = 0;
+  stack[depth++] = 0;
+  while (depth > 0) {
+    int node_idx = stack[--depth];
+    struct wall_tree_node const *node = &tree->nodes[node_idx];
+    if (!line_hits_box(pos, move, &inv_move, &node->llf, &node->urb))
+      continue;
+
+    if (node->count == 0) {
+      stack[depth++] = node->first;
+      stack[depth++] = node_idx + 1;
+    } else {
+      for (int i = node->first; i < node->first + node->count; i++) {
+        int w = tree->leaf_walls[i];
+        marks[w / 64] |= 1ULL << (w % 64);
+      }
+    }
+  }
+}
+
+/***************************************************************************
+walls_off_plane:
+  In: pack: a subvolume's packed walls
+      idx: indices of the walls to test; the survivors are written back
+      n: number of walls to test
+      pos: start of a ray
+      move: displacement along the ray
+      reflectee: wall to keep regardless, for the caller to skip
+  Out: The number of walls left.  Walls whose planes the move starts and
+       ends clearly on the same side of are dropped: collide_wall would
+       report a miss for them.
+  Note: The walls are tested without branches, straight from the packed
+        normals, so the compiler is free to vectorize the loop.  The test
+        is looser than collide_wall's by more than the rounding error of
+        either, so that it never drops a wall collide_wall would not miss,
+        however the compiler arranges the arithmetic.
+***************************************************************************/
+static int walls_off_plane(struct wall_pack const *pack, int *idx, int n,
+                           struct vector3 const *pos,
+                           struct vector3 const *move,
+                           struct wall const *reflectee) {
+  double const *nx = pack->nx, *ny = pack->ny, *nz = pack->nz, *d = pack->d;
+  double px = pos->x, py = pos->y, pz = pos->z;
+  double mx = move->x, my = move->y, mz = move->z;
+  double mag = fabs(px) + fabs(py) + fabs(pz) + fabs(mx) + fabs(my) + fabs(mz);
+
+  int n_left = 0;
+  for (int i = 0; i < n; i++) {
+    int w = idx[i];
+    double dd = nx[w] * px + ny[w] * py + nz[w] * pz - d[w];
+    double dv = nx[w] * mx + ny[w] * my + nz[w] * mz;
+    double tol = WALL_PLANE_ROUNDING * (mag + fabs(d[w]));
+    int above = (dd > tol) & (dd + dv > EPS_C + tol);
+    int below = (dd < -tol) & (dd + dv < -EPS_C - tol);
+    idx[n_left] = w;
+    n_left += !(above | below) | (pack->walls[w] == reflectee);
+  }
+  return n_left;
+}
+
+/***************************************************************************
+walls_along_ray:
+  In: world: simulation state (or a worker's copy)
+      sv: a subvolume
+      pos: start of a ray
+      move: displacement along the ray
+      reflectee: wall the caller will skip, or NULL
+  Out: The walls of the subvolume that collide_wall might report the ray
+       hitting or redo the move for, in the order of the subvolume's wall
+       list.  Without packed walls this is the wall list itself; otherwise
+       it is built in the world's scratch space, and is only good until the
+       next call.  Walls ruled out here are counted as ray-polygon tests, as
+       if collide_wall had tested them.
+  Note: collide_wall reports hits at any point of the line through the
+        move whose plane crossing lies on the wall, and only redoes moves
+        whose line meets the wall's padded bounds, so the tree is searched
+        along the whole line.  Only the walls it leaves go through the
+        packed plane test.
+***************************************************************************/
+struct wall_list *walls_along_ray(struct volume *world, struct subvolume *sv,
+                                  struct vector3 const *pos,
+                                  struct vector3 const *move,
+                                  struct wall const *reflectee) {
+  struct wall_pack const *pack = sv->wall_pack;
+  if (pack == NULL)
+    return sv->wall_head;
+
+  struct wall_ray_scratch *scratch = &world->ray_scratch;
+  int n_walls = pack->n_walls;
+  int n_left = 0;
+  if (sv->wall_tree != NULL) {
+    unsigned long long *marks = scratch->marks;
+    mark_walls_in_tree_along_line(sv->wall_tree, pos, move, marks);
+
+    /* Gather the marked walls in wall list order, clearing the marks */
+    for (int i = 0; i < (n_walls + 63) / 64; i++) {
+      while (marks[i] != 0) {
+        int w = 64 * i + __builtin_ctzll(marks[i]);
+        marks[i] &= marks[i] - 1;
+        scratch->idx[n_left++] = w;
+      }
+    }
+  } else {
+    for (int i = 0; i < n_walls; i++)
+      scratch->idx[i] = i;
+    n_left = n_walls;
+  }
+  n_left = walls_off_plane(pack, scratch->idx, n_left, pos, move, reflectee);
+
+  if (world->notify->final_summary == NOTIFY_FULL)
+    world->ray_polygon_tests += n_walls - n_left;
+
+  struct wall_list *head = NULL, **tail = &head;
+  for (int i = 0; i < n_left; i++) {
+    struct wall_list *wl = &scratch->walls[i];
+    wl->this_wall = pack->walls[scratch->idx[i]];
+    *tail = wl;
+    tail = &wl->next;
+  }
+  *tail = NULL;
+  return head;
+}
+
 /***************************************************************************
 closest_pt_point_triangle:
   In:  p - point
@@ -1938,12 +2555,11 @@ static int vacuum_from_regions(struct volume *world,
                                   -1, NULL, smp->grid->surface, smp->t);
       smp->properties = NULL;
       p->grid->mol[p->index] = NULL;
+      mark_free_tile(p->grid, p->index);
       p->grid->n_occupied--;
       if (smp->flags & IN_SCHEDULE) {
-        smp->grid->subvol->local_storage->timer->defunct_count++; /* Tally for
-                                                                    garbage
-                                                                    collection
-                                                                    */
+        /* Tally for garbage collection */
+        schedule_add_defunct(smp->grid->subvol->local_storage->timer);
       }
 
       n++;
@@ -2205,7 +2821,7 @@ struct surface_molecule *place_single_molecule(struct volume *state,
   new_sm->t = t;
   new_sm->t2 = t2;
   new_sm->birthday = birthday;
-  new_sm->birthplace = w->birthplace->smol;
+  new_sm->birthplace = gsv->local_storage->smol;
   new_sm->id = state->current_mol_id++;
   new_sm->grid_index = grid_index;
   new_sm->s_pos.u = s_pos.u;
@@ -2413,10 +3029,9 @@ find_restricted_regions_by_wall(struct volume *world, struct wall *this_wall,
   }
 
   int num_matching_rxns = trigger_intersect(
-      world->reaction_hash, world->rx_hashsize, world->all_mols,
-      world->all_volume_mols, world->all_surface_mols, sm->properties->hashval,
-      (struct abstract_molecule *)sm, sm->orient, this_wall, matching_rxns, 1,
-      1, 1);
+      &world->rxn_pairs, world->all_mols, world->all_volume_mols,
+      world->all_surface_mols, (struct abstract_molecule *)sm, sm->orient,
+      this_wall, matching_rxns, 1, 1, 1);
 
   struct species *restricted_surf_class[MAX_MATCHING_RXNS];
   int num_res = 0;
@@ -2514,14 +3129,13 @@ find_restricted_regions_by_object(struct volume *world, struct object *obj,
     int num_matching_rxns = 0;
     if (rp->surf_class) {
       num_matching_rxns = find_unimol_reactions_with_surf_classes(
-          world->reaction_hash, world->rx_hashsize,
-          (struct abstract_molecule *)sm, obj->wall_p[wall_idx],
-          sm->properties->hashval, sm->orient, num_matching_rxns, 1, 1, 1,
+          &world->rxn_pairs, (struct abstract_molecule *)sm,
+          obj->wall_p[wall_idx], sm->orient, num_matching_rxns, 1, 1, 1,
           matching_rxns);
       num_matching_rxns = find_surface_mol_reactions_with_surf_classes(
-          world->reaction_hash, world->rx_hashsize, world->all_mols,
-          world->all_surface_mols, sm->orient, rp->surf_class,
-          num_matching_rxns, 1, 1, 1, matching_rxns);
+          &world->rxn_pairs, world->all_mols, world->all_surface_mols,
+          sm->orient, rp->surf_class, num_matching_rxns, 1, 1, 1,
+          matching_rxns);
     }
 
     for (kk = 0; kk < num_matching_rxns; kk++) {
@@ -2588,9 +3202,8 @@ int are_restricted_regions_for_species_on_object(struct volume *world,
     }
 
     num_matching_rxns = trigger_intersect(
-        world->reaction_hash, world->rx_hashsize, world->all_mols,
-        world->all_volume_mols, world->all_surface_mols,
-        sm->properties->hashval, (struct abstract_molecule *)sm, sm->orient,
+        &world->rxn_pairs, world->all_mols, world->all_volume_mols,
+        world->all_surface_mols, (struct abstract_molecule *)sm, sm->orient,
         obj->wall_p[wall_idx], matching_rxns, 1, 1, 1);
 
     if (num_matching_rxns > 0) {
@@ -113,6 +113,19 @@ int distribute_object(struct volume *world, struct object *parent);
 
 int distribute_world(struct volume *world);
 
+int build_wall_trees(struct volume *world);
+
+double wall_field_distance2(struct wall_field const *field,
+                            struct vector3 const *pos);
+
+int create_wall_ray_scratch(struct volume *world,
+                            struct wall_ray_scratch *scratch);
+
+struct wall_list *walls_along_ray(struct volume *world, struct subvolume *sv,
+                                  struct vector3 const *pos,
+                                  struct vector3 const *move,
+                                  struct wall const *reflectee);
+
 void closest_pt_point_triangle(struct vector3 *p, struct vector3 *a,
                                struct vector3 *b, struct vector3 *c,
                                struct vector3 *final_result);
@@ -83,6 +83,10 @@ CMD_MCELL_VERSION     = 5
 CMD_SPECIES_TABLE     = 6
 CMD_SCHEDULER_STATE   = 7
 CMD_BYTE_ORDER        = 8
+CMD_CHECKPOINT_API    = 10
+
+# Newest checkpoint API version this reader understands
+CHECKPOINT_API        = 2
 
 def read_current_time(ub):
     time, = ub.next_struct('d')
@@ -96,16 +100,14 @@ def read_chkpt_sequence(ub):
     seq, = ub.next_struct('I')
     return {'chkpt_seq': seq}
 
-def read_rng_state(ub):
-    seed = ub.next_vint()
+def read_an_rng_state(ub):
     rngtype, = ub.next_struct('c')
     if rngtype == 'I':
         randcnt = ub.next_vint()
         aa, bb, cc = ub.next_struct('QQQ')
         randrsl = ub.next_struct('256Q')
         mm      = ub.next_struct('256Q')
-        return {'rng_seed': seed,
-                'rng_type': 'ISAAC64',
+        return {'rng_type': 'ISAAC64',
                 'rng_aa':   aa,
                 'rng_bb':   bb,
                 'rng_cc':   cc,
@@ -113,8 +115,7 @@ def read_rng_state(ub):
                 'rng_mm':   mm}
     elif rngtype == 'M':
         a, b, c, d = ub.next_struct('IIII')
-        return {'rng_seed': seed,
-                'rng_type': 'SimpleRNG',
+        return {'rng_type': 'SimpleRNG',
                 'rng_a':  a,
                 'rng_b':  b,
                 'rng_c':  c,
@@ -122,6 +123,25 @@ def read_rng_state(ub):
     else:
         raise Exception('Sorry -- this file seems to be malformed.')
 
+def read_rng_state(ub, api_version):
+    seed = ub.next_vint()
+    d = read_an_rng_state(ub)
+    d['rng_seed'] = seed
+
+    # Since API version 2, each storage's random number stream follows
+    streams = []
+    if api_version >= 2:
+        for i in range(ub.next_vint()):
+            streams.append(read_an_rng_state(ub))
+    return d, {'storage_rngs': streams}
+
+def read_checkpoint_api(ub):
+    api_version, = ub.next_struct('I')
+    if api_version > CHECKPOINT_API:
+        raise Exception('Checkpoint API version %d is newer than this reader (%d).' %
+                        (api_version, CHECKPOINT_API))
+    return {'api_version': api_version}
+
 def read_byte_order(ub):
     bo, = ub.next_struct('I')
     if bo == 17:
@@ -147,12 +167,14 @@ def read_species(ub):
         species[species_id] = species_name
     return {'species': species}
 
-def read_scheduler(ub, spec):
+def read_scheduler(ub, spec, api_version):
     num_molecules = ub.next_vint()
     molecules = []
     for i in range(num_molecules):
         species = ub.next_vint()
         newbie = ub.next_byte()
+        if api_version >= 1:
+            change = ub.next_byte()
         t, t2, bday, x, y, z = ub.next_struct('dddddd')
         orient = ub.next_svint()
         cmplx  = ub.next_vint()
@@ -175,7 +197,7 @@ def read_scheduler(ub, spec):
 
 def read_file(fname):
     ub = UnmarshalBuffer(open(fname, 'rb').read())
-    data = {}
+    data = {'api_version': 0}
     while not ub.at_end():
         cmd = ub.next_byte()
         if cmd == CMD_CURRENT_TIME:
@@ -185,15 +207,18 @@ def read_file(fname):
         elif cmd == CMD_CHKPT_SEQ_NUM:
             d = read_chkpt_sequence(ub)
         elif cmd == CMD_RNG_STATE:
-            d = read_rng_state(ub)
+            d, streams = read_rng_state(ub, data['api_version'])
+            data.update(streams)
         elif cmd == CMD_MCELL_VERSION:
             d = read_mcell_version(ub)
         elif cmd == CMD_SPECIES_TABLE:
             d = read_species(ub)
         elif cmd == CMD_SCHEDULER_STATE:
-            d = read_scheduler(ub, data['species'])
+            d = read_scheduler(ub, data['species'], data['api_version'])
         elif cmd == CMD_BYTE_ORDER:
             d = read_byte_order(ub)
+        elif cmd == CMD_CHECKPOINT_API:
+            d = read_checkpoint_api(ub)
         else:
             raise Exception('Unknown command %02x in file.  Perhaps the file is malformed.' % cmd)
         data.update(d)
@@ -203,6 +228,7 @@ def dump_data(data):
     ORIENTS = ['-', '_', '+']
     print '  MCell version:     %s'    % data['mcell_version']
     print '  File endianness:   %s'    % data['endian']
+    print '  API version:       %d'    % data['api_version']
     print '  Cur time:          %.15g' % data['cur_time']
     print '  Start iteration:   %ld'   % data['start_time']
     print '  Real time:         %.15g' % data['real_time']
@@ -211,6 +237,7 @@ def dump_data(data):
     rng_keys.sort()
     for d in rng_keys:
         print '  %s: %*s         %s'    % (d, 8-len(d), '', str(data[d]))
+    print '  Storage RNGs:      %d'    % len(data.get('storage_rngs', []))
     print '  Species:'
 
     species_table = data['species']
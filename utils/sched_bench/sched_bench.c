@@ -0,0 +1,154 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2006-2015 by
+ * The Salk Institute for Biological Studies and
+ * Pittsburgh Supercomputing Center, Carnegie Mellon University
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ *
+******************************************************************************/
+
+/* Insert/advance throughput of the scheduler in sched_util.c.
+ *
+ * Usage: sched_bench [n_items [item_bytes [horizon]]]
+ *
+ * n_items items of item_bytes bytes (default 10^6 items of 64 bytes) are
+ * scheduled at random times in [0, horizon) iterations (default 1000), in
+ * random memory order, on a scheduler set up as for a storage's timer.  The
+ * scheduler is then drained with schedule_next.  Only the public scheduler
+ * interface is used, so the same driver builds against any revision of
+ * sched_util.c (see the Makefile). */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "sched_util.h"
+
+/*************************************************************************
+next_random:
+  In: state of a xorshift64* generator
+  Out: the next 64 random bits
+*************************************************************************/
+static unsigned long long next_random(unsigned long long *state) {
+  *state ^= *state >> 12;
+  *state ^= *state << 25;
+  *state ^= *state >> 27;
+  return *state * 2685821657736338717ULL;
+}
+
+/*************************************************************************
+seconds:
+  In: nothing
+  Out: monotonic wall-clock time in seconds
+*************************************************************************/
+static double seconds(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+int main(int argc, char **argv) {
+  long n_items = (argc > 1) ? (long)atof(argv[1]) : 1000000;
+  size_t item_bytes = (argc > 2) ? (size_t)atol(argv[2]) : 64;
+  double horizon = (argc > 3) ? atof(argv[3]) : 1000.0;
+  unsigned long long rng = 0x9e3779b97f4a7c15ULL;
+
+  if (n_items < 1 || horizon <= 0.0 ||
+      item_bytes < sizeof(struct abstract_element)) {
+    fprintf(stderr, "Usage: %s [n_items [item_bytes [horizon]]]\n"
+                    "  item_bytes must be at least %lu\n",
+            argv[0], (unsigned long)sizeof(struct abstract_element));
+    return 2;
+  }
+  item_bytes = (item_bytes + 7) & ~(size_t)7;
+
+  char *items = (char *)malloc(n_items * item_bytes);
+  long *order = (long *)malloc(n_items * sizeof(long));
+  if (items == NULL || order == NULL) {
+    fprintf(stderr, "Out of memory for %ld items\n", n_items);
+    return 1;
+  }
+  memset(items, 0, n_items * item_bytes);
+
+  /* Visit the items in random memory order, as molecules scattered over
+   * mem_helper blocks would be */
+  for (long i = 0; i < n_items; i++)
+    order[i] = i;
+  for (long i = n_items - 1; i > 0; i--) {
+    long j = (long)(next_random(&rng) % (unsigned long long)(i + 1));
+    long k = order[i];
+    order[i] = order[j];
+    order[j] = k;
+  }
+  for (long i = 0; i < n_items; i++) {
+    struct abstract_element *ae =
+        (struct abstract_element *)(items + order[i] * item_bytes);
+    ae->t = horizon * (next_random(&rng) >> 11) * (1.0 / 9007199254740992.0);
+  }
+
+  struct schedule_helper *sh = create_scheduler(1.0, 100.0, 100, 0.0);
+  if (sh == NULL) {
+    fprintf(stderr, "Out of memory creating the scheduler\n");
+    return 1;
+  }
+
+  double t0 = seconds();
+  for (long i = 0; i < n_items; i++) {
+    if (schedule_add(sh, items + order[i] * item_bytes)) {
+      fprintf(stderr, "Out of memory scheduling item %ld\n", i);
+      return 1;
+    }
+  }
+  double t1 = seconds();
+
+  /* Items of one iteration come out in any order, but iterations must come
+   * out in order */
+  long n_done = 0, n_misordered = 0;
+  double last_step = 0.0, checksum = 0.0;
+  while (n_done < n_items) {
+    struct abstract_element *ae =
+        (struct abstract_element *)schedule_next(sh);
+    if (ae == NULL) {
+      if (sh->error) {
+        fprintf(stderr, "Out of memory advancing the scheduler\n");
+        return 1;
+      }
+      continue;
+    }
+    if (floor(ae->t) < last_step)
+      n_misordered++;
+    last_step = floor(ae->t);
+    checksum += ae->t;
+    n_done++;
+  }
+  double t2 = seconds();
+
+  printf("%ld items of %lu bytes over %g iterations\n", n_items,
+         (unsigned long)item_bytes, horizon);
+  printf("  insert:  %8.3f s  %8.2f M items/s\n", t1 - t0,
+         1e-6 * n_items / (t1 - t0));
+  printf("  advance: %8.3f s  %8.2f M items/s\n", t2 - t1,
+         1e-6 * n_items / (t2 - t1));
+  printf("  checksum %.6e, %ld out of order\n", checksum, n_misordered);
+
+  delete_scheduler(sh);
+  free(order);
+  free(items);
+  return (n_misordered == 0) ? 0 : 1;
+}